@@ -0,0 +1,148 @@
+/**
+ * @brief Benchmark for the AST store, parses a large synthetic program, and
+ *        compares walking the pointer linked tree against walking the same
+ *        tree in an AST store, both by following indices and as a linear
+ *        scan of the array.
+ */
+
+#include "../inc/arena.h"
+#include "../inc/ast_funcs.h"
+#include "../inc/intern.h"
+#include "../inc/parser.h"
+#include "../inc/utils.h"
+#include "ast_store.h"
+#include <time.h>
+
+#define TERM_BUF_SIZE 32
+#define TERM_COUNT 32
+#define WALK_REPEAT 20
+
+static double elapsed_ns(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 +
+           (end->tv_nsec - start->tv_nsec);
+}
+
+// Generates `stmt_count` declarations, each initialized with an expression of
+// `TERM_COUNT` terms over the previous ones.
+static char *gen_program(long stmt_count) {
+    size_t size = stmt_count * TERM_COUNT * TERM_BUF_SIZE;
+    char *src = (char *)malloc(size + 1);
+    CHECK_NULL(src, "Unable to allocate memory for the source", NULL);
+
+    size_t used = snprintf(src, size, "int: v0 := 1\n");
+    for (long i = 1; i < stmt_count; i++) {
+        used +=
+            snprintf(src + used, size - used, "int: v%ld := v%ld", i, i - 1);
+        for (long j = 1; j < TERM_COUNT; j++)
+            used += snprintf(src + used, size - used, " %s %ld",
+                             j % 3 == 0 ? "*" : (j % 3 == 1 ? "+" : "<<"),
+                             (i + j) % 13);
+        used += snprintf(src + used, size - used, "\n");
+    }
+    src[used] = '\0';
+    return src;
+}
+
+// Every walk visits every node, and sums up the integers, so that the
+// compiler can't drop them. Index `0` is the root, and also means "no node",
+// so the store walk starts from the children of the root.
+static long walk_tree(const AstNode *node) {
+    long sum = 0;
+    for (; node != NULL; node = node->next_child) {
+        if (node->type == TYPE_INT)
+            sum += node->ast_val.val;
+        sum += 1 + walk_tree(node->child);
+    }
+    return sum;
+}
+
+static long walk_store(const AstStore *store, AstIndex idx) {
+    long sum = 0;
+    for (; idx != AST_INDEX_NONE; idx = store->nodes[idx].next_child) {
+        const AstStoreNode *node = &store->nodes[idx];
+        if (node->type == TYPE_INT)
+            sum += node->ast_val.val;
+        sum += 1 + walk_store(store, node->child);
+    }
+    return sum;
+}
+
+static long scan_store(const AstStore *store) {
+    long sum = 0;
+    for (AstIndex idx = 0; idx < store->node_count; idx++) {
+        const AstStoreNode *node = &store->nodes[idx];
+        if (node->type == TYPE_INT)
+            sum += node->ast_val.val;
+        sum += 1;
+    }
+    return sum;
+}
+
+static void bench_ast(long stmt_count) {
+    char *src = gen_program(stmt_count);
+
+    Arena *arena = arena_create(0);
+    arena_set_current(arena);
+    AstNode *program = node_alloc();
+    program->type = TYPE_PROGRAM;
+    ParsingContext *context = create_default_parsing_context();
+    lex_and_parse(src, &context, &program);
+
+    struct timespec start, end;
+    AstStore store;
+    ast_store_init(&store);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ast_store_from_tree(&store, program);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double build_ns = elapsed_ns(&start, &end);
+    long node_count = store.node_count;
+
+    long tree_sum = 0, store_sum = 0, scan_sum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < WALK_REPEAT; i++)
+        tree_sum += walk_tree(program);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double tree_ns = elapsed_ns(&start, &end) / WALK_REPEAT;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < WALK_REPEAT; i++)
+        store_sum += 1 + walk_store(&store, store.nodes[0].child);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double store_ns = elapsed_ns(&start, &end) / WALK_REPEAT;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < WALK_REPEAT; i++)
+        scan_sum += scan_store(&store);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double scan_ns = elapsed_ns(&start, &end) / WALK_REPEAT;
+
+    if (tree_sum != store_sum || tree_sum != scan_sum)
+        print_error(ERR_DEV, "AST store doesn't match the tree");
+
+    printf("%10ld %8zu %8zu %10.2f %10.2f %10.2f %10.2f\n", node_count,
+           sizeof(AstNode), sizeof(AstStoreNode), build_ns / node_count,
+           tree_ns / node_count, store_ns / node_count,
+           scan_ns / node_count);
+
+    ast_store_destroy(&store);
+    arena_destroy(arena);
+    free(src);
+}
+
+int main(int argc, char **argv) {
+    long max_count = 4000;
+    if (argc > 1)
+        max_count = strtol(argv[1], NULL, 10);
+
+    intern_init();
+
+    printf("%10s %8s %8s %10s %10s %10s %10s\n", "NODES", "B/TREE", "B/STORE",
+           "BUILD", "TREE WALK", "STORE WALK", "SCAN");
+    printf("%10s %8s %8s %10s %10s %10s %10s\n", "", "", "", "(ns/node)",
+           "(ns/node)", "(ns/node)", "(ns/node)");
+    for (long stmt_count = 250; stmt_count <= max_count; stmt_count *= 4)
+        bench_ast(stmt_count);
+
+    intern_destroy();
+    return 0;
+}
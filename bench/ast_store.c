@@ -0,0 +1,116 @@
+#include "ast_store.h"
+#include "../inc/utils.h"
+
+void ast_store_init(AstStore *store) {
+    store->nodes = NULL;
+    store->node_count = 0;
+    store->nodes_size = 0;
+}
+
+AstIndex ast_store_push(AstStore *store) {
+    if (store->node_count == store->nodes_size) {
+        if (store->nodes_size > UINT32_MAX / 2)
+            print_error(ERR_MEM, "Too many nodes for the AST store");
+        store->nodes_size = store->nodes_size == 0 ? AST_STORE_INIT_SIZE
+                                                   : store->nodes_size * 2;
+        store->nodes = (AstStoreNode *)realloc(
+            store->nodes, store->nodes_size * sizeof(AstStoreNode));
+        CHECK_NULL(store->nodes, "Unable to allocate memory for the AST store",
+                   NULL);
+    }
+    AstIndex idx = store->node_count++;
+    memset(&store->nodes[idx], 0, sizeof(AstStoreNode));
+    return idx;
+}
+
+static void ast_store_copy_node(AstStoreNode *dst, const AstNode *src) {
+    dst->type = src->type;
+    if (src->pointer_level > UINT16_MAX)
+        print_error(ERR_MEM, "Pointer level too deep for the AST store : %u",
+                    src->pointer_level);
+    dst->pointer_level = src->pointer_level;
+
+    switch (src->type) {
+    case TYPE_INT:
+    case TYPE_ARR_INDEX:
+        dst->ast_val.val = src->ast_val.val;
+        break;
+    case TYPE_BINARY_OPERATOR:
+        dst->op = src->ast_val.val;
+        dst->ast_val.node_symbol = src->ast_val.node_symbol;
+        break;
+    default:
+        dst->ast_val.node_symbol = src->ast_val.node_symbol;
+        break;
+    }
+}
+
+// A node that is waiting to be copied, along with the node in the store,
+// whose `child` or `next_child` needs to point at it.
+typedef struct PendingNode {
+    const AstNode *node;
+    AstIndex link_idx;
+    int is_child_link;
+} PendingNode;
+
+AstIndex ast_store_from_tree(AstStore *store, const AstNode *root) {
+    if (store->node_count != 0)
+        print_error(ERR_DEV, "AST store must be empty before adding a tree");
+
+    size_t pending_size = 64;
+    size_t pending_used = 0;
+    PendingNode *pending =
+        (PendingNode *)malloc(pending_size * sizeof(PendingNode));
+    CHECK_NULL(pending, "Unable to allocate memory for the AST store", NULL);
+
+    pending[pending_used++] = (PendingNode){root, AST_INDEX_NONE, 0};
+
+    while (pending_used != 0) {
+        PendingNode curr = pending[--pending_used];
+        AstIndex idx = ast_store_push(store);
+        if (idx != 0) {
+            if (curr.is_child_link)
+                store->nodes[curr.link_idx].child = idx;
+            else
+                store->nodes[curr.link_idx].next_child = idx;
+        }
+        ast_store_copy_node(&store->nodes[idx], curr.node);
+
+        if (pending_used + 2 > pending_size) {
+            pending_size *= 2;
+            pending = (PendingNode *)realloc(
+                pending, pending_size * sizeof(PendingNode));
+            CHECK_NULL(pending, "Unable to allocate memory for the AST store",
+                       NULL);
+        }
+
+        // The sibling is pushed first, so that the whole subtree of this node
+        // is copied before it, which gives the pre-order layout. Siblings of
+        // the root don't belong to the tree.
+        if (curr.node->next_child != NULL && idx != 0)
+            pending[pending_used++] =
+                (PendingNode){curr.node->next_child, idx, 0};
+        if (curr.node->child != NULL)
+            pending[pending_used++] = (PendingNode){curr.node->child, idx, 1};
+    }
+    free(pending);
+
+    // Children always come after their parent, so walking backwards sees
+    // the end of every child's subtree before the parent needs it.
+    for (AstIndex idx = store->node_count; idx-- > 0;) {
+        AstStoreNode *node = &store->nodes[idx];
+        node->subtree_end = idx + 1;
+        AstIndex child = node->child;
+        while (child != AST_INDEX_NONE) {
+            node->subtree_end = store->nodes[child].subtree_end;
+            child = store->nodes[child].next_child;
+        }
+    }
+
+    return 0;
+}
+
+void ast_store_destroy(AstStore *store) {
+    free(store->nodes);
+    ast_store_init(store);
+}
@@ -0,0 +1,88 @@
+#ifndef __AST_STORE_H__
+#define __AST_STORE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../inc/parser.h"
+#include <stdint.h>
+
+/**
+ * @brief Initial number of nodes in an AST store.
+ */
+#define AST_STORE_INIT_SIZE 1024
+
+/**
+ * @brief Index of a node in an AST store. The root is always stored at index
+ *        `0`, and is never a child, or a sibling, so `0` doubles as "no node".
+ */
+typedef uint32_t AstIndex;
+
+#define AST_INDEX_NONE ((AstIndex)0)
+
+/**
+ * @brief Structure defining a node in an AST store, i.e. a compact copy of an
+ *        `AstNode`, that is linked to its relatives by index.
+ */
+typedef struct AstStoreNode {
+    uint8_t type;           ///< Enum for the type of the node.
+    uint8_t op;             ///< `BinaryOp` for binary operator nodes.
+    uint16_t pointer_level; ///< Indirection level for a pointer.
+    AstIndex child;         ///< Index of the first child.
+    AstIndex next_child;    ///< Index of the next sibling.
+    AstIndex subtree_end;   ///< Index just past the last node of the subtree.
+    union {
+        long val;          ///< Value for integer, and array index nodes.
+        char *node_symbol; ///< Interned symbol for every other node.
+    } ast_val;
+} AstStoreNode;
+
+/**
+ * @brief Structure defining an AST store. Nodes are laid out in pre-order,
+ *        so every subtree is a contiguous range of the array, and a pass
+ *        that doesn't care about the shape of the tree is a linear scan.
+ */
+typedef struct AstStore {
+    AstStoreNode *nodes;  ///< Array of nodes.
+    uint32_t node_count;  ///< Number of nodes in use.
+    uint32_t nodes_size;  ///< Number of nodes allocated.
+} AstStore;
+
+/**
+ * @brief Initializes an empty AST store.
+ *
+ * @param store [`AstStore *`] Pointer to the store.
+ */
+void ast_store_init(AstStore *store);
+
+/**
+ * @brief  Appends a zeroed node to the store.
+ *
+ * @param  store    [`AstStore *`] Pointer to the store.
+ * @return AstIndex Index of the new node.
+ */
+AstIndex ast_store_push(AstStore *store);
+
+/**
+ * @brief  Copies a tree into the store, the tree is walked without recursion,
+ *         so deep trees are fine.
+ *
+ * @param  store    [`AstStore *`] Pointer to an empty store.
+ * @param  root     [`const AstNode *`] Pointer to the root of the tree.
+ * @return AstIndex Index of the root, i.e. `0`.
+ */
+AstIndex ast_store_from_tree(AstStore *store, const AstNode *root);
+
+/**
+ * @brief Releases the nodes of the store.
+ *
+ * @param store [`AstStore *`] Pointer to the store.
+ */
+void ast_store_destroy(AstStore *store);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AST_STORE_H__ */
@@ -0,0 +1,144 @@
+/**
+ * @brief Benchmark for building the AST, and the context tree, parses
+ *        programs of `N` statements, for a growing `N`, up to a million. The
+ *        time per statement should stay flat as `N` grows, i.e. appending a
+ *        statement, or a context must not walk the ones before it.
+ *
+ *        Usage: build_bench [MAX_STATEMENTS]
+ */
+
+#include "../inc/arena.h"
+#include "../inc/ast_funcs.h"
+#include "../inc/intern.h"
+#include "../inc/out_buf.h"
+#include "../inc/parser.h"
+#include "../inc/utils.h"
+#include <math.h>
+#include <time.h>
+
+#define MAX_STEPS 16
+#define SUPERLINEAR_EXPONENT 1.25
+
+typedef void (*GenFunc)(OutBuf *src, long stmt_count);
+
+// Statements at the top level of the program.
+static void gen_globals(OutBuf *src, long stmt_count) {
+    for (long i = 0; i < stmt_count; i++)
+        out_buf_printf(src, "int: g%ld := %ld\n", i, i % 100);
+}
+
+// Statements in the body of a single function.
+static void gen_body(OutBuf *src, long stmt_count) {
+    out_buf_str(src, "int: f() := int: () {\n");
+    for (long i = 0; i < stmt_count; i++)
+        out_buf_printf(src, "%ld\n", i % 100);
+    out_buf_str(src, "}\n");
+}
+
+// If expressions at the top level, each making a context of its own.
+static void gen_ifs(OutBuf *src, long stmt_count) {
+    out_buf_str(src, "int: x := 1\n");
+    for (long i = 0; i < stmt_count; i++)
+        out_buf_printf(src, "if x > 0 { %ld }\n", i % 100);
+}
+
+typedef struct ProgramKind {
+    const char *name;
+    GenFunc gen;
+} ProgramKind;
+
+static const ProgramKind program_kinds[] = {
+    {"globals", gen_globals},
+    {"body", gen_body},
+    {"ifs", gen_ifs},
+};
+
+#define PROGRAM_KIND_COUNT                                                     \
+    (sizeof(program_kinds) / sizeof(program_kinds[0]))
+
+static double elapsed_ns(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 +
+           (end->tv_nsec - start->tv_nsec);
+}
+
+// Least squares fit of `log(time) = k * log(count) + c`, returns `k`.
+static double fit_exponent(const double *count, const double *ns, int steps) {
+    double sum_x = 0, sum_y = 0, sum_xx = 0, sum_xy = 0;
+    for (int i = 0; i < steps; i++) {
+        double x = log(count[i]);
+        double y = log(ns[i]);
+        sum_x += x;
+        sum_y += y;
+        sum_xx += x * x;
+        sum_xy += x * y;
+    }
+    return (steps * sum_xy - sum_x * sum_y) / (steps * sum_xx - sum_x * sum_x);
+}
+
+static double bench_build(const ProgramKind *kind, long stmt_count) {
+    OutBuf *src_out = out_buf_create_mem();
+    kind->gen(src_out, stmt_count);
+    size_t src_len = 0;
+    char *src = out_buf_release(src_out, &src_len);
+
+    Arena *arena = arena_create(0);
+    arena_set_current(arena);
+    AstNode *program = node_alloc();
+    program->type = TYPE_PROGRAM;
+    ParsingContext *context = create_default_parsing_context();
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    lex_and_parse(src, &context, &program);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double ns = elapsed_ns(&start, &end);
+    printf("%-10s %10ld %14.1f %12.3f %14zu\n", "", stmt_count,
+           ns / stmt_count, ns / 1e6, arena->bytes_used / stmt_count);
+
+    arena_destroy(arena);
+    free(src);
+    return ns;
+}
+
+int main(int argc, char **argv) {
+    long max_count = 1000000;
+    if (argc > 1)
+        max_count = strtol(argv[1], NULL, 10);
+
+    intern_init();
+
+    int superlinear_count = 0;
+    for (size_t k = 0; k < PROGRAM_KIND_COUNT; k++) {
+        const ProgramKind *kind = &program_kinds[k];
+        double count[MAX_STEPS], ns[MAX_STEPS];
+        int steps = 0;
+
+        printf("%-10s %10s %14s %12s %14s\n", kind->name, "STATEMENTS",
+               "TIME (ns/stmt)", "TOTAL (ms)", "BYTES/STMT");
+        for (long stmt_count = 1000;
+             stmt_count <= max_count && steps < MAX_STEPS;
+             stmt_count *= 10, steps++) {
+            count[steps] = stmt_count;
+            ns[steps] = bench_build(kind, stmt_count);
+        }
+        if (steps < 2) {
+            printf("\n");
+            continue;
+        }
+
+        double exponent = fit_exponent(count, ns, steps);
+        char is_superlinear = exponent > SUPERLINEAR_EXPONENT;
+        superlinear_count += is_superlinear;
+        printf("%-10s time ~ statements^%.2f%s\n\n", "", exponent,
+               is_superlinear ? "  <-- SUPERLINEAR" : "");
+    }
+
+    intern_destroy();
+    if (superlinear_count != 0) {
+        printf("%d of %zu program kinds build superlinearly\n",
+               superlinear_count, PROGRAM_KIND_COUNT);
+        return 1;
+    }
+    return 0;
+}
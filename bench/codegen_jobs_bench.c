@@ -0,0 +1,81 @@
+/**
+ * @brief Benchmark for parallel code generation, generates code for a
+ *        program of many functions into `/dev/null`, with a growing number
+ *        of jobs. The output is identical for any number of jobs, so only
+ *        the time taken changes.
+ */
+
+#include "../inc/arena.h"
+#include "../inc/ast_funcs.h"
+#include "../inc/code_gen.h"
+#include "../inc/intern.h"
+#include "../inc/parser.h"
+#include "../inc/utils.h"
+#include <time.h>
+#include <unistd.h>
+
+#define TERM_BUF_SIZE 32
+#define TERM_COUNT 200
+
+static double elapsed_ns(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 +
+           (end->tv_nsec - start->tv_nsec);
+}
+
+// Generates `func_count` functions, each returning an expression of
+// `TERM_COUNT` terms over its parameter.
+static char *gen_program(long func_count) {
+    size_t size = func_count * (TERM_COUNT + 1) * TERM_BUF_SIZE;
+    char *src = (char *)malloc(size + 1);
+    CHECK_NULL(src, "Unable to allocate memory for the source", NULL);
+
+    size_t used = 0;
+    for (long i = 0; i < func_count; i++) {
+        used += snprintf(src + used, size - used, "int: (int: a) { a");
+        for (long j = 1; j < TERM_COUNT; j++)
+            used += snprintf(src + used, size - used, " %s %ld",
+                             j % 2 == 0 ? "+" : "-", (i + j) % 13);
+        used += snprintf(src + used, size - used, " }\n");
+    }
+    src[used] = '\0';
+    return src;
+}
+
+int main(int argc, char **argv) {
+    long func_count = 2000;
+    if (argc > 1)
+        func_count = strtol(argv[1], NULL, 10);
+
+    intern_init();
+    char *src = gen_program(func_count);
+    Arena *arena = arena_create(0);
+    arena_set_current(arena);
+    AstNode *program = node_alloc();
+    program->type = TYPE_PROGRAM;
+    ParsingContext *context = create_default_parsing_context();
+    lex_and_parse(src, &context, &program);
+
+    printf("%ld functions, %ld cpus online\n", func_count,
+           sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%6s %12s %10s\n", "JOBS", "CODEGEN", "SPEEDUP");
+    printf("%6s %12s %10s\n", "", "(ms)", "");
+    double serial_ns = 0;
+    for (int jobs = 1; jobs <= 8; jobs *= 2) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        target_codegen(context, program, "/dev/null", TARGET_FMT_DEFAULT,
+                       TARGET_ASM_DIALECT_DEFAULT, TARGET_CALL_CONV_DEFAULT,
+                       jobs, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double ns = elapsed_ns(&start, &end);
+        if (jobs == 1)
+            serial_ns = ns;
+        printf("%6d %12.3f %10.2f\n", jobs, ns / 1e6, serial_ns / ns);
+    }
+
+    arena_destroy(arena);
+    free(src);
+    intern_destroy();
+    return 0;
+}
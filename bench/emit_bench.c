@@ -0,0 +1,135 @@
+/**
+ * @brief Benchmark for emitting assembly, formats the same instruction lines
+ *        with `fprintf()`, and through an output buffer, both into
+ *        `/dev/null`. Then times code generation for a large synthetic
+ *        program into `/dev/null`.
+ */
+
+#include "../inc/arena.h"
+#include "../inc/ast_funcs.h"
+#include "../inc/code_gen.h"
+#include "../inc/intern.h"
+#include "../inc/out_buf.h"
+#include "../inc/parser.h"
+#include "../inc/utils.h"
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LINE_COUNT 2000000
+#define TERM_BUF_SIZE 32
+#define STMT_COUNT 4
+
+static double elapsed_ns(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 +
+           (end->tv_nsec - start->tv_nsec);
+}
+
+static const char *bench_regs[] = {"rax", "rcx", "rdx", "r8"};
+static const OutStr bench_reg_operands[] = {
+    OUT_STR("%rax"), OUT_STR("%rcx"), OUT_STR("%rdx"), OUT_STR("%r8")};
+static const OutStr bench_mnemonic = OUT_STR("mov");
+
+// Emits `mov -offset(%rbp), %reg` lines, the most common line in the output.
+static double bench_fprintf(FILE *fptr) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < LINE_COUNT; i++)
+        fprintf(fptr, "%s %ld(%%%s), %%%s\n", "mov", -8 * (i & 63), "rbp",
+                bench_regs[i & 3]);
+    fflush(fptr);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return elapsed_ns(&start, &end) / LINE_COUNT;
+}
+
+static double bench_out_buf(OutBuf *out) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < LINE_COUNT; i++) {
+        out_buf_ostr(out, &bench_mnemonic);
+        out_buf_char(out, ' ');
+        out_buf_int(out, -8 * (i & 63));
+        out_buf_write(out, "(%rbp), ", 8);
+        out_buf_ostr(out, &bench_reg_operands[i & 3]);
+        out_buf_char(out, '\n');
+    }
+    out_buf_flush(out);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return elapsed_ns(&start, &end) / LINE_COUNT;
+}
+
+// Generates `STMT_COUNT` declarations, each initialized with an expression of
+// `term_count` terms over the previous ones. Registers for top level
+// statements aren't released, so the program grows by the length of its
+// expressions, rather than the number of statements.
+static char *gen_program(long term_count) {
+    size_t size = STMT_COUNT * term_count * TERM_BUF_SIZE;
+    char *src = (char *)malloc(size + 1);
+    CHECK_NULL(src, "Unable to allocate memory for the source", NULL);
+
+    size_t used = snprintf(src, size, "int: v0 := 1\n");
+    for (long i = 1; i < STMT_COUNT; i++) {
+        used +=
+            snprintf(src + used, size - used, "int: v%ld := v%ld", i, i - 1);
+        for (long j = 1; j < term_count; j++)
+            used += snprintf(src + used, size - used, " %s %ld",
+                             j % 2 == 0 ? "+" : "-", (i + j) % 13);
+        used += snprintf(src + used, size - used, "\n");
+    }
+    src[used] = '\0';
+    return src;
+}
+
+static void bench_codegen(long term_count) {
+    char *src = gen_program(term_count);
+
+    Arena *arena = arena_create(0);
+    arena_set_current(arena);
+    AstNode *program = node_alloc();
+    program->type = TYPE_PROGRAM;
+    ParsingContext *context = create_default_parsing_context();
+    lex_and_parse(src, &context, &program);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    target_codegen(context, program, "/dev/null", TARGET_FMT_DEFAULT,
+                   TARGET_ASM_DIALECT_DEFAULT, TARGET_CALL_CONV_DEFAULT, 1,
+                   NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    printf("%10ld %12.2f\n", STMT_COUNT * term_count,
+           elapsed_ns(&start, &end) / (STMT_COUNT * term_count));
+
+    arena_destroy(arena);
+    free(src);
+}
+
+int main(int argc, char **argv) {
+    long max_count = 16000;
+    if (argc > 1)
+        max_count = strtol(argv[1], NULL, 10);
+
+    FILE *fptr = fopen("/dev/null", "w");
+    int fd = open("/dev/null", O_WRONLY);
+    if (fptr == NULL || fd < 0)
+        print_error(ERR_FILE_OPEN, "Unable to open : `/dev/null`");
+
+    OutBuf *out = out_buf_create_fd(fd);
+    printf("%10s %12s %12s\n", "LINES", "FPRINTF", "OUT_BUF");
+    printf("%10s %12s %12s\n", "", "(ns/line)", "(ns/line)");
+    printf("%10d %12.2f %12.2f\n", LINE_COUNT, bench_fprintf(fptr),
+           bench_out_buf(out));
+    printf("out_buf : %zu bytes in %zu writes\n\n", out->bytes_flushed,
+           out->flush_count);
+    out_buf_destroy(out);
+    close(fd);
+    fclose(fptr);
+
+    intern_init();
+    printf("%10s %12s\n", "TERMS", "CODEGEN");
+    printf("%10s %12s\n", "", "(ns/term)");
+    for (long term_count = 250; term_count <= max_count; term_count *= 4)
+        bench_codegen(term_count);
+    intern_destroy();
+    return 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * @brief Benchmark for the environment, binds `N` identifiers and looks every
+ *        one of them up again, for a growing `N`. The time per binding should
+ *        stay flat as `N` grows, i.e. the total time must scale linearly.
+ */
+
+#include "../inc/arena.h"
+#include "../inc/ast_funcs.h"
+#include "../inc/env_funcs.h"
+#include "../inc/intern.h"
+#include "../inc/utils.h"
+#include <time.h>
+
+#define SYM_BUF_SIZE 32
+
+static double elapsed_ns(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 +
+           (end->tv_nsec - start->tv_nsec);
+}
+
+static void bench_env(long bind_count) {
+    Arena *arena = arena_create(0);
+    arena_set_current(arena);
+
+    AstNode **ids = (AstNode **)arena_calloc(bind_count * sizeof(AstNode *));
+    char sym_buf[SYM_BUF_SIZE] = {0};
+    for (long i = 0; i < bind_count; i++) {
+        snprintf(sym_buf, SYM_BUF_SIZE, "var_%ld", i);
+        ids[i] = create_node_symbol(sym_buf);
+    }
+
+    Env *env = create_env(NULL);
+    AstNode *int_type = create_node_symbol(builtin_syms.int_type);
+    struct timespec start, mid, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < bind_count; i++) {
+        if (!set_env(&env, ids[i], int_type))
+            print_error(ERR_COMMON, "Unable to bind : `%s`",
+                        ids[i]->ast_val.node_symbol);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &mid);
+    int stat = -1;
+    for (long i = 0; i < bind_count; i++) {
+        get_env_ref_from_sym(env, ids[i]->ast_val.node_symbol, &stat);
+        if (!stat)
+            print_error(ERR_COMMON, "Unable to find binding for : `%s`",
+                        ids[i]->ast_val.node_symbol);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    printf("%10ld %14.1f %14.1f %12.3f\n", bind_count,
+           elapsed_ns(&start, &mid) / bind_count,
+           elapsed_ns(&mid, &end) / bind_count,
+           elapsed_ns(&start, &end) / 1e6);
+
+    arena_destroy(arena);
+}
+
+int main(int argc, char **argv) {
+    long max_count = 100000;
+    if (argc > 1)
+        max_count = strtol(argv[1], NULL, 10);
+
+    intern_init();
+
+    printf("%10s %14s %14s %12s\n", "BINDINGS", "SET (ns/op)", "GET (ns/op)",
+           "TOTAL (ms)");
+    for (long bind_count = 1000; bind_count <= max_count; bind_count *= 10)
+        bench_env(bind_count);
+
+    intern_destroy();
+    return 0;
+}
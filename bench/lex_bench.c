@@ -0,0 +1,67 @@
+/**
+ * @brief Benchmark for the lexer, generates a source of a few megabytes in
+ *        memory, and times tokenizing all of it into the token array. The
+ *        throughput in tokens/sec should stay flat as the source grows.
+ */
+
+#include "../inc/intern.h"
+#include "../inc/lexer.h"
+#include "../inc/utils.h"
+#include <time.h>
+
+#define LINE_BUF_SIZE 128
+
+static double elapsed_ns(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 +
+           (end->tv_nsec - start->tv_nsec);
+}
+
+// Generates roughly `size` bytes of declarations, and arithmetic over them.
+static char *gen_source(size_t size) {
+    char *src = (char *)malloc(size + LINE_BUF_SIZE);
+    CHECK_NULL(src, "Unable to allocate memory for the source", NULL);
+
+    size_t used = 0;
+    for (long i = 0; used < size; i++) {
+        used += snprintf(src + used, LINE_BUF_SIZE,
+                         "int: var_%ld := var_%ld * %ld + (var_%ld << 2);"
+                         " # comment\n",
+                         i, i / 2, i, i / 3);
+    }
+    src[used] = '\0';
+    return src;
+}
+
+static void bench_lex(size_t size) {
+    char *src = gen_source(size);
+    size_t token_count = 0;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    LexedToken *tokens = lex_file(src, &token_count);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double ns = elapsed_ns(&start, &end);
+    printf("%10zu %12zu %12.3f %14.1f %10.1f\n", size, token_count, ns / 1e6,
+           token_count / (ns / 1e9) / 1e6, size / (ns / 1e9) / (1 << 20));
+
+    err_trap_own(NULL);
+    free(tokens);
+    free(src);
+}
+
+int main(int argc, char **argv) {
+    size_t max_size = 64 << 20;
+    if (argc > 1)
+        max_size = strtoul(argv[1], NULL, 10);
+
+    intern_init();
+
+    printf("%10s %12s %12s %14s %10s\n", "BYTES", "TOKENS", "TIME (ms)",
+           "MTOKENS/SEC", "MB/SEC");
+    for (size_t size = 1 << 20; size <= max_size; size *= 4)
+        bench_lex(size);
+
+    intern_destroy();
+    return 0;
+}
@@ -0,0 +1,200 @@
+/**
+ * @brief Benchmark for compiling many small files, once by running `sypherc`
+ *        for every file, the way a build service would without the library,
+ *        and once through `sypher_compile()`, on one and on several threads.
+ *        The assembly from the library is checked against the one written
+ *        by `sypherc`.
+ *
+ *        Usage: lib_bench <SYPHERC_PATH> [FILE_COUNT]
+ */
+
+#include "../inc/sypherc.h"
+#include <pthread.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SRC_BUF_SIZE 4096
+#define FUNC_COUNT 20
+#define THREAD_COUNT 4
+
+typedef struct BenchFile {
+    char src[SRC_BUF_SIZE];
+    size_t src_len;
+    SypherOutput out;
+} BenchFile;
+
+typedef struct BenchThread {
+    pthread_t thread;
+    BenchFile *files;
+    long start;
+    long end;
+} BenchThread;
+
+static double elapsed_ms(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 +
+           (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// Generates a small program, a handful of functions, globals, and an if
+// expression, varied by `seed`.
+static void gen_file(BenchFile *file, long seed) {
+    size_t used = 0;
+    for (long i = 0; i < FUNC_COUNT; i++)
+        used += snprintf(file->src + used, SRC_BUF_SIZE - used,
+                         "int: f%ld(int: a) := int: (int: a) { a + %ld }\n"
+                         "int: g%ld := f%ld(%ld)\n",
+                         i, (seed + i) % 13, i, i, seed % 7);
+    used += snprintf(file->src + used, SRC_BUF_SIZE - used,
+                     "if g0 > 3 { g1 } else { g%d }\n", FUNC_COUNT - 1);
+    file->src_len = used;
+}
+
+static void compile_files(BenchFile *files, long start, long end) {
+    for (long i = start; i < end; i++)
+        if (sypher_compile(files[i].src, files[i].src_len, NULL,
+                           &files[i].out) != 0)
+            print_error(files[i].out.err, "`sypher_compile()` failed : %s",
+                        files[i].out.err_msg);
+}
+
+static void *compile_thread(void *thread_data) {
+    BenchThread *bench_thread = (BenchThread *)thread_data;
+    compile_files(bench_thread->files, bench_thread->start, bench_thread->end);
+    return NULL;
+}
+
+static void free_outputs(BenchFile *files, long file_count) {
+    for (long i = 0; i < file_count; i++)
+        sypher_output_free(&files[i].out);
+}
+
+// Runs `sypherc` on `src_path`, writing the assembly to `out_path`.
+static void run_sypherc(const char *sypherc, const char *src_path,
+                        const char *out_path) {
+    pid_t pid = fork();
+    if (pid < 0)
+        print_error(ERR_COMMON, "Unable to fork `%s`", sypherc);
+    if (pid == 0) {
+        execl(sypherc, sypherc, src_path, "-o", out_path, (char *)NULL);
+        _exit(127);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        print_error(ERR_COMMON, "`%s` failed on : `%s`", sypherc, src_path);
+}
+
+// Compiles the first file with `sypherc`, and checks that the library
+// generates the same assembly for it.
+static void check_output(const char *sypherc, BenchFile *file,
+                         const char *src_path, const char *out_path) {
+    run_sypherc(sypherc, src_path, out_path);
+    FILE *fptr = fopen(out_path, "r");
+    if (fptr == NULL)
+        print_error(ERR_FILE_OPEN, "Unable to open : `%s`", out_path);
+    size_t size = calculate_file_size(fptr);
+    char *code = (char *)malloc(size + 1);
+    CHECK_NULL(code, "Unable to allocate memory for %s", "the assembly");
+    if (fread(code, 1, size, fptr) != size)
+        print_error(ERR_FILE_READ, "Unable to read : `%s`", out_path);
+    fclose(fptr);
+
+    if (size != file->out.code_len || memcmp(code, file->out.code, size) != 0)
+        print_error(ERR_COMMON, "Assembly from `sypher_compile()` differs "
+                                "from the one written by `sypherc`");
+    free(code);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2)
+        print_error(ERR_ARGS, "Usage: %s <SYPHERC_PATH> [FILE_COUNT]",
+                    argv[0]);
+    const char *sypherc = argv[1];
+    long file_count = argc > 2 ? strtol(argv[2], NULL, 10) : 500;
+    if (file_count < 1) {
+        print_error(ERR_ARGS, "Expected a positive number of files");
+        return 1;
+    }
+
+    BenchFile *files = (BenchFile *)calloc(file_count, sizeof(BenchFile));
+    CHECK_NULL(files, "Unable to allocate memory for %s", "the files");
+    for (long i = 0; i < file_count; i++)
+        gen_file(&files[i], i);
+
+    char src_path[] = "/tmp/lib_bench_XXXXXX.sy";
+    int src_fd = mkstemps(src_path, 3);
+    if (src_fd < 0)
+        print_error(ERR_FILE_OPEN, "Unable to create a temporary source file");
+    close(src_fd);
+    char out_path[] = "/tmp/lib_bench_XXXXXX.s";
+    int out_fd = mkstemps(out_path, 2);
+    if (out_fd < 0)
+        print_error(ERR_FILE_OPEN, "Unable to create a temporary output file");
+    close(out_fd);
+
+    // A process for every file, including writing out the source, which a
+    // build service calling `sypherc` would have to do as well.
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < file_count; i++) {
+        FILE *fptr = fopen(src_path, "w");
+        if (fptr == NULL)
+            print_error(ERR_FILE_OPEN, "Unable to open : `%s`", src_path);
+        fwrite(files[i].src, 1, files[i].src_len, fptr);
+        fclose(fptr);
+        run_sypherc(sypherc, src_path, "/dev/null");
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double fork_ms = elapsed_ms(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    compile_files(files, 0, file_count);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double lib_ms = elapsed_ms(&start, &end);
+
+    // The source file holds the last file by now, so the first one is
+    // written out again, to check its assembly.
+    FILE *fptr = fopen(src_path, "w");
+    if (fptr == NULL)
+        print_error(ERR_FILE_OPEN, "Unable to open : `%s`", src_path);
+    fwrite(files[0].src, 1, files[0].src_len, fptr);
+    fclose(fptr);
+    check_output(sypherc, &files[0], src_path, out_path);
+    free_outputs(files, file_count);
+
+    BenchThread threads[THREAD_COUNT];
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < THREAD_COUNT; i++) {
+        threads[i].files = files;
+        threads[i].start = file_count * i / THREAD_COUNT;
+        threads[i].end = file_count * (i + 1) / THREAD_COUNT;
+        pthread_create(&threads[i].thread, NULL, compile_thread, &threads[i]);
+    }
+    for (long i = 0; i < THREAD_COUNT; i++)
+        pthread_join(threads[i].thread, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double threads_ms = elapsed_ms(&start, &end);
+    check_output(sypherc, &files[0], src_path, out_path);
+    free_outputs(files, file_count);
+
+    unlink(src_path);
+    unlink(out_path);
+
+    size_t total_bytes = 0;
+    for (long i = 0; i < file_count; i++)
+        total_bytes += files[i].src_len;
+    printf("%ld files, %zu bytes each on average\n", file_count,
+           total_bytes / file_count);
+    printf("%-22s %12s %12s %10s\n", "", "TOTAL (ms)", "PER FILE (us)",
+           "SPEEDUP");
+    printf("%-22s %12.3f %12.2f %10s\n", "fork/exec sypherc", fork_ms,
+           fork_ms * 1e3 / file_count, "1.00x");
+    printf("%-22s %12.3f %12.2f %9.2fx\n", "sypher_compile()", lib_ms,
+           lib_ms * 1e3 / file_count, fork_ms / lib_ms);
+    printf("sypher_compile() x %-3d %12.3f %12.2f %9.2fx\n", THREAD_COUNT,
+           threads_ms, threads_ms * 1e3 / file_count, fork_ms / threads_ms);
+
+    free(files);
+    return 0;
+}
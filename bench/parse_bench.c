@@ -0,0 +1,78 @@
+/**
+ * @brief Benchmark for the expression parser, parses a single expression of
+ *        `N` terms, for a growing `N`. The time per term should stay flat as
+ *        `N` grows, i.e. long operator chains must parse in linear time.
+ */
+
+#include "../inc/arena.h"
+#include "../inc/ast_funcs.h"
+#include "../inc/intern.h"
+#include "../inc/parser.h"
+#include "../inc/utils.h"
+#include <time.h>
+
+#define TERM_BUF_SIZE 32
+
+static double elapsed_ns(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 +
+           (end->tv_nsec - start->tv_nsec);
+}
+
+// Generates an expression of `term_count` terms, joined by the operators in
+// `ops`, which are used in turn.
+static char *gen_expr(long term_count, const char **ops, int op_count) {
+    size_t size = term_count * TERM_BUF_SIZE;
+    char *src = (char *)malloc(size + 1);
+    CHECK_NULL(src, "Unable to allocate memory for the source", NULL);
+
+    size_t used = snprintf(src, size, "1");
+    for (long i = 1; i < term_count; i++)
+        used += snprintf(src + used, size - used, " %s %ld", ops[i % op_count],
+                         i % 97 + 1);
+    src[used] = '\0';
+    return src;
+}
+
+static void bench_parse(const char *name, long term_count, const char **ops,
+                        int op_count) {
+    char *src = gen_expr(term_count, ops, op_count);
+
+    Arena *arena = arena_create(0);
+    arena_set_current(arena);
+    AstNode *program = node_alloc();
+    program->type = TYPE_PROGRAM;
+    ParsingContext *context = create_default_parsing_context();
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    lex_and_parse(src, &context, &program);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double ns = elapsed_ns(&start, &end);
+    printf("%-12s %10ld %14.1f %12.3f %14zu\n", name, term_count,
+           ns / term_count, ns / 1e6, arena->bytes_used / term_count);
+
+    arena_destroy(arena);
+    free(src);
+}
+
+int main(int argc, char **argv) {
+    long max_count = 100000;
+    if (argc > 1)
+        max_count = strtol(argv[1], NULL, 10);
+
+    const char *add_ops[] = {"+"};
+    const char *mixed_ops[] = {"+", "*", "-", "<<", "%", "<", "/", ">>"};
+
+    intern_init();
+
+    printf("%-12s %10s %14s %12s %14s\n", "EXPRESSION", "TERMS",
+           "TIME (ns/term)", "TOTAL (ms)", "BYTES/TERM");
+    for (long term_count = 1000; term_count <= max_count; term_count *= 10)
+        bench_parse("chain (+)", term_count, add_ops, 1);
+    for (long term_count = 1000; term_count <= max_count; term_count *= 10)
+        bench_parse("mixed", term_count, mixed_ops, 8);
+
+    intern_destroy();
+    return 0;
+}
@@ -0,0 +1,221 @@
+/**
+ * @brief Benchmark for the throughput of the whole compiler, generates
+ *        synthetic programs of growing size, times `sypherc` on each of
+ *        them, and fits the time taken against the size of the source. A
+ *        fitted exponent well above 1 means some phase has gone superlinear.
+ *
+ *        Usage: scale_bench <SYPHERC_PATH>
+ *               scale_bench --gen <KIND> <SIZE>
+ *
+ *        The second form prints a generated program to `stdout`.
+ */
+
+#include "../inc/out_buf.h"
+#include "../inc/utils.h"
+#include <math.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIZE_STEPS 5
+#define RUN_REPEAT 3
+#define SUPERLINEAR_EXPONENT 1.25
+
+typedef void (*GenFunc)(OutBuf *src, long size);
+
+// Globals initialized with literals, and a final expression reading two.
+static void gen_globals(OutBuf *src, long size) {
+    for (long i = 0; i < size; i++)
+        out_buf_printf(src, "int: g%ld := %ld\n", i, i % 100);
+    out_buf_printf(src, "g0 + g%ld\n", size - 1);
+}
+
+// Named functions, and a call to the last one.
+static void gen_funcs(OutBuf *src, long size) {
+    for (long i = 0; i < size; i++)
+        out_buf_printf(src, "int: f%ld(int: a) := int: (int: a) { a + %ld }\n",
+                       i, i % 100);
+    out_buf_printf(src, "f%ld(1)\n", size - 1);
+}
+
+// If expressions nested `size` levels deep.
+static void gen_nested_ifs(OutBuf *src, long size) {
+    out_buf_str(src, "int: x := 1\n");
+    for (long i = 0; i < size; i++)
+        out_buf_str(src, "if x > 0 {\n");
+    out_buf_str(src, "x\n");
+    for (long i = 0; i < size; i++)
+        out_buf_str(src, "} else { 0 }\n");
+}
+
+// A single expression of `size` terms.
+static void gen_expr_chain(OutBuf *src, long size) {
+    out_buf_str(src, "int: x := 1\nx");
+    for (long i = 1; i < size; i++)
+        out_buf_printf(src, " %c %ld", i % 2 == 0 ? '+' : '-', i % 13);
+    out_buf_char(src, '\n');
+}
+
+// A chain of pointers, each pointing to the previous one, so the last one
+// has `size` levels of indirection, and is dereferenced all the way.
+static void gen_ptr_chain(OutBuf *src, long size) {
+    out_buf_str(src, "int: p0 := 7\n");
+    for (long i = 1; i <= size; i++) {
+        for (long j = 0; j < i; j++)
+            out_buf_char(src, '@');
+        out_buf_printf(src, "int: p%ld;\np%ld := &p%ld;\n", i, i, i - 1);
+    }
+    for (long j = 0; j < size; j++)
+        out_buf_char(src, '@');
+    out_buf_printf(src, "p%ld\n", size);
+}
+
+// An array of `size` elements, with every element assigned.
+static void gen_arrays(OutBuf *src, long size) {
+    out_buf_printf(src, "int[%ld]: arr;\n", size);
+    for (long i = 0; i < size; i++)
+        out_buf_printf(src, "arr[%ld] := %ld\n", i, i % 100);
+    out_buf_printf(src, "arr[0] + arr[%ld]\n", size - 1);
+}
+
+typedef struct ProgramKind {
+    const char *name;
+    GenFunc gen;
+    long base_size; // Size of the smallest program, doubled at every step.
+} ProgramKind;
+
+static const ProgramKind program_kinds[] = {
+    {"globals", gen_globals, 500},       {"funcs", gen_funcs, 250},
+    {"nested_ifs", gen_nested_ifs, 100}, {"expr_chain", gen_expr_chain, 1000},
+    {"ptr_chain", gen_ptr_chain, 25},    {"arrays", gen_arrays, 500},
+};
+
+#define PROGRAM_KIND_COUNT                                                     \
+    (sizeof(program_kinds) / sizeof(program_kinds[0]))
+
+static double elapsed_ms(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 +
+           (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static void write_source(const char *path, const char *data, size_t len) {
+    FILE *fptr = fopen(path, "w");
+    if (fptr == NULL)
+        print_error(ERR_FILE_OPEN, "Unable to open : `%s`", path);
+    if (fwrite(data, 1, len, fptr) != len)
+        print_error(ERR_FILE_WRITE, "Unable to write : `%s`", path);
+    fclose(fptr);
+}
+
+// Runs `sypherc` on `src_path`, and returns the best wall time out of
+// `RUN_REPEAT` runs.
+static double time_sypherc(const char *sypherc, const char *src_path) {
+    double best_ms = INFINITY;
+    for (int i = 0; i < RUN_REPEAT; i++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        pid_t pid = fork();
+        if (pid < 0)
+            print_error(ERR_COMMON, "Unable to fork `%s`", sypherc);
+        if (pid == 0) {
+            execl(sypherc, sypherc, src_path, "-o", "/dev/null", (char *)NULL);
+            _exit(127);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            print_error(ERR_COMMON, "`%s` failed on : `%s`", sypherc,
+                        src_path);
+
+        double ms = elapsed_ms(&start, &end);
+        if (ms < best_ms)
+            best_ms = ms;
+    }
+    return best_ms;
+}
+
+// Least squares fit of `log(time) = k * log(bytes) + c`, returns `k`.
+static double fit_exponent(const double *bytes, const double *ms, int count) {
+    double sum_x = 0, sum_y = 0, sum_xx = 0, sum_xy = 0;
+    for (int i = 0; i < count; i++) {
+        double x = log(bytes[i]);
+        double y = log(ms[i]);
+        sum_x += x;
+        sum_y += y;
+        sum_xx += x * x;
+        sum_xy += x * y;
+    }
+    return (count * sum_xy - sum_x * sum_y) / (count * sum_xx - sum_x * sum_x);
+}
+
+static const ProgramKind *find_kind(const char *name) {
+    for (size_t i = 0; i < PROGRAM_KIND_COUNT; i++)
+        if (strcmp(program_kinds[i].name, name) == 0)
+            return &program_kinds[i];
+    print_error(ERR_ARGS, "Unknown program kind : `%s`", name);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 4 && strcmp(argv[1], "--gen") == 0) {
+        OutBuf *src = out_buf_create_fd(STDOUT_FILENO);
+        find_kind(argv[2])->gen(src, strtol(argv[3], NULL, 10));
+        out_buf_destroy(src);
+        return 0;
+    }
+    if (argc != 2)
+        print_error(ERR_ARGS, "Usage: %s <SYPHERC_PATH> | --gen <KIND> <SIZE>",
+                    argv[0]);
+
+    const char *sypherc = argv[1];
+    char src_path[] = "/tmp/scale_bench_XXXXXX.sy";
+    int src_fd = mkstemps(src_path, 3);
+    if (src_fd < 0)
+        print_error(ERR_FILE_OPEN, "Unable to create a temporary source file");
+    close(src_fd);
+
+    // Process startup is paid by every run, and is taken out before fitting.
+    write_source(src_path, "1\n", 2);
+    double startup_ms = time_sypherc(sypherc, src_path);
+    printf("startup : %.3f ms\n\n", startup_ms);
+
+    int superlinear_count = 0;
+    for (size_t k = 0; k < PROGRAM_KIND_COUNT; k++) {
+        const ProgramKind *kind = &program_kinds[k];
+        double bytes[SIZE_STEPS], ms[SIZE_STEPS];
+
+        printf("%-10s %10s %12s %12s %12s\n", kind->name, "SIZE", "BYTES",
+               "TIME (ms)", "ns/byte");
+        long size = kind->base_size;
+        for (int i = 0; i < SIZE_STEPS; i++, size *= 2) {
+            OutBuf *src = out_buf_create_mem();
+            kind->gen(src, size);
+            size_t len = 0;
+            char *data = out_buf_release(src, &len);
+            write_source(src_path, data, len);
+            free(data);
+
+            double run_ms = time_sypherc(sypherc, src_path) - startup_ms;
+            // Keep tiny runs above zero, so that they can be fitted.
+            bytes[i] = len;
+            ms[i] = run_ms > 0.001 ? run_ms : 0.001;
+            printf("%-10s %10ld %12zu %12.3f %12.2f\n", "", size, len, ms[i],
+                   ms[i] * 1e6 / len);
+        }
+
+        double exponent = fit_exponent(bytes, ms, SIZE_STEPS);
+        char is_superlinear = exponent > SUPERLINEAR_EXPONENT;
+        superlinear_count += is_superlinear;
+        printf("%-10s time ~ bytes^%.2f%s\n\n", "", exponent,
+               is_superlinear ? "  <-- SUPERLINEAR" : "");
+    }
+
+    unlink(src_path);
+    if (superlinear_count != 0) {
+        printf("%d of %zu program kinds scale superlinearly\n",
+               superlinear_count, PROGRAM_KIND_COUNT);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+/**
+ * @brief Load generator for the compile server, starts `sypherc --server`,
+ *        and sends it compile requests from a growing number of concurrent
+ *        connections. Reports requests per second, and the latency of the
+ *        requests.
+ *
+ *        Usage: server_bench <SYPHERC_PATH> [REQUESTS_PER_CONNECTION]
+ */
+
+#include "../inc/server.h"
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SRC_BUF_SIZE 4096
+#define FUNC_COUNT 20
+#define SERVER_JOBS "4"
+#define START_TIMEOUT_MS 5000
+
+typedef struct LoadThread {
+    pthread_t thread;
+    const char *sock_path;
+    long request_count;
+    long seed;
+    double *latencies_ms;
+} LoadThread;
+
+static double elapsed_ms(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 +
+           (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// Generates a small program, a handful of functions, globals, and an if
+// expression, varied by `seed`.
+static size_t gen_src(char *src, long seed) {
+    size_t used = 0;
+    for (long i = 0; i < FUNC_COUNT; i++)
+        used += snprintf(src + used, SRC_BUF_SIZE - used,
+                         "int: f%ld(int: a) := int: (int: a) { a + %ld }\n"
+                         "int: g%ld := f%ld(%ld)\n",
+                         i, (seed + i) % 13, i, i, seed % 7);
+    used += snprintf(src + used, SRC_BUF_SIZE - used,
+                     "if g0 > 3 { g1 } else { g%d }\n", FUNC_COUNT - 1);
+    return used;
+}
+
+// Sends `request_count` requests over a single connection, one at a time,
+// and records the latency of every one of them.
+static void *load_thread(void *thread_data) {
+    LoadThread *load = (LoadThread *)thread_data;
+    int sock_fd = server_connect(load->sock_path);
+    char src[SRC_BUF_SIZE];
+    for (long i = 0; i < load->request_count; i++) {
+        size_t len = gen_src(src, load->seed + i);
+        SypherOutput out;
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (server_compile(sock_fd, src, len, NULL, &out) != 0)
+            print_error(out.err, "Request failed : %s", out.err_msg);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        load->latencies_ms[i] = elapsed_ms(&start, &end);
+        sypher_output_free(&out);
+    }
+    close(sock_fd);
+    return NULL;
+}
+
+static int cmp_double(const void *lhs, const void *rhs) {
+    double diff = *(const double *)lhs - *(const double *)rhs;
+    return (diff > 0) - (diff < 0);
+}
+
+// Runs `conn_count` connections at once, and prints a row of results.
+static void run_load(const char *sock_path, int conn_count,
+                     long request_count) {
+    long total_count = conn_count * request_count;
+    double *latencies_ms = (double *)malloc(total_count * sizeof(double));
+    CHECK_NULL(latencies_ms, "Unable to allocate memory for %s",
+               "latencies");
+    LoadThread *loads = (LoadThread *)calloc(conn_count, sizeof(LoadThread));
+    CHECK_NULL(loads, "Unable to allocate memory for %s", "connections");
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < conn_count; i++) {
+        loads[i].sock_path = sock_path;
+        loads[i].request_count = request_count;
+        loads[i].seed = i * request_count;
+        loads[i].latencies_ms = latencies_ms + i * request_count;
+        pthread_create(&loads[i].thread, NULL, load_thread, &loads[i]);
+    }
+    for (int i = 0; i < conn_count; i++)
+        pthread_join(loads[i].thread, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    qsort(latencies_ms, total_count, sizeof(double), cmp_double);
+    double total_ms = elapsed_ms(&start, &end);
+    printf("%12d %12.0f %12.3f %12.3f %12.3f\n", conn_count,
+           total_count * 1e3 / total_ms, latencies_ms[total_count / 2],
+           latencies_ms[total_count * 99 / 100],
+           latencies_ms[total_count - 1]);
+
+    free(loads);
+    free(latencies_ms);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2)
+        print_error(ERR_ARGS,
+                    "Usage: %s <SYPHERC_PATH> [REQUESTS_PER_CONNECTION]",
+                    argv[0]);
+    const char *sypherc = argv[1];
+    long request_count = argc > 2 ? strtol(argv[2], NULL, 10) : 500;
+    if (request_count < 1) {
+        print_error(ERR_ARGS, "Expected a positive number of requests");
+        return 1;
+    }
+
+    char sock_path[64];
+    snprintf(sock_path, sizeof(sock_path), "/tmp/server_bench_%d.sock",
+             (int)getpid());
+    pid_t pid = fork();
+    if (pid < 0)
+        print_error(ERR_COMMON, "Unable to fork `%s`", sypherc);
+    if (pid == 0) {
+        execl(sypherc, sypherc, "--server", sock_path, "-j", SERVER_JOBS,
+              (char *)NULL);
+        _exit(127);
+    }
+
+    // The server is ready, once its socket shows up.
+    struct stat sock_stat;
+    int waited_ms = 0;
+    while (stat(sock_path, &sock_stat) != 0 || !S_ISSOCK(sock_stat.st_mode)) {
+        if (waited_ms >= START_TIMEOUT_MS || waitpid(pid, NULL, WNOHANG) != 0)
+            print_error(ERR_COMMON, "`%s --server` did not start", sypherc);
+        usleep(10000);
+        waited_ms += 10;
+    }
+
+    printf("%ld requests per connection, server with %s workers, %ld cpus "
+           "online\n",
+           request_count, SERVER_JOBS, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%12s %12s %12s %12s %12s\n", "CONNECTIONS", "REQ/s", "p50 (ms)",
+           "p99 (ms)", "max (ms)");
+    for (int conn_count = 1; conn_count <= 8; conn_count *= 2)
+        run_load(sock_path, conn_count, request_count);
+
+    kill(pid, SIGTERM);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        print_error(ERR_COMMON, "`%s --server` did not stop cleanly", sypherc);
+    return 0;
+}
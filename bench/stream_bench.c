@@ -0,0 +1,184 @@
+/**
+ * @brief Benchmark for the peak memory of `sypherc`, with, and without
+ *        `--stream`, on generated programs of growing size. Streaming should
+ *        keep the peak resident set flat, while compiling the whole program
+ *        at once grows with the source.
+ *
+ *        Usage: stream_bench <SYPHERC_PATH> [MAX_STATEMENTS]
+ */
+
+#include "../inc/out_buf.h"
+#include "../inc/utils.h"
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_STEPS 16
+#define FLAT_GROWTH 1.5
+
+typedef void (*GenFunc)(OutBuf *src, long stmt_count);
+
+// Re-assignments of a single global.
+static void gen_assigns(OutBuf *src, long stmt_count) {
+    out_buf_str(src, "int: x := 0\n");
+    for (long i = 0; i < stmt_count; i++)
+        out_buf_printf(src, "x := x + %ld\n", i % 100);
+    out_buf_str(src, "x\n");
+}
+
+// If expressions, each opening contexts of their own.
+static void gen_ifs(OutBuf *src, long stmt_count) {
+    out_buf_str(src, "int: x := 0\n");
+    for (long i = 0; i < stmt_count; i++)
+        out_buf_printf(src, "if x > %ld { x := x - 1 } else { x := x + 1 }\n",
+                       i % 100);
+    out_buf_str(src, "x\n");
+}
+
+// Lambdas, each generating a function body, assigned to the same global.
+static void gen_lambdas(OutBuf *src, long stmt_count) {
+    out_buf_str(src, "int: x := 0\n"
+                     "int: f(int: a) := int: (int: a) { a }\n");
+    for (long i = 0; i < stmt_count; i++)
+        out_buf_printf(src,
+                       "f := int: (int: a) { a + %ld }\n"
+                       "x := f(x)\n",
+                       i % 100);
+    out_buf_str(src, "x\n");
+}
+
+typedef struct ProgramKind {
+    const char *name;
+    GenFunc gen;
+} ProgramKind;
+
+static const ProgramKind program_kinds[] = {
+    {"assigns", gen_assigns},
+    {"ifs", gen_ifs},
+    {"lambdas", gen_lambdas},
+};
+
+#define PROGRAM_KIND_COUNT                                                     \
+    (sizeof(program_kinds) / sizeof(program_kinds[0]))
+
+// Generates the program straight into the file, so that the benchmark never
+// holds it, its own resident set is inherited by `sypherc` until the exec.
+static size_t write_source(const char *path, const ProgramKind *kind,
+                           long stmt_count) {
+    int fd = open(path, O_WRONLY | O_TRUNC);
+    if (fd < 0)
+        print_error(ERR_FILE_OPEN, "Unable to open : `%s`", path);
+    OutBuf *src = out_buf_create_fd(fd);
+    kind->gen(src, stmt_count);
+    out_buf_destroy(src);
+
+    // While the pages that were just written are still cached, mapping them
+    // adds a few MiB to the peak of `--stream`, at random. Every run reads
+    // the file back from the disk instead.
+    if (fsync(fd) < 0 || posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) != 0)
+        print_error(ERR_FILE_WRITE, "Unable to flush : `%s`", path);
+
+    struct stat src_stat;
+    if (fstat(fd, &src_stat) < 0)
+        print_error(ERR_FILE_SIZE, "Could not calculate file size : `%s`",
+                    path);
+    close(fd);
+    return src_stat.st_size;
+}
+
+static double elapsed_ms(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 +
+           (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// Runs `sypherc` on `src_path`, and returns its peak resident set in KiB.
+static long peak_rss_sypherc(const char *sypherc, const char *src_path,
+                             const char *mode_opt, double *ms) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid_t pid = fork();
+    if (pid < 0)
+        print_error(ERR_COMMON, "Unable to fork `%s`", sypherc);
+    if (pid == 0) {
+        if (mode_opt != NULL)
+            execl(sypherc, sypherc, src_path, mode_opt, "-o", "/dev/null",
+                  (char *)NULL);
+        else
+            execl(sypherc, sypherc, src_path, "-o", "/dev/null",
+                  (char *)NULL);
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        print_error(ERR_COMMON, "`%s` failed on : `%s`", sypherc, src_path);
+
+    *ms = elapsed_ms(&start, &end);
+    return usage.ru_maxrss;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2)
+        print_error(ERR_ARGS, "Usage: %s <SYPHERC_PATH> [MAX_STATEMENTS]",
+                    argv[0]);
+
+    const char *sypherc = argv[1];
+    long max_count = 100000;
+    if (argc > 2)
+        max_count = strtol(argv[2], NULL, 10);
+
+    char src_path[] = "/tmp/stream_bench_XXXXXX.sy";
+    int src_fd = mkstemps(src_path, 3);
+    if (src_fd < 0)
+        print_error(ERR_FILE_OPEN, "Unable to create a temporary source file");
+    close(src_fd);
+
+    int growing_count = 0;
+    for (size_t k = 0; k < PROGRAM_KIND_COUNT; k++) {
+        const ProgramKind *kind = &program_kinds[k];
+        long stream_rss[MAX_STEPS];
+        int steps = 0;
+
+        printf("%-10s %10s %12s %12s %10s %12s %10s\n", kind->name,
+               "STATEMENTS", "BYTES", "PEAK (KiB)", "TIME (ms)",
+               "STREAM (KiB)", "TIME (ms)");
+        for (long stmt_count = 1000;
+             stmt_count <= max_count && steps < MAX_STEPS;
+             stmt_count *= 10, steps++) {
+            size_t len = write_source(src_path, kind, stmt_count);
+
+            double whole_ms = 0, stream_ms = 0;
+            long whole_rss =
+                peak_rss_sypherc(sypherc, src_path, NULL, &whole_ms);
+            stream_rss[steps] =
+                peak_rss_sypherc(sypherc, src_path, "--stream", &stream_ms);
+            printf("%-10s %10ld %12zu %12ld %10.1f %12ld %10.1f\n", "",
+                   stmt_count, len, whole_rss, whole_ms, stream_rss[steps],
+                   stream_ms);
+        }
+        if (steps < 2) {
+            printf("\n");
+            continue;
+        }
+
+        double growth = (double)stream_rss[steps - 1] / stream_rss[0];
+        char is_growing = growth > FLAT_GROWTH;
+        growing_count += is_growing;
+        printf("%-10s streaming peak grew %.2fx%s\n\n", "", growth,
+               is_growing ? "  <-- NOT FLAT" : "");
+    }
+
+    unlink(src_path);
+    if (growing_count != 0) {
+        printf("%d of %zu program kinds don't stream in flat memory\n",
+               growing_count, PROGRAM_KIND_COUNT);
+        return 1;
+    }
+    return 0;
+}
@@ -8,12 +8,20 @@ extern "C" {
 #include "../code_gen.h"
 
 CGContext *create_cgcontext(TargetFormat fmt, TargetCallingConvention call_conv,
-                            TargetAssemblyDialect dialect, FILE *fptr);
+                            TargetAssemblyDialect dialect, OutBuf *code_out);
 
 CGContext *create_cgcontext_child(CGContext *parent_ctx);
 
+// Creates the context for a function body, that has its own copy of the
+// register pool, and the target specific state of `parent_ctx`.
+CGContext *create_cgcontext_func(CGContext *parent_ctx);
+
 void free_cgcontext(CGContext *cg_ctx);
 
+// Writes the target specific state of `cg_ctx`, that the code generated for
+// it depends on, into the key of a function in the function cache.
+void cgcontext_write_cache_key(CGContext *cg_ctx, OutBuf *key);
+
 void code_gen_setup_func_call(CGContext *cg_ctx);
 
 void code_gen_ext_func_arg(CGContext *cg_ctx, RegDescriptor arg_reg);
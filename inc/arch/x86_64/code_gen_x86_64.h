@@ -28,12 +28,16 @@ extern "C" {
 
 CGContext *create_cgcontext_gnu_as_win(CGContext *parent_ctx);
 
+CGContext *create_cgcontext_func_gnu_as_win(CGContext *parent_ctx);
+
 void free_cgcontext_gnu_as_win(CGContext *cg_ctx);
 
+void cgcontext_write_cache_key_gnu_as_win(CGContext *cg_ctx, OutBuf *key);
+
 CGContext *create_cgcontext_arch_x86_64(TargetFormat fmt,
                                         TargetCallingConvention call_conv,
                                         TargetAssemblyDialect dialect,
-                                        FILE *fptr);
+                                        OutBuf *code_out);
 
 CGContext *create_cgcontext_child_arch_x86_64(CGContext *parent_ctx);
 
@@ -0,0 +1,119 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * @brief Default size of a single chunk in the arena, allocations larger
+ *        than this get a chunk of their own.
+ */
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+/**
+ * @brief Alignment for every allocation handed out by the arena.
+ */
+#define ARENA_ALIGNMENT 16
+
+/**
+ * @brief Structure defining a single chunk of memory in the arena. Chunks
+ *        are chained backwards, so that the whole arena can be released by
+ *        walking from the latest chunk.
+ */
+typedef struct ArenaChunk {
+    struct ArenaChunk *prev_chunk; ///< Pointer to the previous chunk.
+    size_t chunk_size;             ///< Number of usable bytes in the chunk.
+    size_t chunk_used;             ///< Number of bytes handed out.
+    /// Memory for the allocations, starting at `ARENA_ALIGNMENT`.
+    _Alignas(ARENA_ALIGNMENT) unsigned char data[];
+} ArenaChunk;
+
+/**
+ * @brief Structure defining a bump allocator. Every allocation is zeroed, and
+ *        lives until the arena is destroyed.
+ */
+typedef struct Arena {
+    ArenaChunk *curr_chunk; ///< Chunk that allocations are bumped from.
+    size_t chunk_size;      ///< Size used for new chunks.
+    size_t bytes_used;      ///< Total bytes handed out by the arena.
+    size_t bytes_reserved;  ///< Total bytes requested from the system.
+    size_t alloc_count;     ///< Number of allocations handed out.
+} Arena;
+
+/**
+ * @brief  Creates a new arena.
+ *
+ * @param  chunk_size [`size_t`] Size of every chunk, `0` selects
+ *                    `ARENA_CHUNK_SIZE`.
+ * @return Arena*     Pointer to the newly created arena.
+ */
+Arena *arena_create(size_t chunk_size);
+
+/**
+ * @brief  Allocates zeroed memory from the arena.
+ *
+ * @param  arena [`Arena *`] Pointer to the arena.
+ * @param  size  [`size_t`] Number of bytes to allocate.
+ * @return void* Pointer to the allocated memory.
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * @brief  Copies `len` bytes of a string into the arena, and NULL terminates
+ *         the copy.
+ *
+ * @param  arena [`Arena *`] Pointer to the arena.
+ * @param  str   [`const char *`] Pointer to the string.
+ * @param  len   [`size_t`] Number of bytes to copy.
+ * @return char* Pointer to the copy of the string.
+ */
+char *arena_strndup(Arena *arena, const char *str, size_t len);
+
+/**
+ * @brief Releases all the chunks but the first, so that the arena can be
+ *        reused from scratch. Everything allocated from it so far is
+ *        invalidated.
+ *
+ * @param arena [`Arena *`] Pointer to the arena.
+ */
+void arena_reset(Arena *arena);
+
+/**
+ * @brief Releases all the chunks, and the arena itself.
+ *
+ * @param arena [`Arena *`] Pointer to the arena.
+ */
+void arena_destroy(Arena *arena);
+
+/**
+ * @brief Sets the arena that the compiler allocates from, i.e. the arena for
+ *        the compilation currently in progress. The current arena is kept per
+ *        thread.
+ *
+ * @param arena [`Arena *`] Pointer to the arena.
+ */
+void arena_set_current(Arena *arena);
+
+/**
+ * @brief  Gets the arena for the compilation currently in progress.
+ *
+ * @return Arena* Pointer to the current arena.
+ */
+Arena *arena_get_current();
+
+/**
+ * @brief  Allocates zeroed memory from the current arena.
+ *
+ * @param  size  [`size_t`] Number of bytes to allocate.
+ * @return void* Pointer to the allocated memory.
+ */
+void *arena_calloc(size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ARENA_H__ */
@@ -10,7 +10,15 @@ extern "C" {
 
 #define NODE_BUF_SIZE 512
 
-char *get_node_str(AstNode *node);
+/**
+ * @brief  Formats a short description of a node.
+ *
+ * @param  node     [`AstNode *`] Pointer to the node.
+ * @param  node_buf [`char *`] Buffer of `NODE_BUF_SIZE` bytes, that the
+ *                  description is written to.
+ * @return char*    Pointer to `node_buf`.
+ */
+char *get_node_str(AstNode *node, char *node_buf);
 
 /**
  * @brief This function prints out a node and all its children from the AST,
@@ -25,14 +33,16 @@ void print_ast_node(AstNode *root_node, int indent);
 /**
  * @brief  Compares two nodes.
  *
- * @param  node1 [`AstNode *`] Pointer to the first node.
- * @param  node2 [`AstNode *`] Pointer to the second node.
+ * @param  node1 [`const AstNode *`] Pointer to the first node.
+ * @param  node2 [`const AstNode *`] Pointer to the second node.
  * @return int   `1` to denote equality and `0` otherwise.
  */
-int node_cmp(AstNode *node1, AstNode *node2);
+int node_cmp(const AstNode *node1, const AstNode *node2);
 
 /**
- * @brief Adds a child node to the parent in the AST.
+ * @brief Adds a child node to the parent in the AST, in constant time when
+ *        children are only added through this function. Cycles are not
+ *        checked for here, see `ast_verify()`.
  *
  * @param parent_node  [`AstNode *`] Pointer to the parent node.
  * @param child_to_add [`AstNode *`] Pointer to the child node
@@ -41,15 +51,25 @@ int node_cmp(AstNode *node1, AstNode *node2);
 void add_ast_node_child(AstNode *parent_node, AstNode *child_to_add);
 
 /**
- * @brief  Allocates memory for a new node, and initialize its
- *         members.
+ * @brief Checks that no list of children in the AST under `node` loops back
+ *        on itself. Only called in debug builds, it exits with an error on
+ *        the first loop.
+ *
+ * @param node [`const AstNode *`] Pointer to the root of the AST.
+ */
+void ast_verify(const AstNode *node);
+
+/**
+ * @brief  Allocates memory for a new node from the current arena, and
+ *         initialize its members.
  *
  * @return AstNode* Pointer to newly allocated node.
  */
 AstNode *node_alloc();
 
 /**
- * @brief  Creates a new node of type symbol from a string.
+ * @brief  Creates a new node of type symbol from a string, the string is
+ *         interned.
  *
  * @param  symbol_str [`char *`] Pointer to the symbol string.
  * @return AstNode*   Pointer to the newly created node.
@@ -72,15 +92,8 @@ AstNode *create_node_none();
 AstNode *create_node_int(long val);
 
 /**
- * @brief Frees nodes in an AST.
- *
- * @param node_to_free [`AstNode *`] Pointer to the node
- *                     that needs to be freed.
- */
-void free_node(AstNode *node_to_free);
-
-/**
- * @brief  Creates a node of type symbol from a token.
+ * @brief  Creates a node of type symbol from a token, using the hash
+ *         computed by the lexer to intern the symbol.
  *
  * @param  token     [`LexedToken *`] Pointer to the token.
  * @return AstNode*  Pointer to the newly created node.
@@ -89,14 +102,14 @@ AstNode *node_symbol_from_token_create(LexedToken *token);
 
 /**
  * @brief  Deep copies the content from the source node into
- *         the destination node.
+ *         the destination node, interned symbols are shared.
  *
  * @param  dst_node [`AstNode *`] Pointer to the destination
  *                  node.
- * @param  src_node [`AstNode *`] Pointer to the source node.
+ * @param  src_node [`const AstNode *`] Pointer to the source node.
  * @return int      `1` for success, and `0` for failure.
  */
-int copy_node(AstNode *dst_node, AstNode *src_node);
+int copy_node(AstNode *dst_node, const AstNode *src_node);
 
 #ifdef __cplusplus
 }
@@ -7,10 +7,9 @@ extern "C" {
 
 #include <stdio.h>
 
+#include "out_buf.h"
 #include "parser.h"
-
-#define LABEL_ARR_SIZE 1024
-#define SYM_ARR_SIZE 1024
+#include "task_pool.h"
 
 #define FUNC_FOOTER_x86_64                                                     \
     "pop %rbp\n"                                                               \
@@ -21,6 +20,9 @@ extern "C" {
     "mov %rsp, %rbp\n"                                                         \
     "sub $32, %rsp\n"
 
+// Upper limit for the number of threads generating function bodies.
+#define MAX_CODEGEN_JOBS 256
+
 typedef enum TargetFormat {
     TARGET_FMT_X86_64_GNU_AS,
     TARGET_FMT_COUNT,
@@ -55,8 +57,6 @@ typedef enum ComparisonType {
     COMP_COUNT,
 } ComparisonType;
 
-extern char codegen_verbose;
-
 typedef int RegDescriptor;
 
 typedef struct Reg {
@@ -71,13 +71,24 @@ typedef struct RegPool {
     int reg_cnt;
 } RegPool;
 
+// State shared by every context that generates code for the same task, i.e.
+// a whole program, or a function body handed to a worker.
+typedef struct CGTaskState {
+    long label_cnt; // Number of the next label.
+    TaskPool *pool; // Workers for function bodies, NULL to generate inline.
+    struct CGFuncTask *func_tasks; // Function bodies handed to the pool.
+    struct CGFuncTask *func_tasks_tail;
+} CGTaskState;
+
 typedef struct CGContext {
     struct CGContext *parent_ctx;
-    Env *local_env;
     long local_offset;
     RegPool reg_pool;
-    FILE *fptr_code;
+    OutBuf *code_out;
     void *arch_data;
+    CGTaskState *task_state;
+    char codegen_verbose;       // Emit comments describing the generated code.
+    const char *func_cache_dir; // Function cache, NULL when not caching.
     TargetCallingConvention target_call_conv;
     TargetFormat target_fmt;
     TargetAssemblyDialect target_asm_dialect;
@@ -95,7 +106,89 @@ void reg_dealloc(CGContext *cg_ctx, RegDescriptor reg_desc);
 void target_codegen(ParsingContext *context, AstNode *program,
                     char *output_file_path, TargetFormat type,
                     TargetAssemblyDialect dialect,
-                    TargetCallingConvention call_conv);
+                    TargetCallingConvention call_conv, int jobs,
+                    const char *func_cache_dir);
+
+/**
+ * @brief  Generates code for the program into memory, rather than a file.
+ *
+ * @param  context   [`ParsingContext *`] Global context of the program.
+ * @param  program   [`AstNode *`] Program node.
+ * @param  code_len  [`size_t *`] Set to the number of bytes of code.
+ * @param  type      [`TargetFormat`] Output format.
+ * @param  dialect   [`TargetAssemblyDialect`] Assembly dialect.
+ * @param  call_conv [`TargetCallingConvention`] Calling convention.
+ * @param  jobs      [`int`] Number of threads generating function bodies.
+ * @param  func_cache_dir [`const char *`] Directory caching the code of
+ *                        functions, NULL to not cache.
+ * @return char*     NULL terminated code, to be released with `free()`.
+ */
+char *target_codegen_mem(ParsingContext *context, AstNode *program,
+                         size_t *code_len, TargetFormat type,
+                         TargetAssemblyDialect dialect,
+                         TargetCallingConvention call_conv, int jobs,
+                         const char *func_cache_dir);
+
+// Code generation for a program, whose top-level expressions are passed in
+// one at a time, and may be released once their code has been generated.
+typedef struct CGStream {
+    CGContext *cg_ctx;      // Context for the code outside of functions.
+    CGTaskState task_state; // Label numbering for the whole program.
+    OutBuf *code_out;       // Output file.
+    int code_fd;
+    RegDescriptor last_reg; // Value of the last expression, -1 if none.
+} CGStream;
+
+/**
+ * @brief  Opens the output file, and starts generating code for a program,
+ *         one expression at a time. Everything is allocated from the current
+ *         arena, which has to outlive the stream.
+ *
+ * @param  output_file_path [`char *`] Path to the output file, NULL for
+ *                          `code_gen.s`.
+ * @param  type      [`TargetFormat`] Output format.
+ * @param  dialect   [`TargetAssemblyDialect`] Assembly dialect.
+ * @param  call_conv [`TargetCallingConvention`] Calling convention.
+ * @param  func_cache_dir [`const char *`] Directory caching the code of
+ *                        functions, NULL to not cache.
+ * @return CGStream* Pointer to the new stream.
+ */
+CGStream *target_codegen_stream_create(char *output_file_path,
+                                       TargetFormat type,
+                                       TargetAssemblyDialect dialect,
+                                       TargetCallingConvention call_conv,
+                                       const char *func_cache_dir);
+
+/**
+ * @brief Generates code for the next top-level expression, which has been
+ *        type checked. Function bodies are generated inline, so nothing
+ *        refers to the expression afterwards.
+ *
+ * @param stream  [`CGStream *`] Pointer to the stream.
+ * @param context [`ParsingContext *`] Global context of the program.
+ * @param expr    [`AstNode *`] The expression.
+ */
+void target_codegen_stream_expr(CGStream *stream, ParsingContext *context,
+                                AstNode *expr);
+
+/**
+ * @brief Returns the value of the last expression from the program, and
+ *        reserves space for every global variable, once all the expressions
+ *        have been passed in.
+ *
+ * @param stream  [`CGStream *`] Pointer to the stream.
+ * @param context [`ParsingContext *`] Global context of the program.
+ */
+void target_codegen_stream_finish(CGStream *stream, ParsingContext *context);
+
+/**
+ * @brief Writes out, and closes the output file.
+ *
+ * @param stream    [`CGStream *`] Pointer to the stream.
+ * @param has_error [`char`] Set if the program failed to compile, the output
+ *                  is then left empty, rather than partly written.
+ */
+void target_codegen_stream_destroy(CGStream *stream, char has_error);
 
 #ifdef __cplusplus
 }
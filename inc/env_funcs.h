@@ -29,7 +29,47 @@ Env *create_env(Env *parent_Env);
 int set_env(Env **Env_to_set, AstNode *identifier_node, AstNode *id_val);
 
 /**
- * @brief  Gets the type node based on the identifier node.
+ * @brief  Borrows the value node bound to the identifier node, the returned
+ *         node points into the environment, and must not be modified.
+ *
+ * @param  Env_to_get     [`Env *`] Pointer to the environment which
+ *                        must be looked at.
+ * @param  identifier     [`const AstNode *`] Pointer to the identifier node.
+ * @param  stat           [`int`] Status of the function execution.
+ * @return const AstNode* Pointer to the value node, or NULL if the
+ *                        identifier isn't bound.
+ */
+const AstNode *get_env_ref(Env *Env_to_get, const AstNode *identifier,
+                           int *stat);
+
+/**
+ * @brief  Borrows the value node bound to an interned identifier string.
+ *
+ * @param  Env_to_get     [`Env *`] Pointer to the environment which
+ *                        must be looked at.
+ * @param  identifier     [`const char *`] Pointer to the interned identifier.
+ * @param  stat           [`int`] Status of the function execution.
+ * @return const AstNode* Pointer to the value node, or NULL if the
+ *                        identifier isn't bound.
+ */
+const AstNode *get_env_ref_from_sym(Env *Env_to_get, const char *identifier,
+                                    int *stat);
+
+/**
+ * @brief  Borrows the identifier node bound to a value node.
+ *
+ * @param  Env_to_get     [`Env *`] Pointer to the environment which
+ *                        must be looked at.
+ * @param  val            [`const AstNode *`] Pointer to the value node.
+ * @param  stat           [`int`] Status of the function execution.
+ * @return const AstNode* Pointer to the identifier node, or NULL if the
+ *                        value isn't bound.
+ */
+const AstNode *get_env_ref_from_val(Env *Env_to_get, const AstNode *val,
+                                    int *stat);
+
+/**
+ * @brief  Gets a copy of the type node based on the identifier node.
  *
  * @param  Env_to_get [`Env *`] Pointer to the environment which
  *                    must be looked at.
@@ -39,37 +79,45 @@ int set_env(Env **Env_to_set, AstNode *identifier_node, AstNode *id_val);
  */
 AstNode *get_env(Env *Env_to_get, AstNode *identifier, int *stat);
 
-AstNode *get_env_from_sym(Env *Env_to_get, char *identifier, int *stat);
-
-AstNode *get_env_from_val(Env *Env_to_get, AstNode *val, int *stat);
+/**
+ * @brief  Looks up the type node for the identifier, in the root context,
+ *         where all the types are bound. Pointer and function types share
+ *         a single pointer sized type node, and array types have no type
+ *         node, see `type_size()`.
+ *
+ * @param  context        [`ParsingContext *`] Pointer to the ParsingContext
+ *                        context.
+ * @param  identifier     [`const AstNode *`] Pointer to the identifier node.
+ * @param  stat           [`int`] Status of the function execution.
+ * @return const AstNode* Pointer to the type node, or NULL if the type
+ *                        isn't found.
+ */
+const AstNode *parser_get_type_ref(ParsingContext *context,
+                                   const AstNode *identifier, int *stat);
 
 /**
- * @brief  Searches the parsing contexts, for a type node based
- *         on the identifier.
+ * @brief Declares a variable in a parsing context, and creates the record,
+ *        that every access to it is bound to.
  *
- * @param  Env_to_get [`ParsingContext *`] Pointer to the ParsingContext
- *                    context.
- * @param  identifier [`AstNode *`] Pointer to the identifier node.
- * @param  stat       [`int`] Status of the function execution.
- * @return AstNode*   Pointer to the type node.
+ * @param context    [`ParsingContext *`] Pointer to the declaring context.
+ * @param identifier [`AstNode *`] Pointer to the identifier node, which
+ *                   is pointed to the record.
+ * @param type       [`AstNode *`] Pointer to the type of the variable.
  */
-AstNode *parser_get_type(ParsingContext *context, AstNode *identifier,
-                         int *stat);
+void parser_declare_var(ParsingContext *context, AstNode *identifier,
+                        AstNode *type);
 
-AstNode *parser_get_var(ParsingContext *context, AstNode *identifier,
-                        int *stat);
 /**
- * @brief  Searches the parsing contexts, for a type func based
- *         on the identifier.
+ * @brief  Searches the parsing contexts, for the record of the variable
+ *         bound to the identifier.
  *
- * @param  Env_to_get [`ParsingContext *`] Pointer to the ParsingContext
+ * @param  context    [`ParsingContext *`] Pointer to the ParsingContext
  *                    context.
- * @param  identifier [`AstNode *`] Pointer to the identifier node.
- * @param  stat       [`int`] Status of the function execution.
- * @return AstNode*   Pointer to the type node.
+ * @param  identifier [`const AstNode *`] Pointer to the identifier node.
+ * @return Symbol*    Pointer to the record, or NULL if the variable isn't
+ *                    declared.
  */
-AstNode *parser_get_func(ParsingContext *context, AstNode *identifier,
-                         int *stat);
+Symbol *parser_resolve_var(ParsingContext *context, const AstNode *identifier);
 
 void print_env(Env *env, int indent);
 
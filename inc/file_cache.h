@@ -0,0 +1,118 @@
+#ifndef __FILE_CACHE_H__
+#define __FILE_CACHE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "code_gen.h"
+#include "utils.h"
+#include <stdint.h>
+
+/**
+ * @brief Marks the start of every entry in the compile cache, the last byte
+ *        is bumped whenever the layout of entries changes.
+ */
+#define FILE_CACHE_MAGIC "SYCC0002"
+#define FILE_CACHE_MAGIC_LEN 8
+
+/**
+ * @brief Default bound on the size of the compile cache, in MiB.
+ */
+#define FILE_CACHE_DEFAULT_MAX_MIB 256
+
+/**
+ * @brief Structure defining the key of a source file in the compile cache.
+ *        It's stored at the start of every entry, followed by the source
+ *        itself, and then the generated code.
+ */
+typedef struct FileCacheHeader {
+    char magic[FILE_CACHE_MAGIC_LEN]; ///< `FILE_CACHE_MAGIC`.
+    char version[32];                 ///< Version of the compiler, NULL padded.
+    char build_id[BUILD_ID_SIZE];     ///< `build_id()`, NULL padded.
+    int32_t out_fmt;                  ///< Output format.
+    int32_t call_conv;                ///< Calling convention.
+    int32_t dialect;                  ///< Assembly dialect.
+    int32_t reserved;                 ///< Always 0.
+    uint64_t src_len;                 ///< Size of the source.
+    uint64_t code_len;                ///< Size of the code, 0 in a key.
+} FileCacheHeader;
+
+/**
+ * @brief Structure defining a lookup in the compile cache.
+ */
+typedef struct FileCacheKey {
+    FileCacheHeader header; ///< Everything the code depends on, but source.
+    const char *src;        ///< Source, borrowed from the caller.
+    uint64_t hash;          ///< Hash of the header, and source.
+} FileCacheKey;
+
+/**
+ * @brief Structure defining the counters for the compile cache.
+ */
+typedef struct FileCacheStats {
+    size_t hits;      ///< Files whose code was found in the cache.
+    size_t misses;    ///< Files compiled, and then stored in the cache.
+    size_t evictions; ///< Entries removed to keep the cache under its bound.
+} FileCacheStats;
+
+/**
+ * @brief Builds the cache key for a source file. The number of code
+ *        generation jobs, and the function cache are left out, as they
+ *        never change the generated code.
+ *
+ * @param key       [`FileCacheKey *`] Key to be filled in.
+ * @param src       [`const char *`] Source of the file.
+ * @param src_len   [`size_t`] Size of the source.
+ * @param type      [`TargetFormat`] Output format.
+ * @param dialect   [`TargetAssemblyDialect`] Assembly dialect.
+ * @param call_conv [`TargetCallingConvention`] Calling convention.
+ */
+void file_cache_key(FileCacheKey *key, const char *src, size_t src_len,
+                    TargetFormat type, TargetAssemblyDialect dialect,
+                    TargetCallingConvention call_conv);
+
+/**
+ * @brief  Looks up a source file in the cache, and on a hit, streams the
+ *         cached code into `out_path`, marking the entry as recently used.
+ *
+ * @param  dir      [`const char *`] Directory holding the cache.
+ * @param  key      [`const FileCacheKey *`] Key of the source file.
+ * @param  out_path [`const char *`] Path to the output file.
+ * @return char     1 on a hit, 0 otherwise, in which case `out_path` is
+ *                  left untouched.
+ */
+char file_cache_load(const char *dir, const FileCacheKey *key,
+                     const char *out_path);
+
+/**
+ * @brief Stores the code generated into `out_path` in the cache, and then
+ *        evicts the least recently used entries, until the cache fits in
+ *        `max_size`. Entries are written to a temporary file, and renamed
+ *        into place, so readers never see a partial entry. Failing to
+ *        store is not an error.
+ *
+ * @param dir      [`const char *`] Directory holding the cache.
+ * @param max_size [`size_t`] Bound on the size of the cache, in bytes.
+ * @param key      [`const FileCacheKey *`] Key of the source file.
+ * @param out_path [`const char *`] Path to the generated code.
+ * @param stats    [`FileCacheStats *`] Counters, evictions are added to.
+ */
+void file_cache_store(const char *dir, size_t max_size,
+                      const FileCacheKey *key, const char *out_path,
+                      FileCacheStats *stats);
+
+/**
+ * @brief Counts the entries in the cache, and their size.
+ *
+ * @param dir     [`const char *`] Directory holding the cache.
+ * @param entries [`size_t *`] Set to the number of entries.
+ * @param size    [`size_t *`] Set to the size of the entries, in bytes.
+ */
+void file_cache_usage(const char *dir, size_t *entries, size_t *size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FILE_CACHE_H__ */
@@ -0,0 +1,77 @@
+#ifndef __FUNC_CACHE_H__
+#define __FUNC_CACHE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "code_gen.h"
+
+/**
+ * @brief Marks the start of every entry in the function cache, the last byte
+ *        is bumped whenever the layout of entries, or of keys changes.
+ */
+#define FUNC_CACHE_MAGIC "SYFC0001"
+#define FUNC_CACHE_MAGIC_LEN 8
+
+/**
+ * @brief Structure defining the key of a function in the function cache.
+ *        It holds everything that the code generated for the function
+ *        depends on, so that a hit is only ever a byte for byte match, and
+ *        never a hash collision.
+ */
+typedef struct FuncCacheKey {
+    char *data;       ///< Serialized key, allocated from the arena.
+    size_t len;       ///< Size of the serialized key.
+    uint64_t hash;    ///< Hash of the key, names the entry on disk.
+    long label_first; ///< First label numbered for the function.
+    long label_count; ///< Number of labels numbered for the function.
+    const char *dir;  ///< Directory holding the cache.
+} FuncCacheKey;
+
+/**
+ * @brief  Builds the cache key for a function, before code is generated
+ *         for it. Labels are numbered by position in the program, so they
+ *         are left out of the key, and renumbered on a hit.
+ *
+ * @param  cg_ctx      [`CGContext *`] Context created for the function body.
+ * @param  context     [`ParsingContext *`] Context enclosing the function,
+ *                     in which the symbols it references are looked up.
+ * @param  func        [`AstNode *`] Function node.
+ * @param  func_name   [`const char *`] Name of the function, NULL if it's
+ *                     named by a label.
+ * @param  label_first [`long`] First label numbered for the function.
+ * @param  label_count [`long`] Number of labels numbered for the function.
+ * @return FuncCacheKey* Key, allocated from the arena.
+ */
+FuncCacheKey *func_cache_key(CGContext *cg_ctx, ParsingContext *context,
+                             AstNode *func, const char *func_name,
+                             long label_first, long label_count);
+
+/**
+ * @brief  Looks up a function in the cache, and writes its code out, with
+ *         its labels renumbered, on a hit.
+ *
+ * @param  key      [`const FuncCacheKey *`] Key of the function.
+ * @param  code_out [`OutBuf *`] Output stream for the code.
+ * @return char     1 on a hit, 0 otherwise.
+ */
+char func_cache_load(const FuncCacheKey *key, OutBuf *code_out);
+
+/**
+ * @brief Stores the code generated for a function in the cache. Entries are
+ *        written to a temporary file, and renamed into place, so readers
+ *        never see a partial entry. Failing to store is not an error.
+ *
+ * @param key      [`const FuncCacheKey *`] Key of the function.
+ * @param code     [`const char *`] Code generated for the function.
+ * @param code_len [`size_t`] Size of the code.
+ */
+void func_cache_store(const FuncCacheKey *key, const char *code,
+                      size_t code_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FUNC_CACHE_H__ */
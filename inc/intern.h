@@ -0,0 +1,165 @@
+#ifndef __INTERN_H__
+#define __INTERN_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * @brief Initial number of slots in the intern table, must be a power of 2.
+ */
+#define INTERN_TABLE_INIT_SIZE 256
+
+/**
+ * @brief Initial value for the hash of a string (FNV-1a offset basis).
+ */
+#define INTERN_HASH_INIT 14695981039346656037UL
+
+/**
+ * @brief Adds a single byte to the hash of a string, this lets the lexer
+ *        hash a token while scanning it.
+ */
+#define INTERN_HASH_STEP(hash, byte)                                           \
+    (((hash) ^ (unsigned char)(byte)) * 1099511628211UL)
+
+/**
+ * @brief Structure defining a single interned string. The string is stored
+ *        inline, and the pointer to `str` is what the rest of the compiler
+ *        sees as a symbol.
+ */
+typedef struct InternStr {
+    unsigned long hash; ///< Hash of the string.
+    size_t length;      ///< Length of the string.
+    unsigned int id;    ///< Dense id of the string, in order of interning.
+    char str[];         ///< NULL terminated string.
+} InternStr;
+
+/**
+ * @brief Structure defining the strings, that are interned up-front, so that
+ *        the compiler can compare against them without hashing.
+ */
+typedef struct BuiltinSyms {
+    char *function;      ///< "function"
+    char *ext_function;  ///< "ext function"
+    char *array;         ///< "array"
+    char *int_type;      ///< "int"
+    char *kw_if;         ///< "if"
+    char *kw_else;       ///< "else"
+    char *kw_ext;        ///< "ext"
+    char *if_cond;       ///< Parsing stack operator "if-cond".
+    char *if_then_body;  ///< Parsing stack operator "if-then-body".
+    char *if_else_body;  ///< Parsing stack operator "if-else-body".
+    char *lambda_body;   ///< Parsing stack operator "lambda_body".
+    char *lambda_params; ///< Parsing stack operator "lambda_params".
+    char *func_call;     ///< Parsing stack operator "func_call".
+    char *op_eq;         ///< "=="
+    char *op_lt;         ///< "<"
+    char *op_gt;         ///< ">"
+    char *op_shl;        ///< "<<"
+    char *op_shr;        ///< ">>"
+    char *op_add;        ///< "+"
+    char *op_sub;        ///< "-"
+    char *op_mul;        ///< "*"
+    char *op_div;        ///< "/"
+    char *op_mod;        ///< "%"
+    char *op_deref;      ///< "@"
+    char *op_addr;       ///< "&"
+    char *assign;        ///< ":="
+    char *equals;        ///< "="
+    char *colon;         ///< ":"
+    char *comma;         ///< ","
+    char *paren_open;    ///< "("
+    char *paren_close;   ///< ")"
+    char *brace_open;    ///< "{"
+    char *brace_close;   ///< "}"
+    char *bracket_open;  ///< "["
+    char *bracket_close; ///< "]"
+} BuiltinSyms;
+
+/**
+ * @brief Built-in names for the intern table of the current thread.
+ */
+extern _Thread_local BuiltinSyms builtin_syms;
+
+/**
+ * @brief  Hashes `len` bytes of a string (FNV-1a).
+ *
+ * @param  str           [`const char *`] Pointer to the string.
+ * @param  len           [`size_t`] Number of bytes to hash.
+ * @return unsigned long Hash of the string.
+ */
+unsigned long intern_hash(const char *str, size_t len);
+
+/**
+ * @brief Creates the intern table for the current thread, and interns all
+ *        the built-in names. It's safe to call this more than once.
+ */
+void intern_init();
+
+/**
+ * @brief  Interns `len` bytes of a string, whose hash is already known.
+ *
+ * @param  str   [`const char *`] Pointer to the string.
+ * @param  len   [`size_t`] Length of the string.
+ * @param  hash  [`unsigned long`] Hash of the string from `intern_hash()`.
+ * @return char* Pointer to the interned copy of the string, the same
+ *               spelling always returns the same pointer.
+ */
+char *intern_str_hashed(const char *str, size_t len, unsigned long hash);
+
+/**
+ * @brief  Interns `len` bytes of a string, whose hash is already known, and
+ *         returns its id.
+ *
+ * @param  str          [`const char *`] Pointer to the string.
+ * @param  len          [`size_t`] Length of the string.
+ * @param  hash         [`unsigned long`] Hash of the string from
+ *                      `intern_hash()`.
+ * @return unsigned int Id of the interned string.
+ */
+unsigned int intern_id_hashed(const char *str, size_t len, unsigned long hash);
+
+/**
+ * @brief  Gets the interned string for an id.
+ *
+ * @param  id    [`unsigned int`] Id from `intern_id_hashed()`.
+ * @return char* Pointer to the interned string.
+ */
+char *intern_get(unsigned int id);
+
+/**
+ * @brief  Gets the id of a string returned by the intern table.
+ *
+ * @param  str          [`const char *`] Pointer to an interned string.
+ * @return unsigned int Id of the interned string.
+ */
+unsigned int intern_sym_id(const char *str);
+
+/**
+ * @brief  Interns a NULL terminated string.
+ *
+ * @param  str   [`const char *`] Pointer to the string.
+ * @return char* Pointer to the interned copy of the string.
+ */
+char *intern_str(const char *str);
+
+/**
+ * @brief  Gets the number of distinct strings in the intern table.
+ *
+ * @return size_t Number of interned strings.
+ */
+size_t intern_count();
+
+/**
+ * @brief Releases the intern table for the current thread, and every
+ *        interned string.
+ */
+void intern_destroy();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INTERN_H__ */
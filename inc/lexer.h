@@ -6,36 +6,85 @@ extern "C" {
 #endif
 
 #include "utils.h"
+#include <stdint.h>
 
 /**
- * @brief String containing all the the delimeters used
- *        for tokenizing.
+ * @brief Enumeration that defines the class of a character in the source,
+ *        every byte is classified through a 256-entry table.
  */
-#define DELIMS " :=,;~(){}[]<>-+/*&@%\r\n"
+typedef enum CharClass {
+    CHAR_WORD = 0,  ///< Character that is part of an identifier or integer.
+    CHAR_NUL,       ///< NULL terminator, i.e. the end of the source.
+    CHAR_SPACE,     ///< Whitespace, `;` is treated as whitespace.
+    CHAR_COMMENT,   ///< Start of a comment, that runs till the end of line.
+    CHAR_OPERATOR,  ///< Character that starts an operator.
+    CHAR_PUNCTUATOR ///< Punctuation character.
+} CharClass;
 
 /**
- * @brief String containing all the the whitespace characters
- *        for tokenizing.
+ * @brief Maximum length of a single token.
  */
-#define WHITESPACE " ;\r\n"
+#define TOKEN_MAX_LENGTH UINT16_MAX
 
 /**
- * @brief String containing all the comment delimeters used
- *        for tokenizing.
+ * @brief Number of tokens that the token array starts with.
  */
-#define COMMENTS_DELIMS "`#"
+#define TOKEN_ARR_INIT_SIZE 1024
 
 /**
- * @brief Structure defining a token.
+ * @brief Number of tokens in every block of a `TokenWindow`.
+ */
+#define TOKEN_BLOCK_SIZE 4096
+
+/**
+ * @brief Enumeration that defines a type for a `LexedToken`.
+ */
+typedef enum TokenKind {
+    TOKEN_EOF = 0,    ///< End of the source, this is `0` so that
+                      ///< `CHECK_END()` can be used on a token kind.
+    TOKEN_IDENTIFIER, ///< Identifier, this includes type names.
+    TOKEN_INTEGER,    ///< Integer literal.
+    TOKEN_OPERATOR,   ///< Operator, e.g. `+`, `<<`, `:=`, `@`.
+    TOKEN_KEYWORD,    ///< Keyword, i.e. `if`, `else` and `ext`.
+    TOKEN_PUNCTUATOR, ///< Punctuation, e.g. `(`, `}`, `:`, `,`.
+} TokenKind;
+
+/**
+ * @brief Structure defining a token. The whole source is lexed up-front into
+ *        a contiguous array of these.
  */
 typedef struct LexedToken {
-    char *token_start; ///< Pointer to the beginning of the token.
-    int token_length;  ///< Length of the token from the beginning.
+    uint32_t token_offset; ///< Offset of the token in the source.
+    uint32_t token_id;     ///< Intern id for the spelling of the token.
+    uint16_t token_length; ///< Length of the token.
+    uint8_t token_kind;    ///< `TokenKind` for the token.
 } LexedToken;
 
+/**
+ * @brief Structure defining the tokens of a source, that is lexed as the
+ *        parser asks for them, rather than up-front. Tokens are kept in
+ *        blocks, that never move, so pointers to them stay valid as more of
+ *        the source is lexed.
+ */
+typedef struct TokenWindow {
+    LexedToken **blocks;  ///< Blocks of tokens, the first holds token `0`.
+    size_t blocks_size;   ///< Number of slots in `blocks`.
+    uint32_t token_count; ///< Number of tokens lexed into the blocks.
+    char *lex_data;       ///< Next byte of the source to be lexed.
+} TokenWindow;
+
+/**
+ * @brief Structure defining the position of the parser in the token array.
+ *        Copying the state is enough to backtrack.
+ */
 typedef struct LexingState {
-    LexedToken *curr_token;
-    char *file_data;
+    LexedToken *curr_token; ///< Token that was lexed last.
+    LexedToken *tokens;     ///< Array of tokens, ending with `TOKEN_EOF`.
+    uint32_t token_idx;     ///< Index of the next token in `tokens`, or in
+                            ///< `window`.
+    char *file_data;        ///< Pointer to the source.
+    TokenWindow *window;    ///< Tokens lexed on demand, NULL when `tokens`
+                            ///< holds the whole source.
 } LexingState;
 
 /**
@@ -47,54 +96,92 @@ typedef struct LexingState {
 void print_lexed_token(LexedToken *curr_token);
 
 /**
- * @brief  Compare the string present in a token, with another one.
+ * @brief  Checks if a token is spelled as an interned symbol, by comparing
+ *         pointers, e.g. against one of `builtin_syms`.
  *
  * @param  curr_token  [`LexedToken *`] pointer to the token that needs
  *                     to be compared.
- * @param  str_to_cmp  [`char *`] pointer to the string that needs
- *                     to be compared.
+ * @param  sym         [`const char *`] Pointer to the interned symbol.
  * @return int         `1` for success and `0` for failure.
  */
-int strncmp_lexed_token(LexedToken *curr_token, char *str_to_cmp);
+int lexed_token_is(LexedToken *curr_token, const char *sym);
+
+/**
+ * @brief  Gets the spelling of a token.
+ *
+ * @param  token [`LexedToken *`] Pointer to the token.
+ * @return char* Pointer to the interned spelling of the token.
+ */
+char *lexed_token_str(LexedToken *token);
+
+/**
+ * @brief  Lexes the whole file data stream into an array of tokens.
+ *
+ * @param  file_data    [`char *`] Pointer to the NULL terminated file data
+ *                      stream.
+ * @param  token_count  [`size_t *`] Number of tokens in the array, including
+ *                      the `TOKEN_EOF` token.
+ * @return LexedToken*  Pointer to the token array, which is handed to the
+ *                      error trap, see `err_trap_own()`, and must be taken
+ *                      back, and released with `free()`.
+ */
+LexedToken *lex_file(char *file_data, size_t *token_count);
+
+/**
+ * @brief  Creates a lexing state, that lexes the source as the parser reaches
+ *         it, so that only a window of the tokens is held at once. The state
+ *         is allocated from the current arena.
+ *
+ * @param  file_data    [`char *`] Pointer to the NULL terminated file data
+ *                      stream.
+ * @return LexingState* Pointer to the new lexing state.
+ */
+LexingState *lex_stream_create(char *file_data);
 
 /**
- * @brief  Allocate a new token, with `token_length` and `data`.
+ * @brief  Releases the tokens before the next one, of a state created with
+ *         `lex_stream_create()`. It's only called between top-level
+ *         expressions, when nothing points to those tokens.
  *
- * @param  token_length  [`int`] Length of the token from the `data`
- *                       pointer.
- * @param  data          [`char *`] pointer to the data that is being
- *                       lexed.
- * @return LexedToken*   Pointer to the newly created token.
+ * @param  state  [`LexingState *`] Pointer to the lexing state.
+ * @return size_t Number of bytes of the source lexed so far, which are no
+ *                longer needed.
  */
-LexedToken *create_token(int token_length, char *data);
+size_t lex_stream_release(LexingState *state);
 
 /**
- * @brief  Check whether a line is a comment.
+ * @brief Releases all the tokens of a state created with
+ *        `lex_stream_create()`.
  *
- * @param  file_data   [`char *`] Pointer to the file data stream.
- * @return int        `1` for success and `0` for failure.
+ * @param state [`LexingState *`] Pointer to the lexing state.
  */
-int check_comment(char *file_data);
+void lex_stream_destroy(LexingState *state);
 
 /**
- * @brief  Create a new token from the file data stream.
+ * @brief  Moves to the next token in the token array, the `TOKEN_EOF` token
+ *         is never moved past.
  *
  * @param  state   [`LexingState *`] pointer to the current lexing state.
  */
 void lex_token(LexingState **state);
 
-void extend_curr_token(LexingState **state);
+/**
+ * @brief  Gets the next token, without moving to it.
+ *
+ * @param  state       [`LexingState *`] pointer to the current lexing state.
+ * @return LexedToken* Pointer to the next token.
+ */
+LexedToken *peek_token(LexingState *state);
 
 /**
- * @brief  Lexes the next token, and checks whether it's equal to the
- *         string that is expected next. If it's not, the data stream
- *         is reset to it's previous state..
+ * @brief  Checks whether the next token is the interned symbol, that is
+ *         expected next, and moves to it if so.
  *
- * @param  string_to_cmp  [`char *`] Pointer to the string, that needs
- *                        to be compared.
- * @param  state   [`LexingState *`] pointer to the current lexing state.
+ * @param  sym    [`const char *`] Pointer to the interned symbol, e.g. one
+ *                of `builtin_syms`.
+ * @param  state  [`LexingState *`] pointer to the current lexing state.
  */
-int check_next_token(char *string_to_cmp, LexingState **state);
+int check_next_token(const char *sym, LexingState **state);
 
 #ifdef __cplusplus
 }
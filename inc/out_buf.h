@@ -0,0 +1,191 @@
+#ifndef __OUT_BUF_H__
+#define __OUT_BUF_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Size of the buffer, that output is collected in before it's handed
+ *        to the sink.
+ */
+#define OUT_BUF_SIZE (64 * 1024)
+
+/**
+ * @brief Maximum number of characters in a formatted 64-bit integer.
+ */
+#define OUT_INT_MAX_CHARS 20
+
+/**
+ * @brief Function that receives the contents of a full buffer.
+ */
+typedef void (*OutSinkWrite)(void *sink_data, const char *data, size_t len);
+
+/**
+ * @brief Structure defining a buffered output stream. Output is appended to
+ *        `data`, and handed to the sink in large blocks. A stream without a
+ *        sink keeps all of its output in memory.
+ */
+typedef struct OutBuf {
+    char *data;              ///< Buffered output.
+    size_t used;             ///< Number of bytes in the buffer.
+    size_t size;             ///< Capacity of the buffer.
+    OutSinkWrite sink_write; ///< Sink for the output, NULL for memory.
+    void *sink_data;         ///< Data passed along to `sink_write`.
+    size_t bytes_flushed;    ///< Total bytes handed to the sink.
+    size_t flush_count;      ///< Number of calls made to the sink.
+} OutBuf;
+
+/**
+ * @brief Structure defining a string, whose length is known up-front, so
+ *        that it can be copied into a buffer without scanning it.
+ */
+typedef struct OutStr {
+    const char *str; ///< NULL terminated string.
+    size_t len;      ///< Length of the string.
+} OutStr;
+
+/**
+ * @brief Initializer for an `OutStr` from a string literal.
+ */
+#define OUT_STR(lit) {(lit), sizeof(lit) - 1}
+
+/**
+ * @brief  Creates an output stream, that writes through a custom sink.
+ *
+ * @param  sink_write [`OutSinkWrite`] Function receiving the output.
+ * @param  sink_data  [`void *`] Data passed along to `sink_write`.
+ * @return OutBuf*    Pointer to the newly created output stream.
+ */
+OutBuf *out_buf_create(OutSinkWrite sink_write, void *sink_data);
+
+/**
+ * @brief  Creates an output stream, that writes to a file descriptor.
+ *
+ * @param  fd      [`int`] File descriptor open for writing.
+ * @return OutBuf* Pointer to the newly created output stream.
+ */
+OutBuf *out_buf_create_fd(int fd);
+
+/**
+ * @brief  Creates an output stream, that keeps all of its output in memory.
+ *
+ * @return OutBuf* Pointer to the newly created output stream.
+ */
+OutBuf *out_buf_create_mem();
+
+/**
+ * @brief Makes room for `len` more bytes, either by handing the buffer to
+ *        the sink, or by growing it. Only called when the buffer is full.
+ *
+ * @param out [`OutBuf *`] Pointer to the output stream.
+ * @param len [`size_t`] Number of bytes about to be appended.
+ */
+void out_buf_make_room(OutBuf *out, size_t len);
+
+/**
+ * @brief Appends `len` bytes to the output stream.
+ *
+ * @param out  [`OutBuf *`] Pointer to the output stream.
+ * @param data [`const char *`] Bytes to append.
+ * @param len  [`size_t`] Number of bytes to append.
+ */
+static inline void out_buf_write(OutBuf *out, const char *data, size_t len) {
+    if (out->size - out->used < len) {
+        out_buf_make_room(out, len);
+        // Blocks larger than the buffer go straight to the sink.
+        if (out->size - out->used < len) {
+            out->sink_write(out->sink_data, data, len);
+            out->bytes_flushed += len;
+            out->flush_count += 1;
+            return;
+        }
+    }
+    memcpy(out->data + out->used, data, len);
+    out->used += len;
+}
+
+/**
+ * @brief Appends a NULL terminated string to the output stream.
+ *
+ * @param out [`OutBuf *`] Pointer to the output stream.
+ * @param str [`const char *`] String to append.
+ */
+static inline void out_buf_str(OutBuf *out, const char *str) {
+    out_buf_write(out, str, strlen(str));
+}
+
+/**
+ * @brief Appends a string of known length to the output stream.
+ *
+ * @param out [`OutBuf *`] Pointer to the output stream.
+ * @param str [`const OutStr *`] String to append.
+ */
+static inline void out_buf_ostr(OutBuf *out, const OutStr *str) {
+    out_buf_write(out, str->str, str->len);
+}
+
+/**
+ * @brief Appends a single character to the output stream.
+ *
+ * @param out [`OutBuf *`] Pointer to the output stream.
+ * @param c   [`char`] Character to append.
+ */
+static inline void out_buf_char(OutBuf *out, char c) {
+    if (out->used == out->size)
+        out_buf_make_room(out, 1);
+    out->data[out->used++] = c;
+}
+
+/**
+ * @brief Appends a signed integer in decimal to the output stream.
+ *
+ * @param out [`OutBuf *`] Pointer to the output stream.
+ * @param val [`int64_t`] Integer to append.
+ */
+void out_buf_int(OutBuf *out, int64_t val);
+
+/**
+ * @brief Appends formatted output to the output stream, this is the slow
+ *        path for output that doesn't fit the other helpers.
+ *
+ * @param out [`OutBuf *`] Pointer to the output stream.
+ * @param fmt [`const char *`] Format string for `vsnprintf()`.
+ */
+void out_buf_printf(OutBuf *out, const char *fmt, ...);
+
+/**
+ * @brief Hands everything in the buffer to the sink. Does nothing for
+ *        streams that are kept in memory.
+ *
+ * @param out [`OutBuf *`] Pointer to the output stream.
+ */
+void out_buf_flush(OutBuf *out);
+
+/**
+ * @brief  Releases an output stream, that is kept in memory, and hands its
+ *         output over to the caller.
+ *
+ * @param  out   [`OutBuf *`] Pointer to the output stream.
+ * @param  len   [`size_t *`] Set to the number of bytes of output.
+ * @return char* Pointer to the output, it's NULL terminated, and must be
+ *               released with `free()`.
+ */
+char *out_buf_release(OutBuf *out, size_t *len);
+
+/**
+ * @brief Flushes, and releases an output stream.
+ *
+ * @param out [`OutBuf *`] Pointer to the output stream.
+ */
+void out_buf_destroy(OutBuf *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __OUT_BUF_H__ */
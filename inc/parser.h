@@ -29,6 +29,38 @@ typedef enum NodeType {
     TYPE_ARR_INDEX,        ///< Node for storing the index access of an array.
 } NodeType;
 
+/**
+ * @brief Enumeration that defines the binary operators, binary operator nodes
+ *        store it in `ast_val.val`.
+ */
+typedef enum BinaryOp {
+    BIN_OP_NONE = 0, ///< Not a binary operator.
+    BIN_OP_EQ,       ///< `==`
+    BIN_OP_LT,       ///< `<`
+    BIN_OP_GT,       ///< `>`
+    BIN_OP_SHL,      ///< `<<`
+    BIN_OP_SHR,      ///< `>>`
+    BIN_OP_ADD,      ///< `+`
+    BIN_OP_SUB,      ///< `-`
+    BIN_OP_MUL,      ///< `*`
+    BIN_OP_DIV,      ///< `/`
+    BIN_OP_MOD,      ///< `%`
+
+    BIN_OP_COUNT,
+} BinaryOp;
+
+/**
+ * @brief Enumeration that defines the types of a binary operator, i.e. the
+ *        type it returns, and the types of its operands.
+ */
+typedef enum BinaryOpType {
+    BIN_OP_TYPE_RET = 0, ///< Return type.
+    BIN_OP_TYPE_LHS,     ///< Type of the left hand side operand.
+    BIN_OP_TYPE_RHS,     ///< Type of the right hand side operand.
+
+    BIN_OP_TYPE_COUNT,
+} BinaryOpType;
+
 /**
  * @brief Structure defining the value for an AST Node.
  */
@@ -41,16 +73,49 @@ typedef struct NodeVal {
  * @brief Structure defining a node in the AST (Abstract Syntax Tree).
  */
 typedef struct AstNode {
-    int type;                   ///< Enum for the type of the node.
-    NodeVal ast_val;            ///< Struct for storing the value
-                                ///< of the node.
-    struct AstNode *child;      ///< Child node for this node.
-    struct AstNode *next_child; ///< Next child for this node.
-    int result_reg_desc;        ///< Register descriptor for stroing the
-                                ///< rersult.
-    unsigned int pointer_level; ///< Indirection level for a pointer.
+    int type;                     ///< Enum for the type of the node.
+    NodeVal ast_val;              ///< Struct for storing the value
+                                  ///< of the node.
+    struct AstNode *child;        ///< Child node for this node.
+    struct AstNode *next_child;   ///< Next child for this node.
+    int result_reg_desc;          ///< Register descriptor for stroing the
+                                  ///< rersult.
+    unsigned int pointer_level;   ///< Indirection level for a pointer.
+    struct AstNode *val_type;     ///< Type of the value of the node, set by
+                                  ///< the type checker, and shared.
+    long val_size;                ///< Size of `val_type` in bytes, set for
+                                  ///< declared variables, and array indexes.
+    struct Symbol *sym;           ///< Variable declared, or accessed by the
+                                  ///< node, bound by the parser.
+    struct ParsingContext *scope; ///< Context entered for the expressions
+                                  ///< under the node, set by the parser on
+                                  ///< the bodies of functions, and if-else
+                                  ///< statements.
+    struct AstNode *last_child;   ///< Last child added through
+                                  ///< `add_ast_node_child()`, NULL if none.
 } AstNode;
 
+/**
+ * @brief Structure defining the record for a declared variable. Every
+ *        access to the variable points to its record, so that later passes
+ *        never look it up by name.
+ */
+typedef struct Symbol {
+    char *name;         ///< Interned name of the variable.
+    AstNode *type;      ///< Type of the variable.
+    unsigned int depth; ///< Depth of the declaring scope, 0 for globals.
+    char is_local;      ///< Declared in a function, and kept in its frame,
+                        ///< rather than in the `.data` section.
+    long frame_offset;  ///< Offset from the frame base, set by code
+                        ///< generation once it allocates the variable.
+} Symbol;
+
+/**
+ * @brief Initial number of slots in the hash table of an environment, must
+ *        be a power of 2.
+ */
+#define ENV_INIT_SLOTS 8
+
 /**
  * @brief Structure defining binding for an identifier, i.e. a node for
  *        the identifier, and it's value.
@@ -58,16 +123,23 @@ typedef struct AstNode {
 typedef struct IdentifierBind {
     AstNode *identifier;                 ///< Node for the identifier.
     AstNode *id_val;                     ///< Node for the value.
-    struct IdentifierBind *next_id_bind; ///< Pointer to the next binding.
+    struct IdentifierBind *next_id_bind; ///< Pointer to the next binding,
+                                         ///< in insertion order.
 } IdentifierBind;
 
 /**
  * @brief Structure defining an environment which contains the binding, and
- *        a parent environment.
+ *        a parent environment. Bindings are kept in an open addressing hash
+ *        table keyed by the interned identifier symbol, and are also chained
+ *        in insertion order.
  */
 typedef struct Env {
-    IdentifierBind *binding; ///< Pointer to the binding.
-    struct Env *parent_env;  ///< Pointer to the parent environment.
+    IdentifierBind *binding;      ///< Pointer to the first binding.
+    IdentifierBind *last_binding; ///< Pointer to the last binding.
+    IdentifierBind **slots;       ///< Hash table for the bindings.
+    unsigned long slots_size;     ///< Number of slots in the hash table.
+    unsigned long bind_count;     ///< Number of bindings.
+    struct Env *parent_env;       ///< Pointer to the parent environment.
 } Env;
 
 typedef struct ParsingStack {
@@ -77,6 +149,8 @@ typedef struct ParsingStack {
     AstNode *res; ///< Pointer to an AstNode to keep track of the list
                   ///< of expressions in a function body.
     AstNode *body;
+    AstNode *outer_root; ///< Root of the expression, that a function call
+                         ///< is an operand of.
 } ParsingStack;
 
 /**
@@ -86,11 +160,35 @@ typedef struct ParsingStack {
 typedef struct ParsingContext {
     struct ParsingContext *child;
     struct ParsingContext *next_child;
+    struct ParsingContext *last_child; ///< Last child, for O(1) appends.
     struct ParsingContext *parent_ctx; ///< Pointer to the parent context.
     Env *env_type;                     ///< Pointer to an environment for types.
     Env *vars;       ///< Pointer to an environment for varaibles.
     Env *funcs;      ///< Pointer to an environment for functions.
     Env *binary_ops; ///< Pointer to an environment for binary operators.
+    struct ParsingContext *global_ctx; ///< Pointer to the root context.
+    /// Nearest enclosing context, that had variables declared in it, when
+    /// this one was created. Variables are only declared in the current
+    /// context, so the ones in between stay empty while this one is open.
+    struct ParsingContext *outer_vars_ctx;
+    unsigned int depth; ///< Number of enclosing contexts, 0 for the root.
+    char is_func_scope; ///< Inside a function body, or parameter list.
+    unsigned char *op_ids; ///< `BinaryOp` for every intern id, i.e.
+                           ///< `BIN_OP_NONE` for anything that isn't a
+                           ///< binary operator. Only set in the root context.
+    unsigned int op_ids_size; ///< Number of entries in `op_ids`.
+    long op_prec[BIN_OP_COUNT]; ///< Precedence of every binary operator.
+    const AstNode *op_data[BIN_OP_COUNT]; ///< Precedence, return, LHS and
+                                          ///< RHS types of every binary
+                                          ///< operator.
+
+    /// Canonical return, LHS and RHS types of every binary operator.
+    AstNode *op_types[BIN_OP_COUNT][BIN_OP_TYPE_COUNT];
+    struct TypeTable *types; ///< Canonical types of the program. Only set in
+                             ///< the root context.
+    struct Arena *arena;     ///< Arena the context was allocated from, the
+                             ///< variables bound in it are allocated from it
+                             ///< too, so they live as long as the context.
 } ParsingContext;
 
 typedef enum StackOpRetVal {
@@ -143,17 +241,89 @@ void ast_add_type_node(Env **env_type, int node_type, AstNode *sym,
 void ast_add_binary_ops(ParsingContext **context, char *bin_op, int precedence,
                         char *ret_type, char *lhs_type, char *rhs_type);
 
+/**
+ * @brief  Gets the binary operator for the intern id of a token.
+ *
+ * @param  context  [`ParsingContext *`] Pointer to any parsing context.
+ * @param  op_id    [`unsigned int`] Intern id of the token.
+ * @return BinaryOp The binary operator, or `BIN_OP_NONE` if the token isn't
+ *                  a binary operator.
+ */
+BinaryOp parser_get_binary_op(ParsingContext *context, unsigned int op_id);
+
+/**
+ * @brief  Gets the precedence, return, LHS and RHS types of a binary
+ *         operator, in that order, as the children of the returned node.
+ *
+ * @param  context        [`ParsingContext *`] Pointer to any parsing context.
+ * @param  op             [`BinaryOp`] The binary operator.
+ * @return const AstNode* Borrowed node with the operator's data.
+ */
+const AstNode *parser_get_binary_op_data(ParsingContext *context, BinaryOp op);
+
+/**
+ * @brief  Gets the canonical return, or operand type of a binary operator.
+ *
+ * @param  context  [`ParsingContext *`] Pointer to any parsing context.
+ * @param  op       [`BinaryOp`] The binary operator.
+ * @param  which    [`BinaryOpType`] The type to get.
+ * @return AstNode* The canonical type.
+ */
+AstNode *parser_get_binary_op_type(ParsingContext *context, BinaryOp op,
+                                   BinaryOpType which);
+
+/**
+ * @brief Appends a child context to `root` in constant time. Cycles are not
+ *        checked for here, see `parser_verify_context()`.
+ *
+ * @param root         [`ParsingContext **`] Double pointer to the parent
+ *                     context.
+ * @param child_to_add [`ParsingContext *`] Pointer to the new child context.
+ */
 void add_parsing_context_child(ParsingContext **root,
                                ParsingContext *child_to_add);
 
+/**
+ * @brief Checks that the context tree under `context` is well formed, i.e.
+ *        that no list of child contexts loops back on itself, and that every
+ *        child points back to its parent. Only called in debug builds, it
+ *        exits with an error on the first broken link.
+ *
+ * @param context [`ParsingContext *`] Pointer to the root of the tree.
+ */
+void parser_verify_context(ParsingContext *context);
+
 /**
  * @brief Lexes and parses a complete file.
  *
- * @param file_data   [`char *`] pointer to the data stream.
+ * @param file_data    [`char *`] NULL terminated contents of the file.
+ * @param curr_context [`ParsingContext **`] Double pointer to the
+ *                     global context.
+ * @param program      [`AstNode **`] Double pointer to the program node.
  */
-void lex_and_parse(char *file_dest, ParsingContext **curr_context,
+void lex_and_parse(char *file_data, ParsingContext **curr_context,
                    AstNode **program);
 
+/**
+ * @brief  Parses the next top-level expression.
+ *
+ * @param  state        [`LexingState *`] Pointer to the current lexing state.
+ * @param  curr_context [`ParsingContext **`] Double pointer to the global
+ *                      context.
+ * @return AstNode*     The expression, which may be a `TYPE_NULL` node, NULL
+ *                      at the end of the source.
+ */
+AstNode *parse_next_expr(LexingState *state, ParsingContext **curr_context);
+
+/**
+ * @brief Drops the child contexts of the root context, opened by the
+ *        expressions parsed so far, e.g. for function bodies. Used when those
+ *        expressions are released, after their code has been generated.
+ *
+ * @param context [`ParsingContext *`] Pointer to the root context.
+ */
+void parser_drop_child_contexts(ParsingContext *context);
+
 int check_if_delims(LexedToken *token);
 
 int check_invalid_var_access(ParsingContext *context, AstNode *sym_node);
@@ -163,34 +333,44 @@ void parse_func_vars(AstNode **function_type, LexingState **state,
 
 void print_parsing_context(ParsingContext *context, int indent);
 
+/**
+ * @brief  Parses a binary operator following a complete operand, using
+ *         precedence climbing. The operator node is slotted into the right
+ *         spine of the expression under `expr_root`, so that no part of the
+ *         expression is ever copied.
+ *
+ * @param  state        [`LexingState **`] Double pointer to the lexing state.
+ * @param  context      [`ParsingContext **`] Double pointer to the current
+ *                      context.
+ * @param  expr_root    [`AstNode **`] Pointer to the node, where the current
+ *                      expression starts.
+ * @param  running_expr [`AstNode **`] Pointer in which the node for the right
+ *                      hand side operand is stored.
+ * @return int          `1` if a binary operator was parsed, `0` otherwise.
+ */
 int parse_binary_infix_op(LexingState **state, ParsingContext **context,
-                          long *running_precedence, AstNode **curr_expr,
-                          AstNode **running_expr, ParsingStack *curr_stack);
+                          AstNode **expr_root, AstNode **running_expr);
 
 StackOpRetVal
 stack_operator_continue(ParsingStack **curr_stack, LexingState **state,
                         AstNode **running_expr, ParsingContext **context,
-                        long *running_precedence, AstNode **curr_expr);
+                        AstNode **expr_root);
 
-AstNode *parse_type(AstNode **type_node, LexingState **state,
-                    ParsingContext *context, int *status);
+const AstNode *parse_type(AstNode **type_node, LexingState **state,
+                          ParsingContext *context, int *status);
 
-int check_if_type(char *temp_file_data, ParsingContext *context);
+int check_if_type(LexingState *state, ParsingContext *context);
 /**
- * @brief Parses tokens (TODO!!), and advances the pointer that
- *        points to the file data stream.
+ * @brief Parses tokens (TODO!!), and advances the lexing state past
+ *        the parsed expression.
  *
- * @param temp_file_data [`char **`] Double-pointer to the
- *                       file data stream.
- * @param curr_token     [`LexedToken *`] Pointer in which the next
- *                       token is stored.
+ * @param state          [`LexingState *`] Pointer to the lexing state.
  * @param curr_expr      [`AstNode **`] Pointer to the node which
  *                       stores the current expression.
  * @param context        [`ParsingContext **`] Double pointer to
  *                       the current context.
- * @return char*         Pointer to the file data stream.
  */
-char *parse_tokens(LexingState *state, AstNode **curr_expr,
+void parse_tokens(LexingState *state, AstNode **curr_expr,
                    ParsingContext **context);
 
 #ifdef __cplusplus
@@ -0,0 +1,112 @@
+#ifndef __PASS_STATS_H__
+#define __PASS_STATS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * @brief Enumeration for the phases of a compilation, that are timed.
+ */
+typedef enum Pass {
+    PASS_READ,       ///< Reading, or mapping the source file.
+    PASS_LEX_PARSE,  ///< Lexing, and parsing the source.
+    PASS_TYPE_CHECK, ///< Type checking the program.
+    PASS_CODEGEN,    ///< Code generation, including the output writes.
+    PASS_WRITE,      ///< Writing the generated code to the output file.
+    PASS_COUNT,
+} Pass;
+
+/**
+ * @brief Enumeration for the formats of the pass report.
+ */
+typedef enum PassReportFormat {
+    PASS_REPORT_HUMAN, ///< Aligned table, for reading in a terminal.
+    PASS_REPORT_JSON,  ///< Single JSON object, for tools.
+} PassReportFormat;
+
+/**
+ * @brief Structure defining the time spent in a pass.
+ */
+typedef struct PassTime {
+    double wall_ms; ///< Elapsed wall clock time.
+    double cpu_ms;  ///< CPU time of the whole process, i.e. every thread.
+} PassTime;
+
+/**
+ * @brief Structure defining a running timer, for a single pass.
+ */
+typedef struct PassTimer {
+    struct timespec wall_start; ///< Wall clock time when the timer started.
+    struct timespec cpu_start;  ///< Process CPU time when the timer started.
+} PassTimer;
+
+/**
+ * @brief Structure defining the times, and counters for a compilation. The
+ *        counters are bumped unconditionally, they are cheap enough to keep
+ *        in the hot paths.
+ */
+typedef struct PassStats {
+    PassTime times[PASS_COUNT]; ///< Time spent in every pass.
+    size_t tokens_lexed;        ///< Tokens produced by the lexer.
+    size_t ast_nodes;           ///< Calls to `node_alloc()`.
+    size_t env_lookups;         ///< Lookups in an environment table.
+    size_t env_probes;          ///< Slots walked by those lookups.
+    size_t copy_node_calls;     ///< Calls to `copy_node()`.
+    size_t regs_allocated;      ///< Registers handed out by `reg_alloc()`.
+    size_t insts_emitted;       ///< Instructions in the generated code.
+    size_t func_cache_hits;     ///< Functions reused from the cache.
+    size_t func_cache_misses;   ///< Functions generated, and then cached.
+} PassStats;
+
+/**
+ * @brief Stats for the compilation running on the current thread.
+ */
+extern _Thread_local PassStats pass_stats;
+
+/**
+ * @brief Clears the stats for the current thread.
+ */
+void pass_stats_reset();
+
+/**
+ * @brief Adds the counters in `src` to the stats for the current thread,
+ *        times are left as is.
+ *
+ * @param src [`const PassStats *`] Counters collected on another thread.
+ */
+void pass_stats_merge(const PassStats *src);
+
+/**
+ * @brief Starts timing a pass.
+ *
+ * @param timer [`PassTimer *`] Pointer to the timer.
+ */
+void pass_timer_start(PassTimer *timer);
+
+/**
+ * @brief Stops timing a pass, and adds the time elapsed to it.
+ *
+ * @param timer [`PassTimer *`] Pointer to the timer.
+ * @param pass  [`Pass`] Pass that was being timed.
+ */
+void pass_timer_stop(PassTimer *timer, Pass pass);
+
+/**
+ * @brief Prints the time spent in every pass, and the counters. Code
+ *        generation is reported without the output writes, that it contains.
+ *
+ * @param fptr   [`FILE *`] Stream to print to.
+ * @param format [`PassReportFormat`] Format of the report.
+ */
+void pass_stats_print(FILE *fptr, PassReportFormat format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PASS_STATS_H__ */
@@ -0,0 +1,99 @@
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sypherc.h"
+#include <stdint.h>
+
+/**
+ * @brief Marks the start of every request, and response, so that anything
+ *        else on the socket is rejected early.
+ */
+#define SERVER_MAGIC 0x48505953 // "SYPH" in little endian.
+
+/**
+ * @brief Largest source accepted in a single request.
+ */
+#define SERVER_MAX_SRC_LEN (64UL * 1024 * 1024)
+
+/**
+ * @brief Connections listened for, before the server accepts them.
+ */
+#define SERVER_BACKLOG 64
+
+/**
+ * @brief Seconds for which an idle connection is kept open.
+ */
+#define SERVER_IDLE_TIMEOUT 30
+
+/**
+ * @brief Structure defining the header of a compile request, followed by
+ *        `src_len` bytes of source. A connection can carry any number of
+ *        requests, one after the other.
+ */
+typedef struct ServerRequest {
+    uint32_t magic;        ///< `SERVER_MAGIC`.
+    uint32_t out_fmt;      ///< `TargetFormat`.
+    uint32_t call_conv;    ///< `TargetCallingConvention`.
+    uint32_t dialect;      ///< `TargetAssemblyDialect`.
+    uint32_t codegen_jobs; ///< Threads generating function bodies.
+    uint32_t reserved;     ///< Padding, must be 0.
+    uint64_t src_len;      ///< Size of the source that follows.
+} ServerRequest;
+
+/**
+ * @brief Structure defining the header of a response, followed by
+ *        `data_len` bytes of assembly, or of the error message.
+ */
+typedef struct ServerResponse {
+    uint32_t magic;    ///< `SERVER_MAGIC`.
+    int32_t status;    ///< Value returned by `sypher_compile()`.
+    uint32_t err;      ///< `ErrType` of the error, if `status` isn't 0.
+    uint32_t reserved; ///< Padding, must be 0.
+    uint64_t data_len; ///< Size of the data that follows.
+} ServerResponse;
+
+/**
+ * @brief Serves compile requests on a Unix domain socket, until the process
+ *        gets `SIGINT`, or `SIGTERM`. Connections are served by a pool of
+ *        workers, each keeping its intern tables warm between requests.
+ *
+ * @param sock_path [`const char *`] Path to bind the socket to, it's
+ *                  removed when the server stops.
+ * @param jobs      [`int`] Number of connections served at once.
+ */
+void server_run(const char *sock_path, int jobs);
+
+/**
+ * @brief  Connects to a server.
+ *
+ * @param  sock_path [`const char *`] Path to the socket of the server.
+ * @return int       File descriptor of the connection.
+ */
+int server_connect(const char *sock_path);
+
+/**
+ * @brief  Compiles a program on a server, with the same results as
+ *         `sypher_compile()`. Failing to talk to the server is reported with
+ *         `print_error()`.
+ *
+ * @param  sock_fd [`int`] Connection to the server.
+ * @param  src     [`const char *`] Source of the program.
+ * @param  len     [`size_t`] Size of the source.
+ * @param  opts    [`const SypherOptions *`] Options for the compilation,
+ *                 NULL for the defaults.
+ * @param  out     [`SypherOutput *`] Pointer in which the assembly, or the
+ *                 error is stored.
+ * @return int     0 on success, -1 if the compilation failed.
+ */
+int server_compile(int sock_fd, const char *src, size_t len,
+                   const SypherOptions *opts, SypherOutput *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SERVER_H__ */
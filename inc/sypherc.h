@@ -0,0 +1,84 @@
+#ifndef __SYPHERC_H__
+#define __SYPHERC_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "code_gen.h"
+#include "utils.h"
+
+/**
+ * @brief Number of interned strings, above which the intern tables for a
+ *        thread are released after a compilation, rather than kept warm for
+ *        the next one.
+ */
+#define SYPHER_INTERN_KEEP_MAX 65536
+
+/**
+ * @brief Structure defining the options for a compilation, through the
+ *        library.
+ */
+typedef struct SypherOptions {
+    TargetFormat out_fmt;              ///< Output format.
+    TargetCallingConvention call_conv; ///< Calling convention.
+    TargetAssemblyDialect dialect;     ///< Assembly dialect.
+    int codegen_jobs; ///< Threads generating function bodies, 1 for none.
+    const char *func_cache_dir; ///< Function cache, NULL when not caching.
+} SypherOptions;
+
+/**
+ * @brief Structure defining the result of a compilation, through the
+ *        library.
+ */
+typedef struct SypherOutput {
+    char *code;                 ///< NULL terminated assembly, NULL on error.
+    size_t code_len;            ///< Size of the assembly.
+    ErrType err;                ///< Type of the error, if one was reported.
+    char err_msg[ERR_MSG_SIZE]; ///< Message of the error, empty on success.
+} SypherOutput;
+
+/**
+ * @brief Fills in the options used by `sypherc`, when none are passed.
+ *
+ * @param opts [`SypherOptions *`] Pointer to the options.
+ */
+void sypher_options_default(SypherOptions *opts);
+
+/**
+ * @brief  Compiles a program held in memory, into assembly held in memory.
+ *         Errors are returned in `out`, rather than printed, and the process
+ *         is never exited. Every compilation has state of its own, so
+ *         different threads can compile at the same time. The intern tables
+ *         for the calling thread are kept for its next compilation.
+ *
+ * @param  src  [`const char *`] Source of the program, need not be NULL
+ *              terminated.
+ * @param  len  [`size_t`] Size of the source.
+ * @param  opts [`const SypherOptions *`] Options for the compilation, NULL
+ *              for the defaults.
+ * @param  out  [`SypherOutput *`] Pointer in which the assembly, or the
+ *              error is stored.
+ * @return int  0 on success, -1 if an error was reported.
+ */
+int sypher_compile(const char *src, size_t len, const SypherOptions *opts,
+                   SypherOutput *out);
+
+/**
+ * @brief Releases the assembly held by an output.
+ *
+ * @param out [`SypherOutput *`] Pointer to the output.
+ */
+void sypher_output_free(SypherOutput *out);
+
+/**
+ * @brief Releases the state kept for the calling thread between
+ *        compilations, i.e. its intern tables.
+ */
+void sypher_release_thread();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SYPHERC_H__ */
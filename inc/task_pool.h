@@ -0,0 +1,77 @@
+#ifndef __TASK_POOL_H__
+#define __TASK_POOL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+
+/**
+ * @brief Function run by a worker for a single task.
+ */
+typedef void (*TaskFunc)(void *task_data);
+
+/**
+ * @brief Structure defining a single queued task.
+ */
+typedef struct Task {
+    TaskFunc func;     ///< Function to run.
+    void *task_data;   ///< Data passed along to `func`.
+    struct Task *next; ///< Next task in the queue.
+} Task;
+
+/**
+ * @brief Structure defining a fixed set of worker threads, that run tasks in
+ *        the order they were submitted. Every worker has an arena of its own
+ *        set as its current arena, which lives as long as the pool.
+ */
+typedef struct TaskPool {
+    pthread_t *workers;        ///< Worker threads.
+    int worker_count;          ///< Number of worker threads.
+    Task *queue_head;          ///< Next task to run.
+    Task *queue_tail;          ///< Last task submitted.
+    long pending_count;        ///< Tasks submitted, but not yet finished.
+    char is_stopping;          ///< Set when the pool is being destroyed.
+    pthread_mutex_t lock;      ///< Lock for the queue, and the counters.
+    pthread_cond_t task_ready; ///< Signalled when a task is queued.
+    pthread_cond_t tasks_done; ///< Signalled when `pending_count` hits 0.
+} TaskPool;
+
+/**
+ * @brief  Creates a task pool, and starts its workers.
+ *
+ * @param  worker_count [`int`] Number of worker threads, at least 1.
+ * @return TaskPool*    Pointer to the newly created task pool.
+ */
+TaskPool *task_pool_create(int worker_count);
+
+/**
+ * @brief Queues a task, to be run on one of the workers.
+ *
+ * @param pool      [`TaskPool *`] Pointer to the task pool.
+ * @param func      [`TaskFunc`] Function to run.
+ * @param task_data [`void *`] Data passed along to `func`.
+ */
+void task_pool_submit(TaskPool *pool, TaskFunc func, void *task_data);
+
+/**
+ * @brief Waits until every submitted task has finished.
+ *
+ * @param pool [`TaskPool *`] Pointer to the task pool.
+ */
+void task_pool_wait(TaskPool *pool);
+
+/**
+ * @brief Waits for the submitted tasks, stops the workers, and releases the
+ *        task pool, along with the arenas of the workers.
+ *
+ * @param pool [`TaskPool *`] Pointer to the task pool.
+ */
+void task_pool_destroy(TaskPool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TASK_POOL_H__ */
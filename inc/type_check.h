@@ -9,14 +9,11 @@ extern "C" {
 
 int cmp_type(AstNode *node1, AstNode *node2);
 
-int cmp_type_sym(AstNode *node1, AstNode *node2);
-
 void print_type(AstNode *expr, AstNode *expected_type, AstNode *got_type);
 
 void type_check_prog(ParsingContext *context, AstNode *prog);
 
-AstNode *type_check_expr(ParsingContext *context,
-                         ParsingContext **context_to_enter, AstNode *expr);
+AstNode *type_check_expr(ParsingContext *context, AstNode *expr);
 
 #ifdef __cplusplus
 }
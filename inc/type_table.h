@@ -0,0 +1,103 @@
+#ifndef __TYPE_TABLE_H__
+#define __TYPE_TABLE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "parser.h"
+#include <stdint.h>
+
+/**
+ * @brief Initial number of slots in the type table, must be a power of 2.
+ */
+#define TYPE_TABLE_INIT_SLOTS 64
+
+/**
+ * @brief Structure defining a canonical type. Every distinct type, i.e. a
+ *        base type, at a pointer level, an array of `N` elements, or a
+ *        function signature, has exactly one, so two types are the same iff
+ *        their canonical types are. Only its size is worked out, once, when
+ *        it's created. `node` comes first, so that a canonical type is
+ *        passed around as an `AstNode *`.
+ */
+typedef struct CanonType {
+    AstNode node;                   ///< The type, with children private to it.
+    long size;                      ///< Size in bytes, `-1` for nodes that
+                                    ///< aren't types, e.g. array sizes.
+    uint64_t hash;                  ///< Hash of the structure of the type.
+    unsigned int child_count;       ///< Number of children of `node`.
+    struct CanonType **child_types; ///< Canonical type of every child.
+    struct CanonType *pointer_to;   ///< Type one pointer level up, NULL
+                                    ///< until it's first asked for.
+    struct CanonType *pointee;      ///< Type one pointer level down.
+} CanonType;
+
+/**
+ * @brief Structure defining the table of canonical types of a program. Only
+ *        the root context has one.
+ */
+typedef struct TypeTable {
+    CanonType **slots;        ///< Open addressing hash table of the types.
+    unsigned long slots_size; ///< Number of slots in the hash table.
+    unsigned long type_count; ///< Number of canonical types.
+    AstNode *int_type;        ///< Canonical type of integer literals.
+    AstNode *none_type;       ///< Canonical type of nodes without a value.
+    struct Arena *arena;      ///< Arena the table, and every canonical type
+                              ///< is allocated from.
+} TypeTable;
+
+/**
+ * @brief  Creates an empty type table, in the current arena, which canonical
+ *         types are allocated from, even once another arena is current.
+ *
+ * @return TypeTable* Pointer to the new table.
+ */
+TypeTable *create_type_table();
+
+/**
+ * @brief  Gets the canonical type, that is structurally equal to `type`,
+ *         creating it, and working out its size the first time.
+ *
+ * @param  context  [`ParsingContext *`] Pointer to any parsing context, types
+ *                  are looked up from it.
+ * @param  type     [`const AstNode *`] Type to look up, it isn't modified.
+ * @return AstNode* The canonical type.
+ */
+AstNode *type_canon(ParsingContext *context, const AstNode *type);
+
+/**
+ * @brief  Gets the canonical type of a child of a canonical type, e.g. the
+ *         return type of a function is child `0`.
+ *
+ * @param  type     [`const AstNode *`] Canonical type.
+ * @param  idx      [`unsigned int`] Index of the child.
+ * @return AstNode* The canonical type of the child, NULL if there is none.
+ */
+AstNode *type_child(const AstNode *type, unsigned int idx);
+
+/**
+ * @brief  Gets the canonical type, `levels` pointer levels away from a
+ *         canonical type, e.g. `1` for taking its address, and `-1` for
+ *         dereferencing it.
+ *
+ * @param  context  [`ParsingContext *`] Pointer to any parsing context.
+ * @param  type     [`const AstNode *`] Canonical type.
+ * @param  levels   [`int`] Number of pointer levels to add, or remove.
+ * @return AstNode* The canonical type.
+ */
+AstNode *type_pointer(ParsingContext *context, const AstNode *type, int levels);
+
+/**
+ * @brief  Gets the size of a canonical type.
+ *
+ * @param  type [`const AstNode *`] Canonical type.
+ * @return long Size in bytes, `-1` if the size isn't known.
+ */
+long type_size(const AstNode *type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TYPE_TABLE_H__ */
@@ -5,6 +5,7 @@
 extern "C" {
 #endif
 
+#include <setjmp.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -22,7 +23,7 @@ extern "C" {
     "A Compiler for Sypher\n"                                                  \
     "\n"                                                                       \
     "\033[1;33mUSAGE:\033[1;37m\n"                                             \
-    "    sypherc [OPTIONS] INPUT_FILE\n"                                       \
+    "    sypherc [OPTIONS] INPUT_FILE...\n"                                    \
     "\n"                                                                       \
     "\033[1;33mOPTIONS:\033[1;37m\n"                                           \
     "    \033[1;35m-cc, --call-conv <CALLING_CONVENTION>\033[1;37m\n"          \
@@ -32,6 +33,23 @@ extern "C" {
     "            - `linux`\n"                                                  \
     "            - `windows`\n"                                                \
     "\n"                                                                       \
+    "    \033[1;35m-cd, --cache-dir <DIR>\033[1;37m\n"                         \
+    "            Copy out the code for files, that were compiled before\n"     \
+    "            with the same options, from a cache in DIR, rather than\n"    \
+    "            compiling them again\n"                                       \
+    "\n"                                                                       \
+    "    \033[1;35m-cms, --cache-max-size <MIB>\033[1;37m\n"                   \
+    "            Bound on the size of the cache, least recently used\n"        \
+    "            files are evicted to keep under it (default 256)\n"           \
+    "\n"                                                                       \
+    "    \033[1;35m-cs, --cache-stats\033[1;37m\n"                             \
+    "            Print out the hits, misses, and evictions in the cache,\n"    \
+    "            and its size\n"                                               \
+    "\n"                                                                       \
+    "    \033[1;35m-cj, --codegen-jobs <JOBS>\033[1;37m\n"                     \
+    "            Number of threads generating function bodies, output\n"       \
+    "            is identical for any number (default 1)\n"                    \
+    "\n"                                                                       \
     "    \033[1;35m-ad, --asm-dialect <ASSEMBLY_DIALECT>\033[1;37m\n"          \
     "            A valid assembly dialect for code generation\n"               \
     "            VALID ASSEMBLY DIALECTS:\n"                                   \
@@ -45,26 +63,91 @@ extern "C" {
     "            - `default`\n"                                                \
     "            - `x86_64-gnu-as`\n"                                          \
     "\n"                                                                       \
+    "    \033[1;35m-fc, --func-cache <DIR>\033[1;37m\n"                        \
+    "            Reuse the code generated for functions, that are\n"           \
+    "            unchanged since an earlier compilation, cached in DIR\n"      \
+    "\n"                                                                       \
+    "    \033[1;35m-fcs, --func-cache-stats\033[1;37m\n"                       \
+    "            Print out the number of functions, found and not found\n"     \
+    "            in the function cache\n"                                      \
+    "\n"                                                                       \
     "    \033[1;35m-h, --help\033[1;37m\n"                                     \
     "            Print this help information\n"                                \
     "\n"                                                                       \
     "    \033[1;35m-i, --input <INPUT_FILE_PATH>\033[1;37m\n"                  \
-    "            Path to the input file\n"                                     \
+    "            Path to the input file, `-` reads from stdin\n"               \
+    "\n"                                                                       \
+    "    \033[1;35m-j, --jobs <JOBS>\033[1;37m\n"                              \
+    "            Number of input files compiled at once, when more than\n"     \
+    "            one is passed (default 1)\n"                                  \
     "\n"                                                                       \
     "    \033[1;35m-o, --output <OUTPUT_FILE_PATH>\033[1;37m\n"                \
     "            Path to the output file\n"                                    \
     "\n"                                                                       \
+    "    \033[1;35m-sv, --server <SOCK_PATH>\033[1;37m\n"                      \
+    "            Serve compile requests on a Unix domain socket, until\n"      \
+    "            stopped with SIGINT or SIGTERM, `-j` sets the number of\n"    \
+    "            connections served at once (default: cpus online)\n"          \
+    "\n"                                                                       \
+    "    \033[1;35m-cl, --client <SOCK_PATH>\033[1;37m\n"                      \
+    "            Compile the input files on a server, instead of in this\n"    \
+    "            process, the output is the same\n"                            \
+    "\n"                                                                       \
+    "    \033[1;35m-st, --stream\033[1;37m\n"                                  \
+    "            Compile every top-level expression, and release it\n"         \
+    "            before parsing the next one, so that memory use stays\n"      \
+    "            flat for large inputs, the data section is written last\n"    \
+    "\n"                                                                       \
+    "    \033[1;35m-ms, --mem-stats\033[1;37m\n"                               \
+    "            Print out the arena memory used by every compiler phase\n"    \
+    "            and the size of the AST\n"                                    \
+    "\n"                                                                       \
+    "    \033[1;35m-tp, --time-passes\033[1;37m\n"                             \
+    "            Print out the time taken by every compiler phase, and\n"      \
+    "            counters for the work done in them\n"                         \
+    "\n"                                                                       \
+    "    \033[1;35m-tpf, --time-passes-format <REPORT_FORMAT>\033[1;37m\n"     \
+    "            Format of the `-tp` report, implies `-tp` (default\n"         \
+    "            `human`)\n"                                                   \
+    "            VALID REPORT FORMATS:\n"                                      \
+    "            - `default`\n"                                                \
+    "            - `human`\n"                                                  \
+    "            - `json`\n"                                                   \
+    "\n"                                                                       \
     "    \033[1;35m-v, --version\033[1;37m\n"                                  \
     "            Print out current version of Sypherize\n"                     \
     "\n"                                                                       \
     "    \033[1;35m-V, --verbose\033[1;37m\n"                                  \
-    "            Print out extra debugging information\n"                      \
+    "            Print out extra debugging information, and the time\n"        \
+    "            taken to read the input\n"                                    \
     "\n"                                                                       \
-    "NOTE - Everything else is treated as an input file\n"                     \
+    "NOTE - Everything else is treated as an input file, with more than one,\n"\
+    "       every file is compiled into its default output file, and errors\n" \
+    "       are reported once all of them are done\n"                          \
     "\n"
 
 #define VERSION_STRING "Sypherize 0.1\n"
 
+/**
+ * @brief Maximum length of the build identity, including the NULL.
+ */
+#define BUILD_ID_SIZE 24
+
+/**
+ * @brief  Gets the identity of this build of the compiler, the time it was
+ *         built at. `make` rebuilds every object, so any change to the
+ *         compiler gets a new identity, that the caches are keyed on.
+ *
+ * @return const char* NULL terminated build identity.
+ */
+const char *build_id();
+
+/**
+ * @brief Output file used for a program read from `stdin`, when no output
+ *        file is passed.
+ */
+#define STDIN_OUT_FILE "stdin.s"
+
 /**
  * @brief Checks if a `ptr` is NULL, is so calls `print_error`, with exit
  *        enabled.
@@ -94,6 +177,7 @@ typedef enum ErrType {
     ERR_FILE_OPEN,
     ERR_FILE_SIZE,
     ERR_FILE_READ,
+    ERR_FILE_WRITE,
     ERR_SYNTAX,
     ERR_REDEFINITION,
     ERR_EOF,
@@ -105,11 +189,120 @@ typedef enum ErrType {
 
 extern const char *err_strings[ERR_COUNT];
 
+/**
+ * @brief Maximum length of a diagnostic kept by an error trap.
+ */
+#define ERR_MSG_SIZE 512
+
+/**
+ * @brief Structure defining a point to return to, when an error is reported
+ *        on the current thread. While a trap is set, `print_error()` keeps
+ *        the diagnostic in the trap, and jumps back to it, rather than
+ *        printing it, and exiting. Usage:
+ *
+ *            ErrTrap trap;
+ *            err_trap_push(&trap);
+ *            if (setjmp(trap.env) == 0) {
+ *                ... // Work, that can call `print_error()`.
+ *            } else {
+ *                ... // `trap.err`, and `trap.msg` hold the diagnostic.
+ *            }
+ *            err_trap_pop(&trap);
+ */
+typedef struct ErrTrap {
+    jmp_buf env;            ///< Context that `print_error()` jumps back to.
+    ErrType err;            ///< Type of the error that was reported.
+    char msg[ERR_MSG_SIZE]; ///< Message of the error that was reported.
+    void *owned_mem;        ///< Memory freed when an error is reported,
+                            ///< see `err_trap_own()`.
+    struct ErrTrap *prev;   ///< Trap that was set before this one.
+} ErrTrap;
+
+/**
+ * @brief Sets an error trap for the current thread, `setjmp()` must be
+ *        called on `trap->env` right after.
+ *
+ * @param trap [`ErrTrap *`] Pointer to the trap.
+ */
+void err_trap_push(ErrTrap *trap);
+
+/**
+ * @brief Removes the error trap for the current thread, restoring the one
+ *        set before it. Must be called on both paths out of `setjmp()`.
+ *
+ * @param trap [`ErrTrap *`] Pointer to the trap, that was set last.
+ */
+void err_trap_pop(ErrTrap *trap);
+
+/**
+ * @brief Hands memory allocated with `malloc()` to the error trap of the
+ *        current thread, which frees it, if an error is reported before it's
+ *        taken back, by passing NULL. Without a trap, an error exits the
+ *        process, so nothing is kept.
+ *
+ * @param mem [`void *`] Pointer to the memory, or NULL.
+ */
+void err_trap_own(void *mem);
+
+/**
+ * @brief  Checks if an error trap is set for the current thread, i.e. if
+ *         errors are returned to a caller, rather than printed.
+ *
+ * @return char `1` if a trap is set, `0` otherwise.
+ */
+char err_trap_is_set();
+
 void print_error(ErrType err, const char *fmt, ...);
 
 void print_warning(ErrType err, const char *fmt, ...);
 
-char *read_file_data(char *file_dest);
+/**
+ * @brief Size of the chunks in which pipes and `stdin` are read.
+ */
+#define READ_CHUNK_SIZE 65536
+
+/**
+ * @brief Structure defining the contents of a source file, either mapped into
+ *        memory, or read into a buffer when the input can't be mapped.
+ */
+typedef struct SourceFile {
+    char *file_data;  ///< NULL terminated contents of the file.
+    size_t file_size; ///< Size of the contents, without the NULL terminator.
+    size_t map_size;  ///< Size of the mapping, 0 if the contents were read.
+    size_t drop_size; ///< Bytes at the start of the mapping, that have been
+                      ///< dropped from memory.
+    double read_ms;   ///< Time taken to map, or read the contents.
+} SourceFile;
+
+/**
+ * @brief  Maps a source file into memory, followed by at least one NULL byte,
+ *         so that the lexer can run over it without a copy. Pipes, and `-`
+ *         for `stdin`, fall back to reading the input into a buffer.
+ *
+ * @param  file_dest  [`char *`] Path to the source file, or `-`.
+ * @param  source     [`SourceFile *`] Pointer in which the contents are
+ *                    stored.
+ */
+void read_file_data(char *file_dest, SourceFile *source);
+
+/**
+ * @brief  Drops the whole pages of a mapped source file, before `offset`,
+ *         from memory, once they are no longer needed. They are read back
+ *         from the file, if touched again. Contents that were read into a
+ *         buffer are kept.
+ *
+ * @param  source     [`SourceFile *`] Pointer to the source file.
+ * @param  offset     [`size_t`] Number of bytes at the start of the source,
+ *                    that are no longer needed.
+ */
+void drop_file_data(SourceFile *source, size_t offset);
+
+/**
+ * @brief  Unmaps, or frees the contents of a source file.
+ *
+ * @param  source     [`SourceFile *`] Pointer to the source file.
+ */
+void release_file_data(SourceFile *source);
 
 /**
  * @brief  Calculates the size of the file, pointed by `file_ptr`.
@@ -2,7 +2,7 @@
 #include "../../inc/arch/x86_64/code_gen_x86_64.h"
 
 CGContext *create_cgcontext(TargetFormat fmt, TargetCallingConvention call_conv,
-                            TargetAssemblyDialect dialect, FILE *fptr) {
+                            TargetAssemblyDialect dialect, OutBuf *code_out) {
 
     CGContext *cg_ctx = NULL;
 
@@ -19,7 +19,10 @@ CGContext *create_cgcontext(TargetFormat fmt, TargetCallingConvention call_conv,
         print_error(ERR_COMMON,
                     "Unrecognized target output format in `create_cgcontext`");
 
-    cg_ctx->fptr_code = fptr;
+    if (dialect >= TARGET_ASM_DIALECT_COUNT)
+        print_error(ERR_ARGS, "Encountered invalid assembly dialect");
+
+    cg_ctx->code_out = code_out;
     cg_ctx->target_asm_dialect = dialect;
 
     return cg_ctx;
@@ -57,6 +60,38 @@ CGContext *create_cgcontext_child(CGContext *parent_ctx) {
     return new_ctx;
 }
 
+CGContext *create_cgcontext_func(CGContext *parent_ctx) {
+
+    if (parent_ctx == NULL)
+        print_error(ERR_COMMON,
+                    "NULL parent_ctx passed to create_cgcontext_func()");
+
+    CGContext *new_ctx = NULL;
+    switch (parent_ctx->target_fmt) {
+    default:
+        print_error(
+            ERR_COMMON,
+            "Encountered unknown target_fmt in create_cgcontext_func()");
+        break;
+    case TARGET_FMT_X86_64_GNU_AS:
+        switch (parent_ctx->target_call_conv) {
+        case TARGET_CALL_CONV_WIN:
+            new_ctx = create_cgcontext_func_gnu_as_win(parent_ctx);
+            break;
+        case TARGET_CALL_CONV_LINUX:
+            print_error(ERR_COMMON, "LINUX calling convention not yet "
+                                    "supported in create_cgcontext_func()");
+            break;
+        default:
+            print_error(ERR_COMMON, "Encountered unknown target_call_conv in "
+                                    "create_cgcontext_func()");
+            break;
+        }
+        break;
+    }
+    return new_ctx;
+}
+
 void free_cgcontext(CGContext *cg_ctx) {
 
     switch (cg_ctx->target_fmt) {
@@ -83,6 +118,32 @@ void free_cgcontext(CGContext *cg_ctx) {
     }
 }
 
+void cgcontext_write_cache_key(CGContext *cg_ctx, OutBuf *key) {
+
+    switch (cg_ctx->target_fmt) {
+    default:
+        print_error(
+            ERR_COMMON,
+            "Encountered unknown target_fmt in cgcontext_write_cache_key()");
+        break;
+    case TARGET_FMT_X86_64_GNU_AS:
+        switch (cg_ctx->target_call_conv) {
+        case TARGET_CALL_CONV_WIN:
+            cgcontext_write_cache_key_gnu_as_win(cg_ctx, key);
+            break;
+        case TARGET_CALL_CONV_LINUX:
+            print_error(ERR_COMMON, "LINUX calling convention not yet "
+                                    "supported in cgcontext_write_cache_key()");
+            break;
+        default:
+            print_error(ERR_COMMON, "Encountered unknown target_call_conv in "
+                                    "cgcontext_write_cache_key()");
+            break;
+        }
+        break;
+    }
+}
+
 void code_gen_setup_func_call(CGContext *cg_ctx) {
 
     switch (cg_ctx->target_fmt) {
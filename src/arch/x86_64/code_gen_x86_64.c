@@ -1,47 +1,57 @@
 #include "../../../inc/arch/x86_64/code_gen_x86_64.h"
+#include "../../../inc/arena.h"
 #include "../../../inc/code_gen.h"
 #include "../../../inc/env_funcs.h"
+#include "../../../inc/out_buf.h"
+#include "../../../inc/pass_stats.h"
 #include <inttypes.h>
 
 #define DEFINE_REG_ENUM(name, ...) REG_X86_64_##name,
-#define REGITER_NAME_64(ident, name, ...) name,
-#define REGITER_NAME_32(ident, name, name_32, ...) name_32,
-#define REGITER_NAME_16(ident, name, name_32, name_16, ...) name_16,
-#define REGITER_NAME_8(ident, name, name_32, name_16, name_8, ...) name_8,
+#define REG_OPERAND_ATT_64(ident, name, ...) OUT_STR("%" name),
+#define REG_OPERAND_INTEL_64(ident, name, ...) OUT_STR(name),
+#define REG_OPERAND_ATT_8(ident, name, name_32, name_16, name_8, ...)          \
+    OUT_STR("%" name_8),
+#define REG_OPERAND_INTEL_8(ident, name, name_32, name_16, name_8, ...)        \
+    OUT_STR(name_8),
 
 #define INIT_REGISTER(ident, ...)                                              \
     ((registers)[REG_X86_64_##ident] =                                         \
          (Reg){.reg_in_use = 0, .reg_desc = (REG_X86_64_##ident)});
 
-#define DEFINE_REG_NAME_LOOKUP_FUNC(name, bits)                                \
-    static const char *name(RegDescriptor reg_desc) {                          \
-        static const char *reg_names[] = {                                     \
-            FOR_ALL_X86_64_REGS(REGITER_NAME_##bits)};                         \
+#define DEFINE_REG_OPERAND_LOOKUP_FUNC(name, bits)                             \
+    static const OutStr *name(CGContext *cg_ctx, RegDescriptor reg_desc) {     \
+        static const OutStr                                                    \
+            reg_operands[TARGET_ASM_DIALECT_COUNT][REG_X86_64_COUNT] = {       \
+                [TARGET_ASM_DIALECT_ATT] = {FOR_ALL_X86_64_REGS(               \
+                    REG_OPERAND_ATT_##bits)},                                  \
+                [TARGET_ASM_DIALECT_INTEL] = {FOR_ALL_X86_64_REGS(             \
+                    REG_OPERAND_INTEL_##bits)},                                \
+            };                                                                 \
         if (reg_desc < 0 || reg_desc >= REG_X86_64_COUNT) {                    \
             print_error(ERR_COMMON, "Invalid register descriptor: `%d`",       \
                         reg_desc);                                             \
         }                                                                      \
-        return reg_names[reg_desc];                                            \
+        return &reg_operands[cg_ctx->target_asm_dialect][reg_desc];            \
     }
 
 typedef enum Regs_X86_64 {
     FOR_ALL_X86_64_REGS(DEFINE_REG_ENUM) REG_X86_64_COUNT,
 } Regs_X86_64;
 
-DEFINE_REG_NAME_LOOKUP_FUNC(get_reg_name, 64)
-// Following functions are commented out due to unused errors.
-// They will need to be defined again, when needed.
-// DEFINE_REG_NAME_LOOKUP_FUNC(get_reg_name_32, 32)
-// DEFINE_REG_NAME_LOOKUP_FUNC(get_reg_name_16, 16)
-DEFINE_REG_NAME_LOOKUP_FUNC(get_reg_name_8, 8)
+// Register operands are preformatted for every dialect, i.e. `%rax` for AT&T
+// and `rax` for Intel, so that they're copied straight into the output.
+// Lookups for the 32, and 16 bit registers will need to be defined, when
+// needed.
+DEFINE_REG_OPERAND_LOOKUP_FUNC(get_reg_operand, 64)
+DEFINE_REG_OPERAND_LOOKUP_FUNC(get_reg_operand_8, 8)
 
-#undef REGISTER_NAME_64
-#undef REGISTER_NAME_32
-#undef REGISTER_NAME_16
-#undef REGISTER_NAME_8
+#undef REG_OPERAND_ATT_64
+#undef REG_OPERAND_INTEL_64
+#undef REG_OPERAND_ATT_8
+#undef REG_OPERAND_INTEL_8
 
 #undef DEFINE_REG_ENUM
-#undef DEFINE_REG_NAME_LOOKUP_FUNC
+#undef DEFINE_REG_OPERAND_LOOKUP_FUNC
 
 typedef enum JumpType_X86_64 {
     JMP_TYPE_A,
@@ -130,179 +140,217 @@ const char *comp_suffixes_x86_84[COMP_COUNT] = {
     "e", "ne", "l", "le", "g", "ge",
 };
 
-const char *inst_mnemonic_x86_64(CGContext *cg_ctx, Instructions_X86_64 inst,
-                                 TargetFormat target) {
-    switch (target) {
-    default:
-        break;
-    }
-    switch (inst) {
-    default:
-        break;
-    case INST_X86_64_ADD:
-        return "add";
-    case INST_X86_64_SUB:
-        return "sub";
-    case INST_X86_64_MUL:
-        return "mul";
-    case INST_X86_64_IMUL:
-        return "imul";
-    case INST_X86_64_DIV:
-        return "div";
-    case INST_X86_64_IDIV:
-        return "idiv";
-    case INST_X86_64_PUSH:
-        return "push";
-    case INST_X86_64_POP:
-        return "pop";
-    case INST_X86_64_RET:
-        return "ret";
-    case INST_X86_64_MOV:
-        return "mov";
-    case INST_X86_64_LEA:
-        return "lea";
-    case INST_X86_64_XOR:
-        return "xor";
-    case INST_X86_64_JMP:
-        return "jmp";
-    case INST_X86_64_CALL:
-        return "call";
-    case INST_X86_64_CMP:
-        return "cmp";
-    case INST_X86_64_TEST:
-        return "test";
-    case INST_X86_64_SETCC:
-        return "set";
-    case INST_X86_64_SAL:
-        return "sal";
-    case INST_X86_64_SAR:
-        return "sar";
-    case INST_X86_64_SHR:
-        return "shr";
-    case INST_X86_64_JCC:
-        return "j";
-    case INST_X86_64_XCHG:
-        return "xchg";
-    }
-    switch (cg_ctx->target_asm_dialect) {
-    default:
-        break;
-    case TARGET_ASM_DIALECT_ATT:
-        switch (inst) {
-        default:
-            break;
-        case INST_X86_64_CQO:
-            return "cqto";
+#define COMMON_MNEMONICS_X86_64                                                \
+    [INST_X86_64_ADD] = OUT_STR("add"), [INST_X86_64_SUB] = OUT_STR("sub"),    \
+    [INST_X86_64_MUL] = OUT_STR("mul"), [INST_X86_64_IMUL] = OUT_STR("imul"),  \
+    [INST_X86_64_DIV] = OUT_STR("div"), [INST_X86_64_IDIV] = OUT_STR("idiv"),  \
+    [INST_X86_64_PUSH] = OUT_STR("push"), [INST_X86_64_POP] = OUT_STR("pop"),  \
+    [INST_X86_64_RET] = OUT_STR("ret"), [INST_X86_64_MOV] = OUT_STR("mov"),    \
+    [INST_X86_64_LEA] = OUT_STR("lea"), [INST_X86_64_XOR] = OUT_STR("xor"),    \
+    [INST_X86_64_JMP] = OUT_STR("jmp"), [INST_X86_64_CALL] = OUT_STR("call"),  \
+    [INST_X86_64_CMP] = OUT_STR("cmp"), [INST_X86_64_TEST] = OUT_STR("test"),  \
+    [INST_X86_64_SETCC] = OUT_STR("set"), [INST_X86_64_SAL] = OUT_STR("sal"),  \
+    [INST_X86_64_SAR] = OUT_STR("sar"), [INST_X86_64_SHR] = OUT_STR("shr"),    \
+    [INST_X86_64_JCC] = OUT_STR("j"), [INST_X86_64_XCHG] = OUT_STR("xchg")
+
+// Mnemonics for every dialect, indexed by the dialect, and the instruction.
+static const OutStr
+    inst_mnemonics_x86_64[TARGET_ASM_DIALECT_COUNT][INST_X86_64_COUNT] = {
+        [TARGET_ASM_DIALECT_ATT] = {COMMON_MNEMONICS_X86_64,
+                                    [INST_X86_64_CQO] = OUT_STR("cqto")},
+        [TARGET_ASM_DIALECT_INTEL] = {COMMON_MNEMONICS_X86_64,
+                                      [INST_X86_64_CQO] = OUT_STR("cqo")},
+};
+
+#undef COMMON_MNEMONICS_X86_64
+
+static const OutStr *inst_mnemonic_x86_64(CGContext *cg_ctx,
+                                          Instructions_X86_64 inst) {
+    if (inst >= INST_X86_64_COUNT ||
+        inst_mnemonics_x86_64[cg_ctx->target_asm_dialect][inst].str == NULL)
+        print_error(
+            ERR_COMMON,
+            "Unable to convert Instructions_X86_64 to corresponding mnemonic");
+    return &inst_mnemonics_x86_64[cg_ctx->target_asm_dialect][inst];
+}
+
+typedef enum OperandKind_X86_64 {
+    OPERAND_KIND_REG,        ///< `%reg` / `reg`
+    OPERAND_KIND_REG_8,      ///< `%al` / `al`
+    OPERAND_KIND_IMM,        ///< `$imm` / `imm`
+    OPERAND_KIND_SYM,        ///< `sym` / `sym`
+    OPERAND_KIND_MEM,        ///< `imm(%reg)` / `[reg + imm]`
+    OPERAND_KIND_DEREF,      ///< `(%reg)` / `[reg]`
+    OPERAND_KIND_SYM_MEM,    ///< `sym(%reg)` / `[reg + sym]`
+    OPERAND_KIND_BRANCH_REG, ///< `*%reg` / `reg`
+} OperandKind_X86_64;
+
+typedef struct Operand_X86_64 {
+    OperandKind_X86_64 kind;
+    RegDescriptor reg;
+    int64_t imm;
+    const char *sym;
+} Operand_X86_64;
+
+#define OPERAND_X86_64(operand_kind, ...)                                      \
+    (&(Operand_X86_64){.kind = (operand_kind), __VA_ARGS__})
+#define REG_OPERAND(reg_desc)                                                  \
+    OPERAND_X86_64(OPERAND_KIND_REG, .reg = (reg_desc))
+#define REG_8_OPERAND(reg_desc)                                                \
+    OPERAND_X86_64(OPERAND_KIND_REG_8, .reg = (reg_desc))
+#define IMM_OPERAND(imm_val) OPERAND_X86_64(OPERAND_KIND_IMM, .imm = (imm_val))
+#define SYM_OPERAND(sym_str) OPERAND_X86_64(OPERAND_KIND_SYM, .sym = (sym_str))
+#define MEM_OPERAND(mem_offset, reg_desc)                                      \
+    OPERAND_X86_64(OPERAND_KIND_MEM, .imm = (mem_offset), .reg = (reg_desc))
+#define DEREF_OPERAND(reg_desc)                                                \
+    OPERAND_X86_64(OPERAND_KIND_DEREF, .reg = (reg_desc))
+#define SYM_MEM_OPERAND(sym_str, reg_desc)                                     \
+    OPERAND_X86_64(OPERAND_KIND_SYM_MEM, .sym = (sym_str), .reg = (reg_desc))
+#define BRANCH_REG_OPERAND(reg_desc)                                           \
+    OPERAND_X86_64(OPERAND_KIND_BRANCH_REG, .reg = (reg_desc))
+
+static void emit_x86_64_operand(CGContext *cg_ctx,
+                                const Operand_X86_64 *operand) {
+    OutBuf *out = cg_ctx->code_out;
+    char is_att = cg_ctx->target_asm_dialect == TARGET_ASM_DIALECT_ATT;
+
+    switch (operand->kind) {
+    case OPERAND_KIND_REG:
+        out_buf_ostr(out, get_reg_operand(cg_ctx, operand->reg));
+        break;
+    case OPERAND_KIND_REG_8:
+        out_buf_ostr(out, get_reg_operand_8(cg_ctx, operand->reg));
+        break;
+    case OPERAND_KIND_IMM:
+        if (is_att)
+            out_buf_char(out, '$');
+        out_buf_int(out, operand->imm);
+        break;
+    case OPERAND_KIND_SYM:
+        out_buf_str(out, operand->sym);
+        break;
+    case OPERAND_KIND_MEM:
+        if (is_att) {
+            out_buf_int(out, operand->imm);
+            out_buf_char(out, '(');
+            out_buf_ostr(out, get_reg_operand(cg_ctx, operand->reg));
+            out_buf_char(out, ')');
+        } else {
+            out_buf_char(out, '[');
+            out_buf_ostr(out, get_reg_operand(cg_ctx, operand->reg));
+            out_buf_write(out, " + ", 3);
+            out_buf_int(out, operand->imm);
+            out_buf_char(out, ']');
         }
         break;
-
-    case TARGET_ASM_DIALECT_INTEL:
-        switch (inst) {
-        default:
-            break;
-        case INST_X86_64_CQO:
-            return "cqo";
+    case OPERAND_KIND_DEREF:
+        out_buf_char(out, is_att ? '(' : '[');
+        out_buf_ostr(out, get_reg_operand(cg_ctx, operand->reg));
+        out_buf_char(out, is_att ? ')' : ']');
+        break;
+    case OPERAND_KIND_SYM_MEM:
+        if (is_att) {
+            out_buf_str(out, operand->sym);
+            out_buf_char(out, '(');
+            out_buf_ostr(out, get_reg_operand(cg_ctx, operand->reg));
+            out_buf_char(out, ')');
+        } else {
+            out_buf_char(out, '[');
+            out_buf_ostr(out, get_reg_operand(cg_ctx, operand->reg));
+            out_buf_write(out, " + ", 3);
+            out_buf_str(out, operand->sym);
+            out_buf_char(out, ']');
         }
         break;
+    case OPERAND_KIND_BRANCH_REG:
+        if (is_att)
+            out_buf_char(out, '*');
+        out_buf_ostr(out, get_reg_operand(cg_ctx, operand->reg));
+        break;
     }
-    print_error(
-        ERR_COMMON,
-        "Unable to convert Instructions_X86_64 to corresponding mnemonic");
-    return "";
 }
 
-static void file_emit_x86_64_imm_to_mem(CGContext *cg_ctx, const char *mnemonic,
+// Emits the operands of an instruction, and ends the line. AT&T lists the
+// source operand first, while Intel lists the destination first.
+static void emit_x86_64_operands(CGContext *cg_ctx, const Operand_X86_64 *src,
+                                 const Operand_X86_64 *dest) {
+    const Operand_X86_64 *first = src;
+    const Operand_X86_64 *second = dest;
+    if (cg_ctx->target_asm_dialect == TARGET_ASM_DIALECT_INTEL &&
+        dest != NULL) {
+        first = dest;
+        second = src;
+    }
+
+    OutBuf *out = cg_ctx->code_out;
+    pass_stats.insts_emitted += 1;
+    if (first != NULL) {
+        out_buf_char(out, ' ');
+        emit_x86_64_operand(cg_ctx, first);
+    }
+    if (second != NULL) {
+        out_buf_write(out, ", ", 2);
+        emit_x86_64_operand(cg_ctx, second);
+    }
+    out_buf_char(out, '\n');
+}
+
+static void emit_x86_64_inst(CGContext *cg_ctx, const OutStr *mnemonic,
+                             const Operand_X86_64 *src,
+                             const Operand_X86_64 *dest) {
+    out_buf_ostr(cg_ctx->code_out, mnemonic);
+    emit_x86_64_operands(cg_ctx, src, dest);
+}
+
+static void file_emit_x86_64_imm_to_mem(CGContext *cg_ctx,
+                                        const OutStr *mnemonic,
                                         va_list operands) {
 
     // immediate value, memory offset, destination.
     int64_t imm_val = va_arg(operands, int64_t);
     int64_t mem_offset = va_arg(operands, int64_t);
     RegDescriptor mem_reg = va_arg(operands, RegDescriptor);
-    switch (cg_ctx->target_asm_dialect) {
-    case TARGET_ASM_DIALECT_ATT:
-        fprintf(cg_ctx->fptr_code, "%s $%" PRId64 ", %" PRId64 "(%%%s)\n",
-                mnemonic, imm_val, mem_offset, get_reg_name(mem_reg));
-        break;
-    case TARGET_ASM_DIALECT_INTEL:
-        fprintf(cg_ctx->fptr_code, "%s [%s + %" PRId64 "], %" PRId64 "\n",
-                mnemonic, get_reg_name(mem_reg), mem_offset, imm_val);
-        break;
-    default:
-        print_error(ERR_COMMON,
-                    "Unrecognized ASM dialect encountered for `imm_to_mem`");
-        break;
-    }
+    emit_x86_64_inst(cg_ctx, mnemonic, IMM_OPERAND(imm_val),
+                     MEM_OPERAND(mem_offset, mem_reg));
 }
 
-static void file_emit_x86_64_imm_to_reg(CGContext *cg_ctx, const char *mnemonic,
+static void file_emit_x86_64_imm_to_reg(CGContext *cg_ctx,
+                                        const OutStr *mnemonic,
                                         va_list operands) {
 
     // immediate value, destination.
     int64_t imm_val = va_arg(operands, int64_t);
     RegDescriptor dest_reg = va_arg(operands, RegDescriptor);
-    switch (cg_ctx->target_asm_dialect) {
-    case TARGET_ASM_DIALECT_ATT:
-        fprintf(cg_ctx->fptr_code, "%s $%" PRId64 ", %%%s\n", mnemonic, imm_val,
-                get_reg_name(dest_reg));
-        break;
-    case TARGET_ASM_DIALECT_INTEL:
-        fprintf(cg_ctx->fptr_code, "%s %s, %" PRId64 "\n", mnemonic,
-                get_reg_name(dest_reg), imm_val);
-        break;
-    default:
-        print_error(ERR_COMMON,
-                    "Unrecognized ASM dialect encountered for `imm_to_reg`");
-        break;
-    }
+    emit_x86_64_inst(cg_ctx, mnemonic, IMM_OPERAND(imm_val),
+                     REG_OPERAND(dest_reg));
 }
 
-static void file_emit_x86_64_mem_to_reg(CGContext *cg_ctx, const char *mnemonic,
+static void file_emit_x86_64_mem_to_reg(CGContext *cg_ctx,
+                                        const OutStr *mnemonic,
                                         va_list operands) {
 
     // memory offset, source, destination.
     int64_t imm_val = va_arg(operands, int64_t);
     RegDescriptor src_reg = va_arg(operands, RegDescriptor);
     RegDescriptor dest_reg = va_arg(operands, RegDescriptor);
-    switch (cg_ctx->target_asm_dialect) {
-    case TARGET_ASM_DIALECT_ATT:
-        fprintf(cg_ctx->fptr_code, "%s %" PRId64 "(%%%s), %%%s\n", mnemonic,
-                imm_val, get_reg_name(src_reg), get_reg_name(dest_reg));
-        break;
-    case TARGET_ASM_DIALECT_INTEL:
-        fprintf(cg_ctx->fptr_code, "%s %s, [%s + %" PRId64 "]\n", mnemonic,
-                get_reg_name(dest_reg), get_reg_name(src_reg), imm_val);
-        break;
-    default:
-        print_error(ERR_COMMON,
-                    "Unrecognized ASM dialect encountered for `mem_to_reg`");
-        break;
-    }
+    emit_x86_64_inst(cg_ctx, mnemonic, MEM_OPERAND(imm_val, src_reg),
+                     REG_OPERAND(dest_reg));
 }
 
-static void file_emit_x86_64_sym_to_reg(CGContext *cg_ctx, const char *mnemonic,
+static void file_emit_x86_64_sym_to_reg(CGContext *cg_ctx,
+                                        const OutStr *mnemonic,
                                         va_list operands) {
 
     // name, source, destination.
     const char *sym = va_arg(operands, const char *);
     RegDescriptor src_reg = va_arg(operands, RegDescriptor);
     RegDescriptor dest_reg = va_arg(operands, RegDescriptor);
-    switch (cg_ctx->target_asm_dialect) {
-    case TARGET_ASM_DIALECT_ATT:
-        fprintf(cg_ctx->fptr_code, "%s %s(%%%s), %%%s\n", mnemonic, sym,
-                get_reg_name(src_reg), get_reg_name(dest_reg));
-        break;
-    case TARGET_ASM_DIALECT_INTEL:
-        fprintf(cg_ctx->fptr_code, "%s %s, [%s + %s]\n", mnemonic,
-                get_reg_name(dest_reg), get_reg_name(src_reg), sym);
-        break;
-    default:
-        print_error(ERR_COMMON,
-                    "Unrecognized ASM dialect encountered for `sym_to_reg`");
-        break;
-    }
+    emit_x86_64_inst(cg_ctx, mnemonic, SYM_MEM_OPERAND(sym, src_reg),
+                     REG_OPERAND(dest_reg));
 }
 
-static void file_emit_x86_64_reg_to_reg(CGContext *cg_ctx, const char *mnemonic,
+static void file_emit_x86_64_reg_to_reg(CGContext *cg_ctx,
+                                        const OutStr *mnemonic,
                                         va_list operands) {
 
     // source, destination.
@@ -310,151 +358,63 @@ static void file_emit_x86_64_reg_to_reg(CGContext *cg_ctx, const char *mnemonic,
     RegDescriptor reg_dest = va_arg(operands, RegDescriptor);
 
     // Don't emit `mov` if the source and destination are the same.
-    if (reg_src == reg_dest && strcmp(mnemonic, "mov") == 0)
+    if (reg_src == reg_dest &&
+        mnemonic == inst_mnemonic_x86_64(cg_ctx, INST_X86_64_MOV))
         return;
 
-    switch (cg_ctx->target_asm_dialect) {
-    case TARGET_ASM_DIALECT_ATT:
-        fprintf(cg_ctx->fptr_code, "%s %%%s, %%%s\n", mnemonic,
-                get_reg_name(reg_src), get_reg_name(reg_dest));
-        break;
-    case TARGET_ASM_DIALECT_INTEL:
-        fprintf(cg_ctx->fptr_code, "%s %s, %s\n", mnemonic,
-                get_reg_name(reg_dest), get_reg_name(reg_src));
-        break;
-    default:
-        print_error(ERR_COMMON,
-                    "Unrecognized ASM dialect encountered for `reg_to_reg`");
-        break;
-    }
+    emit_x86_64_inst(cg_ctx, mnemonic, REG_OPERAND(reg_src),
+                     REG_OPERAND(reg_dest));
 }
 
-static void file_emit_x86_64_reg_to_mem(CGContext *cg_ctx, const char *mnemonic,
+static void file_emit_x86_64_reg_to_mem(CGContext *cg_ctx,
+                                        const OutStr *mnemonic,
                                         va_list operands) {
 
     // source, memory offset, destination.
     RegDescriptor reg_src = va_arg(operands, RegDescriptor);
     int64_t mem_offset = va_arg(operands, int64_t);
     RegDescriptor reg_dest = va_arg(operands, RegDescriptor);
-    switch (cg_ctx->target_asm_dialect) {
-    case TARGET_ASM_DIALECT_ATT:
-        if (mem_offset)
-            fprintf(cg_ctx->fptr_code, "%s %%%s, %" PRId64 "(%%%s)\n", mnemonic,
-                    get_reg_name(reg_src), mem_offset, get_reg_name(reg_dest));
-        else
-            fprintf(cg_ctx->fptr_code, "%s %%%s, (%%%s)\n", mnemonic,
-                    get_reg_name(reg_src), get_reg_name(reg_dest));
-        break;
-    case TARGET_ASM_DIALECT_INTEL:
-        if (mem_offset)
-            fprintf(cg_ctx->fptr_code, "%s [%s + %" PRId64 "], %s\n", mnemonic,
-                    get_reg_name(reg_dest), mem_offset, get_reg_name(reg_src));
-        else
-            fprintf(cg_ctx->fptr_code, "%s [%s], %s\n", mnemonic,
-                    get_reg_name(reg_dest), get_reg_name(reg_src));
-        break;
-    default:
-        print_error(ERR_COMMON,
-                    "Unrecognized ASM dialect encountered for `reg_to_mem`");
-        break;
-    }
+    emit_x86_64_inst(cg_ctx, mnemonic, REG_OPERAND(reg_src),
+                     mem_offset ? MEM_OPERAND(mem_offset, reg_dest)
+                                : DEREF_OPERAND(reg_dest));
 }
 
-static void file_emit_x86_64_reg_to_sym(CGContext *cg_ctx, const char *mnemonic,
+static void file_emit_x86_64_reg_to_sym(CGContext *cg_ctx,
+                                        const OutStr *mnemonic,
                                         va_list operands) {
 
     // name, source, destination.
     RegDescriptor src_reg = va_arg(operands, RegDescriptor);
     const char *sym = va_arg(operands, const char *);
     RegDescriptor dest_reg = va_arg(operands, RegDescriptor);
-    switch (cg_ctx->target_asm_dialect) {
-    case TARGET_ASM_DIALECT_ATT:
-        fprintf(cg_ctx->fptr_code, "%s %%%s, %s(%%%s)\n", mnemonic,
-                get_reg_name(src_reg), sym, get_reg_name(dest_reg));
-        break;
-    case TARGET_ASM_DIALECT_INTEL:
-        fprintf(cg_ctx->fptr_code, "%s [%s + %s], %s\n", mnemonic,
-                get_reg_name(dest_reg), sym, get_reg_name(src_reg));
-        break;
-    default:
-        print_error(ERR_COMMON,
-                    "Unrecognized ASM dialect encountered for `sym_to_reg`");
-        break;
-    }
+    emit_x86_64_inst(cg_ctx, mnemonic, REG_OPERAND(src_reg),
+                     SYM_MEM_OPERAND(sym, dest_reg));
 }
 
-static void file_emit_x86_64_reg(CGContext *cg_ctx, const char *mnemonic,
+static void file_emit_x86_64_reg(CGContext *cg_ctx, const OutStr *mnemonic,
                                  va_list operands) {
     RegDescriptor src_reg = va_arg(operands, RegDescriptor);
-    switch (cg_ctx->target_asm_dialect) {
-    case TARGET_ASM_DIALECT_ATT:
-        fprintf(cg_ctx->fptr_code, "%s %%%s\n", mnemonic,
-                get_reg_name(src_reg));
-        break;
-    case TARGET_ASM_DIALECT_INTEL:
-        fprintf(cg_ctx->fptr_code, "%s %s\n", mnemonic, get_reg_name(src_reg));
-        break;
-    default:
-        print_error(ERR_COMMON,
-                    "Unrecognized ASM dialect encountered for `reg`");
-        break;
-    }
+    emit_x86_64_inst(cg_ctx, mnemonic, REG_OPERAND(src_reg), NULL);
 }
 
-static void file_emit_x86_64_mem(CGContext *cg_ctx, const char *mnemonic,
+static void file_emit_x86_64_mem(CGContext *cg_ctx, const OutStr *mnemonic,
                                  va_list operands) {
     int64_t mem_offset = va_arg(operands, int64_t);
     RegDescriptor reg = va_arg(operands, RegDescriptor);
-    switch (cg_ctx->target_asm_dialect) {
-    case TARGET_ASM_DIALECT_ATT:
-        fprintf(cg_ctx->fptr_code, "%s %" PRId64 "(%%%s)\n", mnemonic,
-                mem_offset, get_reg_name(reg));
-        break;
-    case TARGET_ASM_DIALECT_INTEL:
-        fprintf(cg_ctx->fptr_code, "%s [%s + %" PRId64 "]\n", mnemonic,
-                get_reg_name(reg), mem_offset);
-        break;
-    default:
-        print_error(ERR_COMMON,
-                    "Unrecognized ASM dialect encountered for `reg`");
-        break;
-    }
+    emit_x86_64_inst(cg_ctx, mnemonic, MEM_OPERAND(mem_offset, reg), NULL);
 }
 
-static void file_emit_x86_64_imm(CGContext *cg_ctx, const char *mnemonic,
+static void file_emit_x86_64_imm(CGContext *cg_ctx, const OutStr *mnemonic,
                                  va_list operands) {
     int64_t imm_val = va_arg(operands, int64_t);
-    switch (cg_ctx->target_asm_dialect) {
-    case TARGET_ASM_DIALECT_ATT:
-        fprintf(cg_ctx->fptr_code, "%s $%" PRId64 "\n", mnemonic, imm_val);
-        break;
-    case TARGET_ASM_DIALECT_INTEL:
-        fprintf(cg_ctx->fptr_code, "%s %" PRId64 "\n", mnemonic, imm_val);
-        break;
-    default:
-        print_error(ERR_COMMON,
-                    "Unrecognized ASM dialect encountered for `reg`");
-        break;
-    }
+    emit_x86_64_inst(cg_ctx, mnemonic, IMM_OPERAND(imm_val), NULL);
 }
 
 static void file_emit_x86_64_indirect_branch(CGContext *cg_ctx,
-                                             const char *mnemonic,
+                                             const OutStr *mnemonic,
                                              va_list operands) {
     RegDescriptor addr_reg = va_arg(operands, RegDescriptor);
-    switch (cg_ctx->target_asm_dialect) {
-    case TARGET_ASM_DIALECT_ATT:
-        fprintf(cg_ctx->fptr_code, "%s *%%%s\n", mnemonic,
-                get_reg_name(addr_reg));
-        break;
-    case TARGET_ASM_DIALECT_INTEL:
-        fprintf(cg_ctx->fptr_code, "%s %s\n", mnemonic, get_reg_name(addr_reg));
-        break;
-    default:
-        print_error(ERR_COMMON,
-                    "Unrecognized ASM dialect encountered for `reg`");
-        break;
-    }
+    emit_x86_64_inst(cg_ctx, mnemonic, BRANCH_REG_OPERAND(addr_reg), NULL);
 }
 
 static void file_emit_x86_64(CGContext *cg_ctx, Instructions_X86_64 inst, ...) {
@@ -464,8 +424,7 @@ static void file_emit_x86_64(CGContext *cg_ctx, Instructions_X86_64 inst, ...) {
     if (cg_ctx == NULL)
         print_error(ERR_COMMON, "Encountered NULL code gen context");
 
-    const char *mnemonic =
-        inst_mnemonic_x86_64(cg_ctx, inst, cg_ctx->target_fmt);
+    const OutStr *mnemonic = inst_mnemonic_x86_64(cg_ctx, inst);
 
     switch (inst) {
 
@@ -583,7 +542,7 @@ static void file_emit_x86_64(CGContext *cg_ctx, Instructions_X86_64 inst, ...) {
 
     case INST_X86_64_RET:
     case INST_X86_64_CQO:
-        fprintf(cg_ctx->fptr_code, "%s\n", mnemonic);
+        emit_x86_64_inst(cg_ctx, mnemonic, NULL, NULL);
         break;
 
     case INST_X86_64_LEA:
@@ -614,16 +573,7 @@ static void file_emit_x86_64(CGContext *cg_ctx, Instructions_X86_64 inst, ...) {
             break;
         case OPERAND_TYPE_SYM:;
             const char *sym = va_arg(operands, const char *);
-            switch (cg_ctx->target_asm_dialect) {
-            case TARGET_ASM_DIALECT_ATT:
-            case TARGET_ASM_DIALECT_INTEL:
-                fprintf(cg_ctx->fptr_code, "%s %s\n", mnemonic, sym);
-                break;
-            default:
-                print_error(ERR_COMMON,
-                            "Invalid ASM dialect for instruction : `jmp/call`");
-                break;
-            }
+            emit_x86_64_inst(cg_ctx, mnemonic, SYM_OPERAND(sym), NULL);
             break;
         }
         break;
@@ -631,20 +581,9 @@ static void file_emit_x86_64(CGContext *cg_ctx, Instructions_X86_64 inst, ...) {
     case INST_X86_64_SETCC:;
         ComparisonType comp_type = va_arg(operands, ComparisonType);
         RegDescriptor reg_desc = va_arg(operands, RegDescriptor);
-        switch (cg_ctx->target_asm_dialect) {
-        default:
-            print_error(ERR_COMMON,
-                        "Invalid ASM dialect for instruction : `cqo`");
-            break;
-        case TARGET_ASM_DIALECT_ATT:
-            fprintf(cg_ctx->fptr_code, "%s%s %%%s\n", mnemonic,
-                    comp_suffixes_x86_84[comp_type], get_reg_name_8(reg_desc));
-            break;
-        case TARGET_ASM_DIALECT_INTEL:
-            fprintf(cg_ctx->fptr_code, "%s%s %s\n", mnemonic,
-                    comp_suffixes_x86_84[comp_type], get_reg_name_8(reg_desc));
-            break;
-        }
+        out_buf_ostr(cg_ctx->code_out, mnemonic);
+        out_buf_str(cg_ctx->code_out, comp_suffixes_x86_84[comp_type]);
+        emit_x86_64_operands(cg_ctx, REG_8_OPERAND(reg_desc), NULL);
         break;
 
     case INST_X86_64_SAL:
@@ -661,22 +600,8 @@ static void file_emit_x86_64(CGContext *cg_ctx, Instructions_X86_64 inst, ...) {
             break;
         case OPERAND_TYPE_REG:;
             RegDescriptor shift_reg = va_arg(operands, RegDescriptor);
-            switch (cg_ctx->target_asm_dialect) {
-            default:
-                print_error(ERR_COMMON, "Unrecognized format for instruction : "
-                                        "`sal/shr/sar`");
-                break;
-            case TARGET_ASM_DIALECT_ATT:
-                fprintf(cg_ctx->fptr_code, "%s %%%s, %%%s\n", mnemonic,
-                        get_reg_name_8(REG_X86_64_RCX),
-                        get_reg_name(shift_reg));
-                break;
-            case TARGET_ASM_DIALECT_INTEL:
-                fprintf(cg_ctx->fptr_code, "%s %s, %s\n", mnemonic,
-                        get_reg_name(shift_reg),
-                        get_reg_name_8(REG_X86_64_RCX));
-                break;
-            }
+            emit_x86_64_inst(cg_ctx, mnemonic, REG_8_OPERAND(REG_X86_64_RCX),
+                             REG_OPERAND(shift_reg));
             break;
         }
         break;
@@ -686,17 +611,9 @@ static void file_emit_x86_64(CGContext *cg_ctx, Instructions_X86_64 inst, ...) {
         if (jmp_type > JMP_TYPE_COUNT)
             print_error(ERR_COMMON, "Invalid JCC type operation");
         const char *jmp_label = va_arg(operands, const char *);
-        switch (cg_ctx->target_asm_dialect) {
-        case TARGET_ASM_DIALECT_ATT:
-        case TARGET_ASM_DIALECT_INTEL:
-            fprintf(cg_ctx->fptr_code, "%s%s %s\n", mnemonic,
-                    jmp_type_x86_64_strings[jmp_type], jmp_label);
-            break;
-        default:
-            print_error(ERR_COMMON,
-                        "Invalid ASM dialect for instruction : `jmp/call`");
-            break;
-        }
+        out_buf_ostr(cg_ctx->code_out, mnemonic);
+        out_buf_str(cg_ctx->code_out, jmp_type_x86_64_strings[jmp_type]);
+        emit_x86_64_operands(cg_ctx, SYM_OPERAND(jmp_label), NULL);
         break;
 
     case INST_X86_64_XCHG:
@@ -736,16 +653,12 @@ CGContext *create_cgcontext_gnu_as_win(CGContext *parent_ctx) {
     // R15, and XMM6-XMM15 nonvolatile" Initialize the registers only when we
     // are creating the global context.
     if (parent_ctx == NULL) {
-        Reg *registers = calloc(REG_X86_64_COUNT, sizeof(Reg));
-        CHECK_NULL(registers, "Unable to allocate memory for registers array",
-                   NULL);
+        Reg *registers = (Reg *)arena_calloc(REG_X86_64_COUNT * sizeof(Reg));
         FOR_ALL_X86_64_REGS(INIT_REGISTER);
 
         int num_scratch_regs = 7;
-        Reg **scratch_registers = calloc(num_scratch_regs, sizeof(Reg *));
-        CHECK_NULL(registers,
-                   "Unable to allocate memory for scratch registers array",
-                   NULL);
+        Reg **scratch_registers =
+            (Reg **)arena_calloc(num_scratch_regs * sizeof(Reg *));
         scratch_registers[0] = registers + REG_X86_64_RAX;
         scratch_registers[1] = registers + REG_X86_64_RCX;
         scratch_registers[2] = registers + REG_X86_64_RDX;
@@ -764,11 +677,8 @@ CGContext *create_cgcontext_gnu_as_win(CGContext *parent_ctx) {
         pool = parent_ctx->reg_pool;
     }
 
-    CGContext *new_ctx = calloc(1, sizeof(CGContext));
-    CHECK_NULL(new_ctx, "Unable to allocate memory for new codegen context",
-               NULL);
+    CGContext *new_ctx = (CGContext *)arena_calloc(sizeof(CGContext));
     new_ctx->parent_ctx = parent_ctx;
-    new_ctx->local_env = create_env(NULL);
     new_ctx->local_offset = -32;
     new_ctx->reg_pool = pool;
 
@@ -776,28 +686,64 @@ CGContext *create_cgcontext_gnu_as_win(CGContext *parent_ctx) {
         new_ctx->target_fmt = TARGET_FMT_X86_64_GNU_AS;
         new_ctx->target_call_conv = TARGET_CALL_CONV_WIN;
         new_ctx->target_asm_dialect = TARGET_ASM_DIALECT_ATT;
-        ArchData *new_arch_data = calloc(1, sizeof(ArchData));
-        CHECK_NULL(new_ctx, "Unable to allocate memory for new ArchData", NULL);
+        new_ctx->codegen_verbose = 1;
+        ArchData *new_arch_data = (ArchData *)arena_calloc(sizeof(ArchData));
         new_ctx->arch_data = new_arch_data;
     } else {
         new_ctx->target_fmt = parent_ctx->target_fmt;
         new_ctx->target_call_conv = parent_ctx->target_call_conv;
         new_ctx->target_asm_dialect = parent_ctx->target_asm_dialect;
-        new_ctx->fptr_code = parent_ctx->fptr_code;
+        new_ctx->code_out = parent_ctx->code_out;
         new_ctx->arch_data = parent_ctx->arch_data;
+        new_ctx->task_state = parent_ctx->task_state;
+        new_ctx->codegen_verbose = parent_ctx->codegen_verbose;
+        new_ctx->func_cache_dir = parent_ctx->func_cache_dir;
     }
 
     return new_ctx;
 }
 
+CGContext *create_cgcontext_func_gnu_as_win(CGContext *parent_ctx) {
+    CGContext *new_ctx = create_cgcontext_gnu_as_win(parent_ctx);
+
+    // Function bodies are emitted out of line, so they start from a copy of
+    // the registers, and the call state at their definition, and leave the
+    // state of the enclosing code untouched. This also lets a body be
+    // generated on another thread.
+    RegPool *pool = &new_ctx->reg_pool;
+    Reg *registers = (Reg *)arena_calloc(pool->reg_cnt * sizeof(Reg));
+    memcpy(registers, pool->regs, pool->reg_cnt * sizeof(Reg));
+    Reg **scratch_registers =
+        (Reg **)arena_calloc(pool->scratch_reg_cnt * sizeof(Reg *));
+    for (int i = 0; i < pool->scratch_reg_cnt; i++)
+        scratch_registers[i] = registers + (pool->scratch_regs[i] - pool->regs);
+    pool->regs = registers;
+    pool->scratch_regs = scratch_registers;
+
+    ArchData *new_arch_data = (ArchData *)arena_calloc(sizeof(ArchData));
+    *new_arch_data = *(ArchData *)parent_ctx->arch_data;
+    new_ctx->arch_data = new_arch_data;
+
+    return new_ctx;
+}
+
+void cgcontext_write_cache_key_gnu_as_win(CGContext *cg_ctx, OutBuf *key) {
+    // Registers in use are skipped by the allocator, and the call state
+    // decides whether RAX is saved, so the code for a body depends on both.
+    for (int i = 0; i < cg_ctx->reg_pool.reg_cnt; i++)
+        out_buf_char(key, cg_ctx->reg_pool.regs[i].reg_in_use != 0);
+    ArchData *arch_data = cg_ctx->arch_data;
+    int64_t call_state[3] = {arch_data->func_call, arch_data->num_call_args,
+                             arch_data->is_rax_in_use};
+    out_buf_write(key, (const char *)call_state, sizeof(call_state));
+    out_buf_write(key, (const char *)&cg_ctx->local_offset,
+                  sizeof(cg_ctx->local_offset));
+}
+
 void free_cgcontext_gnu_as_win(CGContext *cg_ctx) {
-    if (cg_ctx->parent_ctx == NULL) {
-        free(cg_ctx->reg_pool.regs);
-        free(cg_ctx->reg_pool.scratch_regs);
-        free(cg_ctx->arch_data);
-    }
-    // Free environments.
-    free(cg_ctx);
+    // Contexts, register pools and environments are allocated from the
+    // compilation arena, and are released along with it.
+    (void)cg_ctx;
 }
 
 static RegDescriptor copy_ret_val_from_rax(CGContext *cg_ctx) {
@@ -1272,14 +1218,11 @@ void code_gen_set_func_ret_val_arch_x86_64(CGContext *cg_ctx,
 
 void code_gen_set_entry_point_arch_x86_64(CGContext *cg_ctx) {
 
-    fprintf(cg_ctx->fptr_code,
-            "%s"
-            ".section .text\n"
-            ".global main\n"
-            "main:\n",
-            cg_ctx->target_asm_dialect == TARGET_ASM_DIALECT_INTEL
-                ? ".intel_syntax noprefix\n"
-                : "");
+    if (cg_ctx->target_asm_dialect == TARGET_ASM_DIALECT_INTEL)
+        out_buf_str(cg_ctx->code_out, ".intel_syntax noprefix\n");
+    out_buf_str(cg_ctx->code_out, ".section .text\n"
+                                  ".global main\n"
+                                  "main:\n");
 
     code_gen_func_header_arch_x86_64(cg_ctx);
 }
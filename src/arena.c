@@ -0,0 +1,125 @@
+#include "../inc/arena.h"
+#include "../inc/utils.h"
+
+// Every thread compiles into an arena of its own.
+static _Thread_local Arena *curr_arena = NULL;
+
+static ArenaChunk *arena_chunk_alloc(Arena *arena, size_t chunk_size) {
+    ArenaChunk *chunk =
+        (ArenaChunk *)calloc(1, sizeof(ArenaChunk) + chunk_size);
+    CHECK_NULL(chunk, "Unable to allocate memory for a new arena chunk", NULL);
+    chunk->chunk_size = chunk_size;
+    chunk->chunk_used = 0;
+    arena->bytes_reserved += sizeof(ArenaChunk) + chunk_size;
+    return chunk;
+}
+
+Arena *arena_create(size_t chunk_size) {
+    Arena *arena = (Arena *)calloc(1, sizeof(Arena));
+    CHECK_NULL(arena, "Unable to allocate memory for a new arena", NULL);
+    arena->chunk_size = chunk_size == 0 ? ARENA_CHUNK_SIZE : chunk_size;
+    arena->curr_chunk = NULL;
+    arena->bytes_used = 0;
+    arena->bytes_reserved = 0;
+    arena->alloc_count = 0;
+    return arena;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    if (arena == NULL)
+        print_error(ERR_DEV, "NULL arena passed to `arena_alloc()`");
+
+    // Round up the size, so that the next allocation stays aligned.
+    size = (size + ARENA_ALIGNMENT - 1) & ~((size_t)ARENA_ALIGNMENT - 1);
+    arena->bytes_used += size;
+    arena->alloc_count += 1;
+
+    ArenaChunk *chunk = arena->curr_chunk;
+    if (chunk != NULL && chunk->chunk_size - chunk->chunk_used >= size) {
+        void *mem = chunk->data + chunk->chunk_used;
+        chunk->chunk_used += size;
+        return mem;
+    }
+
+    if (size > arena->chunk_size && chunk != NULL) {
+        // Large allocations get a chunk of their own, which is slotted in
+        // behind the current chunk, so that its free space isn't lost.
+        ArenaChunk *big_chunk = arena_chunk_alloc(arena, size);
+        big_chunk->chunk_used = size;
+        big_chunk->prev_chunk = chunk->prev_chunk;
+        chunk->prev_chunk = big_chunk;
+        return big_chunk->data;
+    }
+
+    chunk = arena_chunk_alloc(
+        arena, size > arena->chunk_size ? size : arena->chunk_size);
+    chunk->chunk_used = size;
+    chunk->prev_chunk = arena->curr_chunk;
+    arena->curr_chunk = chunk;
+    return chunk->data;
+}
+
+char *arena_strndup(Arena *arena, const char *str, size_t len) {
+    char *copy = (char *)arena_alloc(arena, len + 1);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+// Releases every chunk, starting from `chunk`, and going backwards.
+static void arena_free_chunks(ArenaChunk *chunk) {
+    while (chunk != NULL) {
+        ArenaChunk *prev_chunk = chunk->prev_chunk;
+        free(chunk);
+        chunk = prev_chunk;
+    }
+}
+
+void arena_reset(Arena *arena) {
+    // The first chunk is kept, so that an arena reset after every small
+    // compilation unit doesn't go back to the system each time. Only the
+    // part of it that was handed out has to be zeroed again.
+    ArenaChunk *first_chunk = arena->curr_chunk;
+    ArenaChunk *next_chunk = NULL;
+    while (first_chunk != NULL && first_chunk->prev_chunk != NULL) {
+        next_chunk = first_chunk;
+        first_chunk = first_chunk->prev_chunk;
+    }
+    if (first_chunk != NULL && first_chunk->chunk_size != arena->chunk_size) {
+        next_chunk = first_chunk;
+        first_chunk = NULL;
+    }
+    if (next_chunk != NULL) {
+        next_chunk->prev_chunk = NULL;
+        arena_free_chunks(arena->curr_chunk);
+    }
+
+    arena->curr_chunk = first_chunk;
+    arena->bytes_used = 0;
+    arena->bytes_reserved = 0;
+    arena->alloc_count = 0;
+    if (first_chunk != NULL) {
+        memset(first_chunk->data, 0, first_chunk->chunk_used);
+        first_chunk->chunk_used = 0;
+        arena->bytes_reserved = sizeof(ArenaChunk) + first_chunk->chunk_size;
+    }
+}
+
+void arena_destroy(Arena *arena) {
+    if (arena == NULL)
+        return;
+    arena_free_chunks(arena->curr_chunk);
+    if (curr_arena == arena)
+        curr_arena = NULL;
+    free(arena);
+}
+
+void arena_set_current(Arena *arena) { curr_arena = arena; }
+
+Arena *arena_get_current() { return curr_arena; }
+
+void *arena_calloc(size_t size) {
+    if (curr_arena == NULL)
+        print_error(ERR_DEV, "No arena set for the current compilation");
+    return arena_alloc(curr_arena, size);
+}
@@ -1,11 +1,12 @@
 #include "../inc/ast_funcs.h"
+#include "../inc/arena.h"
+#include "../inc/intern.h"
 #include "../inc/lexer.h"
 #include "../inc/parser.h"
+#include "../inc/pass_stats.h"
 #include "../inc/utils.h"
 
-char node_buf[NODE_BUF_SIZE] = {0};
-
-char *get_node_str(AstNode *node) {
+char *get_node_str(AstNode *node, char *node_buf) {
     switch (node->type) {
     case TYPE_NULL:
         snprintf(node_buf, NODE_BUF_SIZE, "NULL");
@@ -66,13 +67,20 @@ char *get_node_str(AstNode *node) {
     return node_buf;
 }
 
+// Prints a single node, the buffer is kept out of the recursion in
+// `print_ast_node()`.
+static void print_ast_node_line(AstNode *node, int indent) {
+    char node_buf[NODE_BUF_SIZE];
+    for (int i = 0; i < indent; i++)
+        putchar(' ');
+    printf("%s\n", get_node_str(node, node_buf));
+}
+
 void print_ast_node(AstNode *root_node, int indent) {
     if (root_node == NULL) {
         return;
     }
-    for (int i = 0; i < indent; i++)
-        putchar(' ');
-    printf("%s\n", get_node_str(root_node));
+    print_ast_node_line(root_node, indent);
     AstNode *child_node = root_node->child;
     while (child_node != NULL) {
         print_ast_node(child_node, indent + 4);
@@ -80,7 +88,7 @@ void print_ast_node(AstNode *root_node, int indent) {
     }
 }
 
-int node_cmp(AstNode *node1, AstNode *node2) {
+int node_cmp(const AstNode *node1, const AstNode *node2) {
     if (node1 == NULL && node2 == NULL)
         return 1;
     if ((node1 == NULL && node2 != NULL) || (node1 != NULL && node2 == NULL))
@@ -115,13 +123,8 @@ int node_cmp(AstNode *node1, AstNode *node2) {
     case TYPE_BINARY_OPERATOR:
     case TYPE_VAR_ACCESS:
     case TYPE_SYM:
-        if (node1->ast_val.node_symbol != NULL &&
-            node2->ast_val.node_symbol != NULL &&
-            (strcmp(node1->ast_val.node_symbol, node2->ast_val.node_symbol) ==
-             0))
-            return 1;
-        else if (node1->ast_val.node_symbol == NULL &&
-                 node2->ast_val.node_symbol == NULL)
+        // Symbols are interned, so equal symbols share the same pointer.
+        if (node1->ast_val.node_symbol == node2->ast_val.node_symbol)
             return 1;
         break;
     default:
@@ -132,8 +135,8 @@ int node_cmp(AstNode *node1, AstNode *node2) {
 }
 
 AstNode *node_alloc() {
-    AstNode *new_node = (AstNode *)calloc(1, sizeof(AstNode));
-    CHECK_NULL(new_node, "Unable to allocate memory for a new node", NULL);
+    pass_stats.ast_nodes += 1;
+    AstNode *new_node = (AstNode *)arena_calloc(sizeof(AstNode));
     new_node->type = TYPE_NULL;
     new_node->child = NULL;
     new_node->next_child = NULL;
@@ -147,10 +150,7 @@ AstNode *node_alloc() {
 AstNode *create_node_symbol(char *symbol_str) {
     AstNode *sym_node = node_alloc();
     sym_node->type = TYPE_SYM;
-    size_t len = strlen(symbol_str);
-    sym_node->ast_val.node_symbol = (char *)calloc(len + 1, sizeof(char));
-    strcpy(sym_node->ast_val.node_symbol, symbol_str);
-    sym_node->ast_val.node_symbol[len] = '\0';
+    sym_node->ast_val.node_symbol = intern_str(symbol_str);
     return sym_node;
 }
 
@@ -169,26 +169,6 @@ AstNode *create_node_int(long val) {
     return int_node;
 }
 
-void free_node(AstNode *node_to_free) {
-    if (node_to_free == NULL) {
-        return;
-    }
-    AstNode *temp = node_to_free->child;
-    while (temp != NULL) {
-        free_node(temp);
-        temp = temp->child;
-    }
-
-    AstNode *temp1 = NULL;
-    while (temp != NULL) {
-        temp1 = temp->next_child;
-        if (temp->ast_val.node_symbol != NULL)
-            free(temp->ast_val.node_symbol);
-        free(temp);
-        temp = temp1;
-    }
-}
-
 AstNode *node_symbol_from_token_create(LexedToken *token) {
 
     if (token == NULL) {
@@ -196,29 +176,25 @@ AstNode *node_symbol_from_token_create(LexedToken *token) {
     }
 
     AstNode *node = node_alloc();
-    char *symbol_str = (char *)calloc(token->token_length + 1, sizeof(char));
-    CHECK_NULL(symbol_str, "Unable to allocate memory for a new symbol node",
-               NULL);
-    memcpy(symbol_str, token->token_start, token->token_length);
-    symbol_str[token->token_length] = '\0';
-    node->ast_val.node_symbol = symbol_str;
+    node->ast_val.node_symbol = lexed_token_str(token);
     node->type = TYPE_SYM;
     return node;
 }
 
-int copy_node(AstNode *dst_node, AstNode *src_node) {
+int copy_node(AstNode *dst_node, const AstNode *src_node) {
+    pass_stats.copy_node_calls += 1;
     if (src_node == NULL || dst_node == NULL)
         return 0;
 
     dst_node->type = src_node->type;
     dst_node->pointer_level = src_node->pointer_level;
 
-    if (src_node->ast_val.node_symbol != NULL)
-        dst_node->ast_val.node_symbol = strdup(src_node->ast_val.node_symbol);
-    else
-        dst_node->ast_val.node_symbol = NULL;
+    // Symbols are interned, and are shared instead of being copied.
+    dst_node->ast_val.node_symbol = src_node->ast_val.node_symbol;
 
     dst_node->ast_val.val = src_node->ast_val.val;
+    dst_node->sym = src_node->sym;
+    dst_node->scope = src_node->scope;
 
     AstNode *temp_child = src_node->child;
     AstNode *temp_dst_child = NULL;
@@ -247,6 +223,7 @@ int copy_node(AstNode *dst_node, AstNode *src_node) {
         copy_node(temp_dst_child, temp_child);
         temp_child = temp_child->next_child;
     }
+    dst_node->last_child = temp_dst_child;
     return 0;
 }
 
@@ -255,22 +232,36 @@ void add_ast_node_child(AstNode *parent_node, AstNode *child_to_add) {
         return;
     if (parent_node->child == NULL) {
         parent_node->child = child_to_add;
+        parent_node->last_child = child_to_add;
         return;
     }
-    AstNode *temp_child = parent_node->child;
-    if (temp_child == child_to_add) {
-        print_warning(ERR_DEV, "Could not add new child to the AST due"
-                               "to creation of possible circular linked list");
-        return;
-    }
-    while (temp_child->next_child != NULL) {
+
+    // The parser also links some children in directly, so the last child
+    // added here is only where the walk to the end starts.
+    AstNode *temp_child = parent_node->last_child;
+    if (temp_child == NULL)
+        temp_child = parent_node->child;
+    while (temp_child->next_child != NULL)
         temp_child = temp_child->next_child;
-        if (temp_child == child_to_add) {
-            print_warning(ERR_DEV,
-                          "Could not add new child to the AST due"
-                          "to creation of possible circular linked list");
-            return;
+    temp_child->next_child = child_to_add;
+    parent_node->last_child = child_to_add;
+}
+
+void ast_verify(const AstNode *node) {
+    // Two cursors, one moving twice as fast, meet only if the list loops.
+    const AstNode *slow = node->child;
+    const AstNode *fast = node->child;
+    while (fast != NULL && fast->next_child != NULL) {
+        slow = slow->next_child;
+        fast = fast->next_child->next_child;
+        if (slow == fast) {
+            char node_buf[NODE_BUF_SIZE] = {0};
+            print_error(ERR_DEV, "Found a circular list of children for : %s",
+                        get_node_str((AstNode *)node, node_buf));
         }
     }
-    temp_child->next_child = child_to_add;
+
+    for (const AstNode *child = node->child; child != NULL;
+         child = child->next_child)
+        ast_verify(child);
 }
@@ -1,23 +1,49 @@
 #include "../inc/code_gen.h"
 #include "../inc/arch/platforms.h"
+#include "../inc/arena.h"
 #include "../inc/ast_funcs.h"
 #include "../inc/env_funcs.h"
+#include "../inc/func_cache.h"
+#include "../inc/intern.h"
 #include "../inc/parser.h"
+#include "../inc/pass_stats.h"
+#include "../inc/type_table.h"
 #include "../inc/utils.h"
+#include <fcntl.h>
 #include <inttypes.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-char label_arr[LABEL_ARR_SIZE];
-int label_cnt = 0;
-int label_idx = 0;
+#define LABEL_BUFFER_SIZE 1024
 
-char sym_arr[SYM_ARR_SIZE];
-int sym_cnt = 0;
-int sym_idx = 0;
+// Function body handed to a worker. Its output is generated into a buffer of
+// its own, which is spliced into the output of the program at `out_offset`.
+typedef struct CGFuncTask {
+    CGContext *cg_ctx;
+    ParsingContext *context;
+    char *func_name;
+    AstNode *func;
+    FuncCacheKey *cache_key;
+    long label_start;
+    long label_end;
+    size_t out_offset;
+    BuiltinSyms builtin_syms;
+    PassStats stats;
+    char *code;
+    size_t code_len;
+    char has_error;
+    ErrType err;
+    char err_msg[ERR_MSG_SIZE];
+    struct CGFuncTask *next;
+} CGFuncTask;
 
 void target_codegen_func(CGContext *cg_ctx, ParsingContext *context,
-                         ParsingContext **ctx_next_child, char *func_name,
-                         AstNode *func);
-char codegen_verbose = 1;
+                         char *func_name, AstNode *func);
+
+static void target_codegen_func_cached(CGContext *cg_ctx,
+                                       ParsingContext *context,
+                                       char *func_name, AstNode *func,
+                                       FuncCacheKey *cache_key);
 
 char is_valid_reg_desc(CGContext *cg_ctx, RegDescriptor reg_desc) {
     return reg_desc >= 0 && reg_desc <= cg_ctx->reg_pool.reg_cnt;
@@ -32,6 +58,7 @@ RegDescriptor reg_alloc(CGContext *cg_ctx) {
     for (RegDescriptor i = 0; i < cg_ctx->reg_pool.scratch_reg_cnt; i++) {
         if (reg_iterator[i].reg_in_use == 0) {
             reg_iterator[i].reg_in_use = 1;
+            pass_stats.regs_allocated += 1;
             return reg_iterator[i].reg_desc;
         }
     }
@@ -49,16 +76,106 @@ void reg_dealloc(CGContext *cg_ctx, RegDescriptor reg_desc) {
 }
 
 // Generate labels for lambda functions.
-static char *gen_label() {
-    char *label = label_arr + label_idx;
-    label_idx += snprintf(label, LABEL_ARR_SIZE - label_idx, ".L%d", label_cnt);
-    label_idx++;
-    if (label_idx > LABEL_ARR_SIZE) {
-        label_idx = 0;
-        return gen_label();
+static char *gen_label(CGContext *cg_ctx) {
+    char label[LABEL_BUFFER_SIZE];
+    int len = snprintf(label, sizeof(label), ".L%ld",
+                       cg_ctx->task_state->label_cnt++);
+    return arena_strndup(arena_get_current(), label, len);
+}
+
+// Counts the labels generated for the expressions below `node`, i.e. one for
+// every function, and two for every if condition.
+static long count_labels(AstNode *node) {
+    long label_cnt = 0;
+    for (AstNode *child = node->child; child != NULL;
+         child = child->next_child) {
+        if (child->type == TYPE_FUNCTION)
+            label_cnt += 1;
+        else if (child->type == TYPE_IF_CONDITION)
+            label_cnt += 2;
+        label_cnt += count_labels(child);
+    }
+    return label_cnt;
+}
+
+// Generates a function body on a worker, picking up the label numbering
+// where the enclosing code left it, so that the output matches serial code
+// generation.
+static void target_codegen_func_task(void *task_data) {
+    CGFuncTask *task = (CGFuncTask *)task_data;
+
+    // Counters of the body are kept apart, and added to the compilation once
+    // it's spliced in.
+    PassStats worker_stats = pass_stats;
+    pass_stats_reset();
+
+    // Interned symbols are compared by pointer, so the body has to see the
+    // built-in symbols of the thread, that parsed it.
+    BuiltinSyms worker_syms = builtin_syms;
+    builtin_syms = task->builtin_syms;
+
+    CGTaskState task_state = {0};
+    task_state.label_cnt = task->label_start;
+    OutBuf *code_out = out_buf_create_mem();
+    task->cg_ctx->task_state = &task_state;
+    task->cg_ctx->code_out = code_out;
+
+    // Errors are kept in the task, and reported by the thread that splices
+    // the bodies in, rather than exiting from a worker.
+    ErrTrap trap;
+    err_trap_push(&trap);
+    if (setjmp(trap.env) == 0) {
+        target_codegen_func(task->cg_ctx, task->context, task->func_name,
+                            task->func);
+        if (task_state.label_cnt != task->label_end)
+            print_error(ERR_DEV, "Label count mismatch for function : `%s`",
+                        task->func_name);
+        task->code = out_buf_release(code_out, &task->code_len);
+        if (task->cache_key != NULL)
+            func_cache_store(task->cache_key, task->code, task->code_len);
+    } else {
+        task->has_error = 1;
+        task->err = trap.err;
+        memcpy(task->err_msg, trap.msg, ERR_MSG_SIZE);
+        out_buf_destroy(code_out);
     }
-    label_cnt++;
-    return label;
+    err_trap_pop(&trap);
+
+    builtin_syms = worker_syms;
+    task->stats = pass_stats;
+    pass_stats = worker_stats;
+}
+
+// Emits a label, made up of `prefix`, and `label`.
+static void emit_label(OutBuf *code_out, const char *prefix,
+                       const char *label) {
+    out_buf_str(code_out, prefix);
+    out_buf_str(code_out, label);
+    out_buf_write(code_out, ":\n", 2);
+}
+
+// Emits a comment, followed by a string.
+static void emit_comment_str(OutBuf *code_out, const char *comment,
+                             const char *str) {
+    out_buf_str(code_out, comment);
+    out_buf_str(code_out, str);
+    out_buf_char(code_out, '\n');
+}
+
+// Emits a comment, followed by a symbol in backticks.
+static void emit_comment_sym(OutBuf *code_out, const char *comment,
+                             const char *sym) {
+    out_buf_str(code_out, comment);
+    out_buf_char(code_out, '`');
+    out_buf_str(code_out, sym);
+    out_buf_write(code_out, "`\n", 2);
+}
+
+// Emits a comment, followed by an integer.
+static void emit_comment_int(OutBuf *code_out, const char *comment, long val) {
+    out_buf_str(code_out, comment);
+    out_buf_int(code_out, val);
+    out_buf_char(code_out, '\n');
 }
 
 typedef struct SymToAddr {
@@ -78,154 +195,124 @@ SymToAddr map_sym_to_addr(CGContext *cg_ctx, AstNode *sym_node) {
         cg_ctx == NULL)
         print_error(ERR_DEV, "map_sym_to_addr() : NULL symbol/codegen context");
 
+    if (sym_node->sym == NULL)
+        print_error(ERR_COMMON,
+                    "Unable to find information in code gen "
+                    "context for : `%s`",
+                    sym_node->ast_val.node_symbol);
+
     SymToAddr sym_addr;
 
-    if (cg_ctx->parent_ctx == NULL) {
+    if (!sym_node->sym->is_local) {
         sym_addr.type = SYM_ADDR_GLOBAL;
         sym_addr.val.global = sym_node->ast_val.node_symbol;
         return sym_addr;
     }
 
-    int stat = -1;
-    AstNode *local_var = get_env(cg_ctx->local_env, sym_node, &stat);
-    if (stat == 0)
-        print_error(ERR_COMMON,
-                    "Unable to find information in code gen "
-                    "context for : `%s`",
-                    sym_node->ast_val.node_symbol);
-
-    long addr = local_var->ast_val.val;
-    free(local_var);
     sym_addr.type = SYM_ADDR_LOCAL;
-    sym_addr.val.local = addr;
+    sym_addr.val.local = sym_node->sym->frame_offset;
 
     return sym_addr;
 }
 
-void target_codegen_expr(ParsingContext *context,
-                         ParsingContext **ctx_next_child, AstNode *curr_expr,
-                         CGContext *cg_ctx, FILE *fptr_code) {
+void target_codegen_expr(ParsingContext *context, AstNode *curr_expr,
+                         CGContext *cg_ctx, OutBuf *code_out) {
     switch (curr_expr->type) {
 
     case TYPE_VAR_DECLARATION:
         if (cg_ctx->parent_ctx == NULL)
             break;
 
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; Variable Declaration : `%s`\n",
-                    curr_expr->child->ast_val.node_symbol);
+        if (cg_ctx->codegen_verbose)
+            emit_comment_sym(code_out, ";#; Variable Declaration : ",
+                             curr_expr->child->ast_val.node_symbol);
 
-        AstNode *var_node = NULL;
-        int stat = -1;
-        var_node = parser_get_var(context, curr_expr->child, &stat);
-        if (stat == 0)
-            print_error(ERR_COMMON,
-                        "Unable to find variable in environment : `%s`",
+        // The type checker has typed, and sized the variable.
+        const AstNode *var_node = curr_expr->child->val_type;
+        if (var_node == NULL)
+            print_error(ERR_DEV, "Variable wasn't type checked : `%s`",
                         curr_expr->child->ast_val.node_symbol);
 
-        if (strcmp(var_node->ast_val.node_symbol, "ext function") == 0)
+        if (var_node->ast_val.node_symbol == builtin_syms.ext_function)
             break;
 
-        AstNode *type_node = NULL;
-        type_node = parser_get_type(context, var_node, &stat);
-        long size_in_bytes = type_node->child->ast_val.val;
-        if (!stat)
-            print_error(ERR_COMMON, "Couldn't find information for type : `%s`",
-                        type_node->ast_val.node_symbol);
-
+        long size_in_bytes = curr_expr->child->val_size;
         code_gen_allocate_on_stack(cg_ctx, size_in_bytes);
         cg_ctx->local_offset -= size_in_bytes;
-        if (!set_env(&cg_ctx->local_env, curr_expr->child,
-                     create_node_int(cg_ctx->local_offset)))
-            print_error(ERR_COMMON,
-                        "Unable to set locals environment in code gen context "
-                        "for : `%s`",
-                        curr_expr->child->ast_val.node_symbol);
+        curr_expr->child->sym->frame_offset = cg_ctx->local_offset;
         break;
 
     case TYPE_INT:
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; Literal Integer : %ld\n",
-                    curr_expr->ast_val.val);
+        if (cg_ctx->codegen_verbose)
+            emit_comment_int(code_out, ";#; Literal Integer : ",
+                             curr_expr->ast_val.val);
         curr_expr->result_reg_desc =
             code_gen_get_imm(cg_ctx, curr_expr->ast_val.val);
         break;
 
     case TYPE_VAR_ACCESS:
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; Variable Access : `%s`\n",
-                    curr_expr->ast_val.node_symbol);
-
-        CGContext *var_cg_ctx = cg_ctx;
-        stat = -1;
-        AstNode *local_var_name;
-        while (var_cg_ctx != NULL) {
-            local_var_name = get_env_from_sym(
-                var_cg_ctx->local_env, curr_expr->ast_val.node_symbol, &stat);
-            if (stat)
-                break;
-            if (var_cg_ctx->parent_ctx != NULL)
-                free_node(local_var_name);
-            var_cg_ctx = var_cg_ctx->parent_ctx;
-        }
+        if (cg_ctx->codegen_verbose)
+            emit_comment_sym(code_out, ";#; Variable Access : ",
+                             curr_expr->ast_val.node_symbol);
+
+        // The parser has bound the access to the declaration, whose frame
+        // offset was set when it was generated.
+        const Symbol *var_sym = curr_expr->sym;
+        if (var_sym == NULL)
+            print_error(ERR_COMMON,
+                        "Unable to find information regarding local "
+                        "variable offset for: `%s`",
+                        curr_expr->ast_val.node_symbol);
 
-        if (var_cg_ctx == NULL) {
+        if (!var_sym->is_local)
             curr_expr->result_reg_desc =
                 code_gen_get_global(cg_ctx, curr_expr->ast_val.node_symbol);
-
-        } else {
-            // Check if `stat` isn't 0, i.e. the variable was found.
-            if (stat == 0)
-                print_error(ERR_COMMON,
-                            "Unable to find information regarding local "
-                            "variable offset for: `%s`",
-                            curr_expr->ast_val.node_symbol);
+        else
             curr_expr->result_reg_desc =
-                code_gen_get_local(cg_ctx, local_var_name->ast_val.val);
-        }
+                code_gen_get_local(cg_ctx, var_sym->frame_offset);
         break;
 
     case TYPE_BINARY_OPERATOR:;
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; Binary Operator : %s\n",
-                    curr_expr->ast_val.node_symbol);
+        if (cg_ctx->codegen_verbose)
+            emit_comment_str(code_out, ";#; Binary Operator : ",
+                             curr_expr->ast_val.node_symbol);
         // Move the integers on the left and right hand side into different
         // registers.
         // See: https://www.felixcloutier.com/x86/
-        target_codegen_expr(context, ctx_next_child, curr_expr->child, cg_ctx,
-                            fptr_code);
-        target_codegen_expr(context, ctx_next_child,
-                            curr_expr->child->next_child, cg_ctx, fptr_code);
+        target_codegen_expr(context, curr_expr->child, cg_ctx, code_out);
+        target_codegen_expr(context, curr_expr->child->next_child, cg_ctx,
+                            code_out);
 
-        if (strcmp(curr_expr->ast_val.node_symbol, ">") == 0) {
+        switch (curr_expr->ast_val.val) {
+        case BIN_OP_GT:
             curr_expr->result_reg_desc = code_gen_compare(
                 cg_ctx, COMP_GT, curr_expr->child->result_reg_desc,
                 curr_expr->child->next_child->result_reg_desc);
-
-        } else if (strcmp(curr_expr->ast_val.node_symbol, "<") == 0) {
+            break;
+        case BIN_OP_LT:
             curr_expr->result_reg_desc = code_gen_compare(
                 cg_ctx, COMP_LT, curr_expr->child->result_reg_desc,
                 curr_expr->child->next_child->result_reg_desc);
-
-        } else if (strcmp(curr_expr->ast_val.node_symbol, "==") == 0) {
+            break;
+        case BIN_OP_EQ:
             curr_expr->result_reg_desc = code_gen_compare(
                 cg_ctx, COMP_EQ, curr_expr->child->result_reg_desc,
                 curr_expr->child->next_child->result_reg_desc);
-
-        } else if (strcmp(curr_expr->ast_val.node_symbol, "+") == 0) {
+            break;
+        case BIN_OP_ADD:
             curr_expr->result_reg_desc =
                 code_gen_add(cg_ctx, curr_expr->child->result_reg_desc,
                              curr_expr->child->next_child->result_reg_desc);
-
-        } else if (strcmp(curr_expr->ast_val.node_symbol, "-") == 0) {
+            break;
+        case BIN_OP_SUB:
             // Subtract those registers and save the result in the LHS register.
             // `sub` operation subtracts the first operand from the second
             // operand, and stores it in the second operand.
             curr_expr->result_reg_desc =
                 code_gen_sub(cg_ctx, curr_expr->child->result_reg_desc,
                              curr_expr->child->next_child->result_reg_desc);
-
-        } else if (strcmp(curr_expr->ast_val.node_symbol, "<<") == 0) {
+            break;
+        case BIN_OP_SHL:
             // Since shift left is destructive, we use the expression result
             // register as the LHS register. The RHS or the amount by which the
             // shift left needs to be done is placed into RCX, which is used by
@@ -234,8 +321,8 @@ void target_codegen_expr(ParsingContext *context,
             curr_expr->result_reg_desc = code_gen_shift_left(
                 cg_ctx, curr_expr->child->result_reg_desc,
                 curr_expr->child->next_child->result_reg_desc);
-
-        } else if (strcmp(curr_expr->ast_val.node_symbol, ">>") == 0) {
+            break;
+        case BIN_OP_SHR:
             // Since shift right is destructive, we use the expression result
             // register as the LHS register. The RHS or the amount by which the
             // shift right needs to be done is placed into RCX, which is used by
@@ -244,53 +331,49 @@ void target_codegen_expr(ParsingContext *context,
             curr_expr->result_reg_desc = code_gen_shift_right_arithmetic(
                 cg_ctx, curr_expr->child->result_reg_desc,
                 curr_expr->child->next_child->result_reg_desc);
-
-        } else if (strcmp(curr_expr->ast_val.node_symbol, "*") == 0) {
+            break;
+        case BIN_OP_MUL:
             curr_expr->result_reg_desc =
                 code_gen_mul(cg_ctx, curr_expr->child->result_reg_desc,
                              curr_expr->child->next_child->result_reg_desc);
-
-        } else if (strcmp(curr_expr->ast_val.node_symbol, "/") == 0) {
+            break;
+        case BIN_OP_DIV:
             curr_expr->result_reg_desc =
                 code_gen_div(cg_ctx, curr_expr->child->result_reg_desc,
                              curr_expr->child->next_child->result_reg_desc);
-
-        } else if (strcmp(curr_expr->ast_val.node_symbol, "%") == 0) {
+            break;
+        case BIN_OP_MOD:
             curr_expr->result_reg_desc =
                 code_gen_mod(cg_ctx, curr_expr->child->result_reg_desc,
                              curr_expr->child->next_child->result_reg_desc);
-
-        } else
+            break;
+        default:
             print_error(ERR_COMMON, "Found unknown binary operator : `%s`",
                         curr_expr->ast_val.node_symbol);
+        }
         break;
 
     case TYPE_FUNCTION_CALL:;
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; Function Call : `%s`\n",
-                    curr_expr->child->ast_val.node_symbol);
+        if (cg_ctx->codegen_verbose)
+            emit_comment_sym(code_out, ";#; Function Call : ",
+                             curr_expr->child->ast_val.node_symbol);
 
         code_gen_setup_func_call(cg_ctx);
 
-        stat = -1;
-        AstNode *func_call_type =
-            parser_get_var(context, curr_expr->child, &stat);
-        if (!stat)
-            print_error(
-                ERR_TYPE,
-                "Unable to find type information in environment, for: `%s`",
-                curr_expr->child->ast_val.node_symbol);
+        const AstNode *func_call_type = curr_expr->child->val_type;
+        if (func_call_type == NULL)
+            print_error(ERR_DEV, "Function call wasn't type checked : `%s`",
+                        curr_expr->child->ast_val.node_symbol);
 
         AstNode *call_params = curr_expr->child->next_child->child;
-        if (strcmp(func_call_type->ast_val.node_symbol, "ext function") == 0) {
+        if (func_call_type->ast_val.node_symbol == builtin_syms.ext_function) {
             // Save the following registers before using them since they
             // are scratch registers.
 
             // Put function arguments in RCX, RDX, R8 and R9. If more exist push
             // onto stack in reverse order.
             while (call_params != NULL) {
-                target_codegen_expr(context, ctx_next_child, call_params,
-                                    cg_ctx, fptr_code);
+                target_codegen_expr(context, call_params, cg_ctx, code_out);
                 code_gen_ext_func_arg(cg_ctx, call_params->result_reg_desc);
                 call_params = call_params->next_child;
             }
@@ -304,8 +387,7 @@ void target_codegen_expr(ParsingContext *context,
         } else {
             // Push arguments onto the stack in order.
             while (call_params != NULL) {
-                target_codegen_expr(context, ctx_next_child, call_params,
-                                    cg_ctx, fptr_code);
+                target_codegen_expr(context, call_params, cg_ctx, code_out);
                 code_gen_func_arg(cg_ctx, call_params->result_reg_desc);
                 reg_dealloc(cg_ctx, call_params->result_reg_desc);
                 call_params = call_params->next_child;
@@ -329,8 +411,7 @@ void target_codegen_expr(ParsingContext *context,
             // need to var access the name of the "function variable" and call
             // it's result register. See TYPE_FUNCTION for more details.
 
-            target_codegen_expr(context, ctx_next_child, curr_expr->child,
-                                cg_ctx, fptr_code);
+            target_codegen_expr(context, curr_expr->child, cg_ctx, code_out);
             curr_expr->result_reg_desc =
                 code_gen_func_call(cg_ctx, curr_expr->child->result_reg_desc);
             if (curr_expr->result_reg_desc != curr_expr->child->result_reg_desc)
@@ -342,28 +423,70 @@ void target_codegen_expr(ParsingContext *context,
         break;
 
     case TYPE_FUNCTION:;
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; Function Definition\n");
+        if (cg_ctx->codegen_verbose)
+            out_buf_str(code_out, ";#; Function Definition\n");
 
         ParsingContext *tmp_ctx = context;
-        AstNode *func_id = NULL;
-        stat = -1;
+        const AstNode *func_id = NULL;
+        int stat = -1;
         while (tmp_ctx != NULL) {
-            func_id = get_env_from_val(context->funcs, curr_expr, &stat);
+            func_id = get_env_ref_from_val(context->funcs, curr_expr, &stat);
             if (stat)
                 break;
             tmp_ctx = tmp_ctx->parent_ctx;
-            if (tmp_ctx != NULL)
-                free_node(func_id);
         }
+        CGTaskState *task_state = cg_ctx->task_state;
+        long label_first = task_state->label_cnt;
         char *func_name = NULL;
         if (stat)
             func_name = func_id->ast_val.node_symbol;
         else
-            func_name = gen_label();
+            func_name = gen_label(cg_ctx);
+
+        // Functions with an empty body have no context of their own.
+        AstNode *func_body = curr_expr->child->next_child->next_child;
+        ParsingContext *func_ctx = context;
+        if (func_body != NULL && func_body->scope != NULL)
+            func_ctx = func_body->scope;
+
+        CGContext *func_cg_ctx = create_cgcontext_func(cg_ctx);
+        FuncCacheKey *cache_key = NULL;
+        if (cg_ctx->func_cache_dir != NULL) {
+            long label_count = task_state->label_cnt - label_first +
+                               count_labels(curr_expr);
+            cache_key = func_cache_key(func_cg_ctx, func_ctx, curr_expr,
+                                       stat ? func_name : NULL, label_first,
+                                       label_count);
+        }
 
-        target_codegen_func(cg_ctx, context, ctx_next_child, func_name,
-                            curr_expr);
+        if (cache_key != NULL && func_cache_load(cache_key, code_out)) {
+            pass_stats.func_cache_hits += 1;
+            task_state->label_cnt = label_first + cache_key->label_count;
+        } else if (task_state->pool != NULL) {
+            CGFuncTask *task = (CGFuncTask *)arena_calloc(sizeof(CGFuncTask));
+            task->cg_ctx = func_cg_ctx;
+            task->context = func_ctx;
+            task->func_name = func_name;
+            task->func = curr_expr;
+            task->cache_key = cache_key;
+            pass_stats.func_cache_misses += cache_key != NULL;
+            task->builtin_syms = builtin_syms;
+            task->label_start = task_state->label_cnt;
+            task_state->label_cnt += count_labels(curr_expr);
+            task->label_end = task_state->label_cnt;
+            task->out_offset = code_out->used;
+
+            if (task_state->func_tasks_tail == NULL)
+                task_state->func_tasks = task;
+            else
+                task_state->func_tasks_tail->next = task;
+            task_state->func_tasks_tail = task;
+            task_pool_submit(task_state->pool, target_codegen_func_task, task);
+        } else if (cache_key != NULL)
+            target_codegen_func_cached(func_cg_ctx, func_ctx, func_name,
+                                       curr_expr, cache_key);
+        else
+            target_codegen_func(func_cg_ctx, func_ctx, func_name, curr_expr);
 
         /**
          * Now that functions are being treated as variables we can use
@@ -390,8 +513,8 @@ void target_codegen_expr(ParsingContext *context,
         break;
 
     case TYPE_VAR_REASSIGNMENT:
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; Variable Re-assignment\n");
+        if (cg_ctx->codegen_verbose)
+            out_buf_str(code_out, ";#; Variable Re-assignment\n");
 
         AstNode *temp_sym = curr_expr->child;
         while (temp_sym != NULL && temp_sym->type != TYPE_VAR_ACCESS)
@@ -400,8 +523,8 @@ void target_codegen_expr(ParsingContext *context,
             print_error(ERR_COMMON, "Unable to find valid variable access in a "
                                     "variable Re-assignment");
 
-        target_codegen_expr(context, ctx_next_child,
-                            curr_expr->child->next_child, cg_ctx, fptr_code);
+        target_codegen_expr(context, curr_expr->child->next_child, cg_ctx,
+                            code_out);
 
         if (curr_expr->child->type == TYPE_VAR_ACCESS) {
             SymToAddr addr = map_sym_to_addr(cg_ctx, curr_expr->child);
@@ -419,49 +542,44 @@ void target_codegen_expr(ParsingContext *context,
             }
 
         } else {
-            target_codegen_expr(context, ctx_next_child, curr_expr->child,
-                                cg_ctx, fptr_code);
+            target_codegen_expr(context, curr_expr->child, cg_ctx, code_out);
             code_gen_store(cg_ctx,
                            curr_expr->child->next_child->result_reg_desc,
                            curr_expr->child->result_reg_desc);
 
-            // De-allocate RHS and LHS result register.
-            reg_dealloc(cg_ctx, curr_expr->child->next_child->result_reg_desc);
+            // De-allocate LHS result register.
             reg_dealloc(cg_ctx, curr_expr->child->result_reg_desc);
         }
+
+        // The value of a re-assignment is the value assigned, so the RHS
+        // register is released along with the result of the statement.
+        curr_expr->result_reg_desc =
+            curr_expr->child->next_child->result_reg_desc;
         break;
 
     case TYPE_IF_CONDITION:;
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; IF Block\n");
-        target_codegen_expr(context, ctx_next_child, curr_expr->child, cg_ctx,
-                            fptr_code);
+        if (cg_ctx->codegen_verbose)
+            out_buf_str(code_out, ";#; IF Block\n");
+        target_codegen_expr(context, curr_expr->child, cg_ctx, code_out);
 
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; If Condition\n");
+        if (cg_ctx->codegen_verbose)
+            out_buf_str(code_out, ";#; If Condition\n");
 
-        char *else_label = gen_label();
-        char *after_else_label = gen_label();
+        char *else_label = gen_label(cg_ctx);
+        char *after_else_label = gen_label(cg_ctx);
         code_gen_branch_if_zero(cg_ctx, curr_expr->child->result_reg_desc,
                                 else_label);
         reg_dealloc(cg_ctx, curr_expr->child->result_reg_desc);
 
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; If Then Body\n");
-
-        ParsingContext *ctx = context;
-        ParsingContext *ctx_child = *ctx_next_child;
-        if (*ctx_next_child != NULL) {
-            ctx = *ctx_next_child;
-            ctx_child = (*ctx_next_child)->child;
-            *ctx_next_child = (*ctx_next_child)->next_child;
-        }
+        if (cg_ctx->codegen_verbose)
+            out_buf_str(code_out, ";#; If Then Body\n");
 
         // The if body comes here.
         AstNode *last_expr = NULL;
-        AstNode *if_expr = curr_expr->child->next_child->child;
+        AstNode *if_body = curr_expr->child->next_child;
+        AstNode *if_expr = if_body->child;
         while (if_expr != NULL) {
-            target_codegen_expr(ctx, &ctx_child, if_expr, cg_ctx, fptr_code);
+            target_codegen_expr(if_body->scope, if_expr, cg_ctx, code_out);
             if (last_expr != NULL)
                 reg_dealloc(cg_ctx, last_expr->result_reg_desc);
             last_expr = if_expr;
@@ -474,27 +592,19 @@ void target_codegen_expr(ParsingContext *context,
         reg_dealloc(cg_ctx, last_expr->result_reg_desc);
         code_gen_branch(cg_ctx, after_else_label);
 
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; Else Body\n");
+        if (cg_ctx->codegen_verbose)
+            out_buf_str(code_out, ";#; Else Body\n");
 
-        fprintf(fptr_code, "%s:\n", else_label);
+        emit_label(code_out, "", else_label);
 
         // Else body
         last_expr = NULL;
-        AstNode *else_expr = curr_expr->child->next_child->next_child;
-        if (else_expr != NULL) {
-            ctx = context;
-            ctx_child = *ctx_next_child;
-            if (*ctx_next_child != NULL) {
-                ctx = *ctx_next_child;
-                ctx_child = (*ctx_next_child)->child;
-                *ctx_next_child = (*ctx_next_child)->next_child;
-            }
-
-            else_expr = else_expr->child;
+        AstNode *else_body = if_body->next_child;
+        if (else_body != NULL) {
+            AstNode *else_expr = else_body->child;
             while (else_expr != NULL) {
-                target_codegen_expr(ctx, &ctx_child, else_expr, cg_ctx,
-                                    fptr_code);
+                target_codegen_expr(else_body->scope, else_expr, cg_ctx,
+                                    code_out);
                 if (last_expr != NULL)
                     reg_dealloc(cg_ctx, last_expr->result_reg_desc);
                 last_expr = else_expr;
@@ -510,23 +620,21 @@ void target_codegen_expr(ParsingContext *context,
             code_gen_zero_out_reg(cg_ctx, curr_expr->result_reg_desc);
         }
 
-        fprintf(fptr_code, "%s:\n", after_else_label);
+        emit_label(code_out, "", after_else_label);
         break;
 
     case TYPE_DEREFERENCE:
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; Dereference\n");
-        target_codegen_expr(context, ctx_next_child, curr_expr->child, cg_ctx,
-                            fptr_code);
+        if (cg_ctx->codegen_verbose)
+            out_buf_str(code_out, ";#; Dereference\n");
+        target_codegen_expr(context, curr_expr->child, cg_ctx, code_out);
         curr_expr->result_reg_desc = curr_expr->child->result_reg_desc;
         break;
 
     case TYPE_ADDROF:
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; AddressOf\n");
+        if (cg_ctx->codegen_verbose)
+            out_buf_str(code_out, ";#; AddressOf\n");
         if (curr_expr->child->type == TYPE_ARR_INDEX) {
-            target_codegen_expr(context, ctx_next_child, curr_expr->child,
-                                cg_ctx, fptr_code);
+            target_codegen_expr(context, curr_expr->child, cg_ctx, code_out);
             curr_expr->result_reg_desc = curr_expr->child->result_reg_desc;
         } else {
             SymToAddr addr = map_sym_to_addr(cg_ctx, curr_expr->child);
@@ -544,31 +652,12 @@ void target_codegen_expr(ParsingContext *context,
         break;
 
     case TYPE_ARR_INDEX:
-        if (codegen_verbose)
-            fprintf(fptr_code, ";#; Arr Index : %ld\n", curr_expr->ast_val.val);
+        if (cg_ctx->codegen_verbose)
+            emit_comment_int(code_out, ";#; Arr Index : ",
+                             curr_expr->ast_val.val);
 
-        // Get type information for the variable.
-        stat = -1;
-        AstNode *arr_type = parser_get_var(context, curr_expr->child, &stat);
-        if (stat == 0)
-            print_error(ERR_COMMON,
-                        "Unable to get information for array : `%s`",
-                        curr_expr->child->ast_val.node_symbol);
-
-        // Get the size of the base type.
-        stat = -1;
-        AstNode *base_type =
-            parser_get_type(context, arr_type->child->next_child, &stat);
-        if (stat == 0)
-            print_error(ERR_COMMON,
-                        "Unable to get base type information for array : `%s`",
-                        curr_expr->child->ast_val.node_symbol);
-
-        // Base type size.
-        long base_type_size = base_type->child->ast_val.val;
-        free_node(base_type);
-
-        long arr_offset = curr_expr->ast_val.val * base_type_size;
+        // The type checker has sized the elements of the array.
+        long arr_offset = curr_expr->ast_val.val * curr_expr->val_size;
 
         SymToAddr addr = map_sym_to_addr(cg_ctx, curr_expr->child);
         switch (addr.type) {
@@ -595,21 +684,16 @@ void target_codegen_expr(ParsingContext *context,
     }
 }
 
-#define LABEL_BUFFER_SIZE 1024
-
 void target_codegen_func(CGContext *cg_ctx, ParsingContext *context,
-                         ParsingContext **ctx_next_child, char *func_name,
-                         AstNode *func) {
-
-    cg_ctx = create_cgcontext_child(cg_ctx);
+                         char *func_name, AstNode *func) {
 
     /**
      * Storing the offset for parameters passed to the function
      * so that we know, which register to use for passing them
      * to the function.
      *
-     * We also set the locals environment to have the name of the
-     * parameter bound to an integer with the stack offset.
+     * We also set the frame offset in the symbol record of every
+     * parameter, which every access to it is bound to.
      * Example:
      * jmp afterfoo
      * foo:
@@ -628,12 +712,12 @@ void target_codegen_func(CGContext *cg_ctx, ParsingContext *context,
     long param_cnt = 1;
     while (func_param_list != NULL) {
         param_cnt++;
-        if (!set_env(&(cg_ctx->local_env), func_param_list->child,
-                     create_node_int(param_cnt * 8)))
+        if (func_param_list->child->sym == NULL)
             print_error(ERR_COMMON,
                         "Unable to set locals environment in code gen context "
                         "for : `%s`",
                         func_param_list->child->ast_val.node_symbol);
+        func_param_list->child->sym->frame_offset = param_cnt * 8;
         func_param_list = func_param_list->next_child;
     }
 
@@ -643,23 +727,15 @@ void target_codegen_func(CGContext *cg_ctx, ParsingContext *context,
              func_name);
     code_gen_branch(cg_ctx, after_label_buffer);
 
-    fprintf(cg_ctx->fptr_code, "%s:\n", func_name);
+    emit_label(cg_ctx->code_out, "", func_name);
 
     // Function header.
     code_gen_func_header(cg_ctx);
 
-    ParsingContext *ctx = context;
-    ParsingContext *ctx_child = *ctx_next_child;
-    if (*ctx_next_child != NULL) {
-        ctx = *ctx_next_child;
-        ctx_child = (*ctx_next_child)->child;
-        *ctx_next_child = (*ctx_next_child)->next_child;
-    }
     AstNode *temp_expr = func->child->next_child->next_child->child;
     AstNode *last_expr = NULL;
     while (temp_expr != NULL) {
-        target_codegen_expr(ctx, &ctx_child, temp_expr, cg_ctx,
-                            cg_ctx->fptr_code);
+        target_codegen_expr(context, temp_expr, cg_ctx, cg_ctx->code_out);
         reg_dealloc(cg_ctx, temp_expr->result_reg_desc);
         last_expr = temp_expr;
         temp_expr = temp_expr->next_child;
@@ -671,42 +747,74 @@ void target_codegen_func(CGContext *cg_ctx, ParsingContext *context,
     code_gen_func_footer(cg_ctx);
 
     // Jump after function protection
-    fprintf(cg_ctx->fptr_code, "after%s:\n", func_name);
+    emit_label(cg_ctx->code_out, "after", func_name);
 
     free_cgcontext(cg_ctx);
 }
 
-void target_codegen_prog(ParsingContext *context, AstNode *program,
-                         CGContext *cg_ctx, FILE *fptr_code) {
+// Generates a function body, that missed the function cache, into a buffer
+// of its own, so that it can be stored before being written out.
+static void target_codegen_func_cached(CGContext *cg_ctx,
+                                       ParsingContext *context,
+                                       char *func_name, AstNode *func,
+                                       FuncCacheKey *cache_key) {
+    pass_stats.func_cache_misses += 1;
+    OutBuf *code_out = cg_ctx->code_out;
+    OutBuf *func_out = out_buf_create_mem();
+    cg_ctx->code_out = func_out;
+
+    // The buffer is released before an error is passed on.
+    char has_error = 0;
+    ErrTrap trap;
+    err_trap_push(&trap);
+    if (setjmp(trap.env) == 0)
+        target_codegen_func(cg_ctx, context, func_name, func);
+    else
+        has_error = 1;
+    err_trap_pop(&trap);
+    if (has_error) {
+        out_buf_destroy(func_out);
+        print_error(trap.err, "%s", trap.msg);
+    }
+
+    func_cache_store(cache_key, func_out->data, func_out->used);
+    out_buf_write(code_out, func_out->data, func_out->used);
+    out_buf_destroy(func_out);
+}
 
-    fprintf(fptr_code, ".section .data\n");
+// Reserves space for every global variable in the data section.
+static void target_codegen_data(ParsingContext *context, OutBuf *code_out) {
+    out_buf_str(code_out, ".section .data\n");
 
     IdentifierBind *temp_var_bind = context->vars->binding;
     AstNode *temp_var_type_id = NULL;
-    int status = -1;
     while (temp_var_bind != NULL) {
-        temp_var_type_id = node_alloc();
-        *temp_var_type_id = *temp_var_bind->id_val;
-        // temp_var_type_id->child = NULL;
-        // temp_var_type_id->next_child = NULL;
-        AstNode *var = parser_get_type(context, temp_var_type_id, &status);
-        if (!status)
+        // Variables are bound to their canonical types, which are sized.
+        temp_var_type_id = temp_var_bind->id_val;
+        long var_size = type_size(temp_var_type_id);
+        if (var_size < 0)
             print_error(ERR_COMMON,
                         "Unable to retrieve value from environment for : `%s`",
                         temp_var_type_id->ast_val.node_symbol);
 
-        if (strcmp(temp_var_type_id->ast_val.node_symbol, "ext function") != 0)
-            fprintf(fptr_code, "%s: .space %ld\n",
-                    temp_var_bind->identifier->ast_val.node_symbol,
-                    var->child->ast_val.val);
+        if (temp_var_type_id->ast_val.node_symbol !=
+            builtin_syms.ext_function) {
+            out_buf_str(code_out,
+                        temp_var_bind->identifier->ast_val.node_symbol);
+            out_buf_str(code_out, ": .space ");
+            out_buf_int(code_out, var_size);
+            out_buf_char(code_out, '\n');
+        }
 
         temp_var_bind = temp_var_bind->next_id_bind;
-        free_node(temp_var_type_id);
     }
+}
 
+void target_codegen_prog(ParsingContext *context, AstNode *program,
+                         CGContext *cg_ctx, OutBuf *code_out) {
+    target_codegen_data(context, code_out);
     code_gen_set_entry_point(cg_ctx);
 
-    ParsingContext *ctx_next_child = context->child;
     AstNode *curr_expr = program->child;
     AstNode *last_expr = NULL;
     while (curr_expr != NULL) {
@@ -714,8 +822,7 @@ void target_codegen_prog(ParsingContext *context, AstNode *program,
             curr_expr = curr_expr->next_child;
             continue;
         }
-        target_codegen_expr(context, &ctx_next_child, curr_expr, cg_ctx,
-                            fptr_code);
+        target_codegen_expr(context, curr_expr, cg_ctx, code_out);
         reg_dealloc(cg_ctx, curr_expr->result_reg_desc);
         last_expr = curr_expr;
         curr_expr = curr_expr->next_child;
@@ -727,33 +834,190 @@ void target_codegen_prog(ParsingContext *context, AstNode *program,
     code_gen_func_footer(cg_ctx);
 }
 
-void target_codegen(ParsingContext *context, AstNode *program,
-                    char *output_file_path, TargetFormat type,
-                    TargetAssemblyDialect dialect,
-                    TargetCallingConvention call_conv) {
+// Waits for the workers, and writes out the program into `file_out`, with
+// the bodies they generated spliced in. The first error in program order is
+// kept in `trap`, in which case nothing is written.
+static void target_codegen_splice(CGTaskState *task_state, OutBuf *code_out,
+                                  OutBuf *file_out, ErrTrap *trap,
+                                  char *has_error) {
+    task_pool_destroy(task_state->pool);
+
+    for (CGFuncTask *task = task_state->func_tasks;
+         task != NULL && !*has_error; task = task->next) {
+        if (task->has_error) {
+            *has_error = 1;
+            trap->err = task->err;
+            memcpy(trap->msg, task->err_msg, ERR_MSG_SIZE);
+        }
+    }
+
+    size_t offset = 0;
+    for (CGFuncTask *task = task_state->func_tasks; task != NULL;
+         task = task->next) {
+        if (!*has_error) {
+            out_buf_write(file_out, code_out->data + offset,
+                          task->out_offset - offset);
+            out_buf_write(file_out, task->code, task->code_len);
+            pass_stats_merge(&task->stats);
+            offset = task->out_offset;
+        }
+        free(task->code);
+    }
+    if (!*has_error)
+        out_buf_write(file_out, code_out->data + offset,
+                      code_out->used - offset);
+}
+
+// Generates code for the program into `file_out`. Errors are kept in `trap`,
+// and passed on by the caller, once it has released its output. Returns 1
+// if an error was reported.
+static char target_codegen_out(ParsingContext *context, AstNode *program,
+                               OutBuf *file_out, TargetFormat type,
+                               TargetAssemblyDialect dialect,
+                               TargetCallingConvention call_conv, int jobs,
+                               const char *func_cache_dir, ErrTrap *trap) {
     if (context == NULL || program == NULL)
         print_error(ERR_COMMON,
                     "NULL program node passed for code generation to "
                     "`target_codegen()`");
 
-    FILE *fptr_code = NULL;
+    // With workers, function bodies are generated on the side, so the rest
+    // of the program is kept in memory, until they can be spliced in.
+    CGTaskState task_state = {0};
+    OutBuf *code_out = file_out;
+    if (jobs > 1) {
+        task_state.pool = task_pool_create(jobs);
+        code_out = out_buf_create_mem();
+    }
+
+    CGContext *cg_ctx = create_cgcontext(type, call_conv, dialect, code_out);
+    cg_ctx->task_state = &task_state;
+
+    // The cache is created on first use, if it can't be, every function
+    // misses, and storing it fails quietly.
+    cg_ctx->func_cache_dir = func_cache_dir;
+    if (func_cache_dir != NULL)
+        mkdir(func_cache_dir, 0777);
+
+    // Workers may still be using the program when an error is reported, so
+    // they are waited for before it is passed on.
+    char has_error = 0;
+    err_trap_push(trap);
+    if (setjmp(trap->env) == 0)
+        target_codegen_prog(context, program, cg_ctx, code_out);
+    else
+        has_error = 1;
+    err_trap_pop(trap);
+
+    if (task_state.pool != NULL) {
+        target_codegen_splice(&task_state, code_out, file_out, trap,
+                              &has_error);
+        out_buf_destroy(code_out);
+    }
+
+    free_cgcontext(cg_ctx);
+    return has_error;
+}
+
+void target_codegen(ParsingContext *context, AstNode *program,
+                    char *output_file_path, TargetFormat type,
+                    TargetAssemblyDialect dialect,
+                    TargetCallingConvention call_conv, int jobs,
+                    const char *func_cache_dir) {
+    int code_fd = -1;
     if (output_file_path == NULL) {
-        fptr_code = fopen("code_gen.s", "w");
-        if (fptr_code == NULL)
+        code_fd = open("code_gen.s", O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (code_fd < 0)
             print_error(ERR_FILE_OPEN, "Unable to open default file for code "
                                        "generation : `code_gen.s`");
     } else {
-        fptr_code = fopen(output_file_path, "w");
-        if (fptr_code == NULL)
+        code_fd = open(output_file_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (code_fd < 0)
             print_error(ERR_FILE_OPEN,
                         "Unable to open file for code generation : `%s`",
                         output_file_path);
     }
 
-    CGContext *cg_ctx = create_cgcontext(type, call_conv, dialect, fptr_code);
+    // Generated code is collected in a large buffer, and written out with a
+    // handful of `write()` calls.
+    OutBuf *file_out = out_buf_create_fd(code_fd);
+    ErrTrap trap;
+    char has_error =
+        target_codegen_out(context, program, file_out, type, dialect,
+                           call_conv, jobs, func_cache_dir, &trap);
+    out_buf_destroy(file_out);
+    close(code_fd);
+    if (has_error)
+        print_error(trap.err, "%s", trap.msg);
+}
+
+CGStream *target_codegen_stream_create(char *output_file_path,
+                                       TargetFormat type,
+                                       TargetAssemblyDialect dialect,
+                                       TargetCallingConvention call_conv,
+                                       const char *func_cache_dir) {
+    if (output_file_path == NULL)
+        output_file_path = "code_gen.s";
+    int code_fd = open(output_file_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (code_fd < 0)
+        print_error(ERR_FILE_OPEN,
+                    "Unable to open file for code generation : `%s`",
+                    output_file_path);
+
+    CGStream *stream = (CGStream *)arena_calloc(sizeof(CGStream));
+    stream->code_fd = code_fd;
+    stream->code_out = out_buf_create_fd(code_fd);
+    stream->last_reg = -1;
+    stream->cg_ctx =
+        create_cgcontext(type, call_conv, dialect, stream->code_out);
+    stream->cg_ctx->task_state = &stream->task_state;
+    stream->cg_ctx->func_cache_dir = func_cache_dir;
+    if (func_cache_dir != NULL)
+        mkdir(func_cache_dir, 0777);
+
+    code_gen_set_entry_point(stream->cg_ctx);
+    return stream;
+}
 
-    target_codegen_prog(context, program, cg_ctx, fptr_code);
+void target_codegen_stream_expr(CGStream *stream, ParsingContext *context,
+                                AstNode *expr) {
+    target_codegen_expr(context, expr, stream->cg_ctx, stream->code_out);
+    reg_dealloc(stream->cg_ctx, expr->result_reg_desc);
+    stream->last_reg = expr->result_reg_desc;
+}
 
-    free_cgcontext(cg_ctx);
-    fclose(fptr_code);
+void target_codegen_stream_finish(CGStream *stream, ParsingContext *context) {
+    if (stream->last_reg != -1)
+        code_gen_set_func_ret_val(stream->cg_ctx, stream->last_reg);
+    code_gen_func_footer(stream->cg_ctx);
+
+    // Every global has been declared by now, so the data section goes last.
+    target_codegen_data(context, stream->code_out);
+}
+
+void target_codegen_stream_destroy(CGStream *stream, char has_error) {
+    free_cgcontext(stream->cg_ctx);
+    out_buf_destroy(stream->code_out);
+
+    // Only regular files are emptied, devices, and pipes are left alone.
+    struct stat out_stat;
+    if (has_error && fstat(stream->code_fd, &out_stat) == 0 &&
+        S_ISREG(out_stat.st_mode) && ftruncate(stream->code_fd, 0) < 0)
+        print_warning(ERR_FILE_WRITE, "Unable to discard partial output");
+    close(stream->code_fd);
+}
+
+char *target_codegen_mem(ParsingContext *context, AstNode *program,
+                         size_t *code_len, TargetFormat type,
+                         TargetAssemblyDialect dialect,
+                         TargetCallingConvention call_conv, int jobs,
+                         const char *func_cache_dir) {
+    OutBuf *code_out = out_buf_create_mem();
+    ErrTrap trap;
+    if (target_codegen_out(context, program, code_out, type, dialect,
+                           call_conv, jobs, func_cache_dir, &trap)) {
+        out_buf_destroy(code_out);
+        print_error(trap.err, "%s", trap.msg);
+    }
+    return out_buf_release(code_out, code_len);
 }
@@ -1,187 +1,234 @@
 #include "../inc/env_funcs.h"
+#include "../inc/arena.h"
 #include "../inc/ast_funcs.h"
+#include "../inc/intern.h"
 #include "../inc/parser.h"
+#include "../inc/pass_stats.h"
+#include "../inc/type_table.h"
 #include "../inc/utils.h"
+#include <stdint.h>
 
 Env *create_env(Env *parent_env) {
-    Env *new_env = calloc(1, sizeof(Env));
-    CHECK_NULL(new_env, "Unable to allocate memory for new environment", NULL);
+    Env *new_env = (Env *)arena_calloc(sizeof(Env));
     new_env->parent_env = parent_env;
     new_env->binding = NULL;
+    new_env->last_binding = NULL;
+    // Slots are allocated with the first binding, since most environments
+    // stay empty.
+    new_env->slots = NULL;
+    new_env->slots_size = 0;
+    new_env->bind_count = 0;
     return new_env;
 }
 
-int set_env(Env **env_to_set, AstNode *identifier_node, AstNode *id_val) {
-    if (env_to_set == NULL || identifier_node == NULL || id_val == NULL)
-        return 0;
+static unsigned long env_hash_sym(char *sym) {
+    // Symbols are interned, so the pointer identifies the symbol.
+    unsigned long hash = (unsigned long)(uintptr_t)sym;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdUL;
+    hash ^= hash >> 33;
+    return hash;
+}
 
-    IdentifierBind *temp = (*env_to_set)->binding;
+static IdentifierBind **env_find_slot(Env *env, char *sym) {
+    unsigned long idx = env_hash_sym(sym) & (env->slots_size - 1);
+    while (env->slots[idx] != NULL &&
+           env->slots[idx]->identifier->ast_val.node_symbol != sym)
+        idx = (idx + 1) & (env->slots_size - 1);
+    return &env->slots[idx];
+}
 
-    IdentifierBind *binds = calloc(1, sizeof(IdentifierBind));
-    CHECK_NULL(binds, "Unable to allocate memory for new binding", NULL);
-    binds->identifier = identifier_node;
-    binds->id_val = id_val;
+static void env_grow(Env *env) {
+    unsigned long new_size =
+        env->slots_size == 0 ? ENV_INIT_SLOTS : env->slots_size * 2;
+    env->slots =
+        (IdentifierBind **)arena_calloc(new_size * sizeof(IdentifierBind *));
+    env->slots_size = new_size;
 
-    if (temp == NULL) {
-        (*env_to_set)->binding = binds;
-        return 1;
+    // Re-insert the bindings in insertion order, into the new table.
+    IdentifierBind *curr_bind = env->binding;
+    while (curr_bind != NULL) {
+        *env_find_slot(env, curr_bind->identifier->ast_val.node_symbol) =
+            curr_bind;
+        curr_bind = curr_bind->next_id_bind;
     }
+}
 
-    while (temp->next_id_bind != NULL) {
-        if (node_cmp(temp->identifier, identifier_node)) {
-            // Should binding over-write be allowed??
-            // print_error(ERR_COMMON,
-            //             "Redefining Binding in environment for : `%s`",
-            //             identifier_node->ast_val.node_symbol);
-            temp->id_val = id_val;
-            return 1;
-        }
-        temp = temp->next_id_bind;
+static IdentifierBind *env_lookup(Env *env, char *sym) {
+    pass_stats.env_lookups += 1;
+    if (env->bind_count == 0 || sym == NULL)
+        return NULL;
+
+    IdentifierBind **slot = env_find_slot(env, sym);
+    // Slots walked, from the slot the symbol hashes to.
+    unsigned long home = env_hash_sym(sym) & (env->slots_size - 1);
+    pass_stats.env_probes +=
+        (((unsigned long)(slot - env->slots) - home) & (env->slots_size - 1)) +
+        1;
+    return *slot;
+}
+
+int set_env(Env **env_to_set, AstNode *identifier_node, AstNode *id_val) {
+    if (env_to_set == NULL || identifier_node == NULL || id_val == NULL ||
+        identifier_node->ast_val.node_symbol == NULL)
+        return 0;
+
+    Env *env = *env_to_set;
+    IdentifierBind *temp =
+        env_lookup(env, identifier_node->ast_val.node_symbol);
+    if (temp != NULL) {
+        // Should binding over-write be allowed??
+        // print_error(ERR_COMMON,
+        //             "Redefining Binding in environment for : `%s`",
+        //             identifier_node->ast_val.node_symbol);
+        temp->id_val = id_val;
+        return 1;
     }
-    temp->next_id_bind = binds;
+
+    // Keep the load factor under a half, so that probe sequences stay short.
+    if ((env->bind_count + 1) * 2 > env->slots_size)
+        env_grow(env);
+
+    IdentifierBind *binds =
+        (IdentifierBind *)arena_calloc(sizeof(IdentifierBind));
+    binds->identifier = identifier_node;
+    binds->id_val = id_val;
+    *env_find_slot(env, identifier_node->ast_val.node_symbol) = binds;
+
+    if (env->last_binding == NULL)
+        env->binding = binds;
+    else
+        env->last_binding->next_id_bind = binds;
+    env->last_binding = binds;
+    env->bind_count += 1;
     return 1;
 }
 
-AstNode *get_env(Env *env_to_get, AstNode *identifier, int *stat) {
-    IdentifierBind *curr_bind = env_to_get->binding;
-    AstNode *val = node_alloc();
-    while (curr_bind != NULL) {
-        if (node_cmp(curr_bind->identifier, identifier)) {
-            *stat = 1;
-            copy_node(val, curr_bind->id_val);
-            return val;
-        }
-        curr_bind = curr_bind->next_id_bind;
+const AstNode *get_env_ref(Env *env_to_get, const AstNode *identifier,
+                           int *stat) {
+    IdentifierBind *curr_bind =
+        env_lookup(env_to_get, identifier->ast_val.node_symbol);
+    if (curr_bind != NULL && node_cmp(curr_bind->identifier, identifier)) {
+        *stat = 1;
+        return curr_bind->id_val;
     }
     *stat = 0;
-    return val;
+    return NULL;
 }
 
-AstNode *get_env_from_sym(Env *env_to_get, char *identifier, int *stat) {
-    IdentifierBind *curr_bind = env_to_get->binding;
-    AstNode *val = node_alloc();
-    while (curr_bind != NULL) {
-        if (strcmp(curr_bind->identifier->ast_val.node_symbol, identifier) ==
-            0) {
-            *stat = 1;
-            copy_node(val, curr_bind->id_val);
-            return val;
-        }
-        curr_bind = curr_bind->next_id_bind;
+const AstNode *get_env_ref_from_sym(Env *env_to_get, const char *identifier,
+                                    int *stat) {
+    IdentifierBind *curr_bind = env_lookup(env_to_get, (char *)identifier);
+    if (curr_bind != NULL) {
+        *stat = 1;
+        return curr_bind->id_val;
     }
     *stat = 0;
-    return val;
+    return NULL;
 }
 
-AstNode *get_env_from_val(Env *env_to_get, AstNode *val, int *stat) {
+const AstNode *get_env_ref_from_val(Env *env_to_get, const AstNode *val,
+                                    int *stat) {
     IdentifierBind *curr_bind = env_to_get->binding;
-    AstNode *id = node_alloc();
     while (curr_bind != NULL) {
         if (node_cmp(curr_bind->id_val, val)) {
             *stat = 1;
-            copy_node(id, curr_bind->identifier);
-            return id;
+            return curr_bind->identifier;
         }
         curr_bind = curr_bind->next_id_bind;
     }
     *stat = 0;
-    return id;
+    return NULL;
+}
+
+AstNode *get_env(Env *env_to_get, AstNode *identifier, int *stat) {
+    AstNode *val = node_alloc();
+    copy_node(val, get_env_ref(env_to_get, identifier, stat));
+    return val;
 }
 
-AstNode *parser_get_type(ParsingContext *context, AstNode *identifier,
-                         int *stat) {
-    ParsingContext *temp_ctx = context;
-    int status = -1;
+// Type node shared by all the pointer sized types, i.e. pointers and
+// functions, which don't have a binding of their own.
+static AstNode ptr_type_size = {.type = TYPE_INT, .ast_val = {.val = 8}};
+static const AstNode ptr_type = {.child = &ptr_type_size};
 
+const AstNode *parser_get_type_ref(ParsingContext *context,
+                                   const AstNode *identifier, int *stat) {
     if (identifier->pointer_level > 0 ||
-        strcmp(identifier->ast_val.node_symbol, "function") == 0 ||
-        strcmp(identifier->ast_val.node_symbol, "ext function") == 0) {
-        AstNode *res = node_alloc();
-        res->child = create_node_int(8);
+        identifier->ast_val.node_symbol == builtin_syms.function ||
+        identifier->ast_val.node_symbol == builtin_syms.ext_function) {
         *stat = 1;
-        return res;
+        return &ptr_type;
     }
 
-    if (strcmp(identifier->ast_val.node_symbol, "array") == 0) {
-        AstNode *arr_type =
-            parser_get_type(context, identifier->child->next_child, &status);
-        if (status == 0)
-            print_error(ERR_TYPE, "Unable to find base type for array");
-
-        // Return the total size of the array.
-        AstNode *res = node_alloc();
-        res->child = create_node_int(arr_type->child->ast_val.val *
-                                     identifier->child->ast_val.val);
-        return res;
+    if (identifier->ast_val.node_symbol == builtin_syms.array) {
+        *stat = 0;
+        return NULL;
     }
 
-    while (temp_ctx != NULL) {
-        AstNode *res = get_env(temp_ctx->env_type, identifier, &status);
-        if (status) {
-            *stat = 1;
-            return res;
-        }
-        temp_ctx = temp_ctx->parent_ctx;
-    }
-    AstNode *res = create_node_none();
-    *stat = 0;
-    return res;
+    // Types are only bound in the root context.
+    return get_env_ref(context->global_ctx->env_type, identifier, stat);
 }
 
-AstNode *parser_get_var(ParsingContext *context, AstNode *identifier,
-                        int *stat) {
-    ParsingContext *temp_ctx = context;
-    int status = -1;
-
-    while (temp_ctx != NULL) {
-        AstNode *res = get_env(temp_ctx->vars, identifier, &status);
-        if (status) {
-            *stat = 1;
-            return res;
-        }
-        temp_ctx = temp_ctx->parent_ctx;
-    }
-    AstNode *res = create_node_none();
-    *stat = 0;
-    return res;
+void parser_declare_var(ParsingContext *context, AstNode *identifier,
+                        AstNode *type) {
+    // The binding lives as long as the context, which may outlive the
+    // expression declaring it, when expressions are released one by one.
+    Arena *expr_arena = arena_get_current();
+    arena_set_current(context->arena);
+
+    // Later passes compare, and size the type of the variable in constant
+    // time, through its canonical type.
+    type = type_canon(context, type);
+    Symbol *sym = (Symbol *)arena_calloc(sizeof(Symbol));
+    sym->name = identifier->ast_val.node_symbol;
+    sym->type = type;
+    sym->depth = context->depth;
+    sym->is_local = context->is_func_scope;
+    identifier->sym = sym;
+
+    AstNode *bound_id = node_alloc();
+    copy_node(bound_id, identifier);
+    if (!set_env(&context->vars, bound_id, type))
+        print_error(ERR_COMMON,
+                    "Unable to set environment binding for variable : `%s`",
+                    identifier->ast_val.node_symbol);
+    arena_set_current(expr_arena);
 }
 
-AstNode *parser_get_func(ParsingContext *context, AstNode *identifier,
-                         int *stat) {
-    ParsingContext *temp_ctx = context;
-    int status = -1;
-    while (temp_ctx != NULL) {
-        AstNode *res = get_env(temp_ctx->funcs, identifier, &status);
-        if (status) {
-            *stat = 1;
-            return res;
-        }
-        temp_ctx = temp_ctx->parent_ctx;
+Symbol *parser_resolve_var(ParsingContext *context, const AstNode *identifier) {
+    // Contexts without variables, e.g. the bodies of nested ifs, are
+    // skipped over.
+    for (ParsingContext *temp_ctx = context; temp_ctx != NULL;
+         temp_ctx = temp_ctx->outer_vars_ctx) {
+        IdentifierBind *curr_bind =
+            env_lookup(temp_ctx->vars, identifier->ast_val.node_symbol);
+        if (curr_bind != NULL && node_cmp(curr_bind->identifier, identifier))
+            return curr_bind->identifier->sym;
     }
-    AstNode *res = create_node_none();
-    *stat = 0;
-    return res;
+    return NULL;
 }
 
 void print_env(Env *env, int indent) {
     IdentifierBind *curr_bind = env->binding;
     int temp_indent = indent;
+    char node_buf[NODE_BUF_SIZE];
     while (curr_bind != NULL) {
         temp_indent = indent;
         while (temp_indent != 0) {
             putchar(' ');
             temp_indent--;
         }
-        printf("%s -> ", get_node_str(curr_bind->identifier));
-        printf("%s", get_node_str(curr_bind->id_val));
+        printf("%s -> ", get_node_str(curr_bind->identifier, node_buf));
+        printf("%s", get_node_str(curr_bind->id_val, node_buf));
         AstNode *temp_val = curr_bind->id_val->child;
         if (temp_val == NULL)
             putchar('\n');
         while (temp_val != NULL) {
             if (temp_val == curr_bind->id_val->child)
-                printf(" ==> %s", get_node_str(temp_val));
+                printf(" ==> %s", get_node_str(temp_val, node_buf));
             else
-                printf(" -> %s", get_node_str(temp_val));
+                printf(" -> %s", get_node_str(temp_val, node_buf));
             temp_val = temp_val->next_child;
             if (temp_val == NULL)
                 putchar('\n');
@@ -0,0 +1,272 @@
+#include "../inc/file_cache.h"
+#include "../inc/utils.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define FILE_CACHE_PATH_SIZE 4096
+#define FILE_CACHE_SUFFIX ".sc"
+#define FILE_CACHE_CHUNK_SIZE (64 * 1024)
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+// Part of the header, that has to match for a hit.
+#define FILE_CACHE_KEY_SIZE offsetof(FileCacheHeader, code_len)
+
+// Entry found while scanning the cache for eviction.
+typedef struct FileCacheEntry {
+    char name[64];
+    struct timespec used_at;
+    size_t size;
+} FileCacheEntry;
+
+static uint64_t fnv_hash(uint64_t hash, const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ (unsigned char)data[i]) * FNV_PRIME;
+    return hash;
+}
+
+void file_cache_key(FileCacheKey *key, const char *src, size_t src_len,
+                    TargetFormat type, TargetAssemblyDialect dialect,
+                    TargetCallingConvention call_conv) {
+    memset(&key->header, 0, sizeof(key->header));
+    memcpy(key->header.magic, FILE_CACHE_MAGIC, FILE_CACHE_MAGIC_LEN);
+    strncpy(key->header.version, VERSION_STRING,
+            sizeof(key->header.version) - 1);
+    strncpy(key->header.build_id, build_id(), sizeof(key->header.build_id) - 1);
+    key->header.out_fmt = type;
+    key->header.call_conv = call_conv;
+    key->header.dialect = dialect;
+    key->header.src_len = src_len;
+    key->src = src;
+
+    key->hash = fnv_hash(FNV_OFFSET_BASIS, (const char *)&key->header,
+                         FILE_CACHE_KEY_SIZE);
+    key->hash = fnv_hash(key->hash, src, src_len);
+}
+
+static void file_cache_path(const char *dir, const FileCacheKey *key,
+                            char *path) {
+    snprintf(path, FILE_CACHE_PATH_SIZE, "%s/%016llx" FILE_CACHE_SUFFIX, dir,
+             (unsigned long long)key->hash);
+}
+
+// Reads exactly `len` bytes, returns 0 on a short read.
+static char read_exact(int fd, char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t ret = read(fd, buf, len);
+        if (ret <= 0)
+            return 0;
+        buf += ret;
+        len -= ret;
+    }
+    return 1;
+}
+
+static char write_exact(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t ret = write(fd, buf, len);
+        if (ret <= 0)
+            return 0;
+        buf += ret;
+        len -= ret;
+    }
+    return 1;
+}
+
+// Checks that the entry open at `fd` holds `key`, leaving `fd` at the start
+// of the code. The whole source is compared, so a hit never depends on the
+// hash alone.
+static char file_cache_match(int fd, const FileCacheKey *key, char *buf,
+                             FileCacheHeader *header) {
+    struct stat entry_stat;
+    if (!read_exact(fd, (char *)header, sizeof(*header)) ||
+        memcmp(header, &key->header, FILE_CACHE_KEY_SIZE) != 0 ||
+        fstat(fd, &entry_stat) != 0 ||
+        (uint64_t)entry_stat.st_size !=
+            sizeof(*header) + header->src_len + header->code_len)
+        return 0;
+
+    for (size_t offset = 0; offset < header->src_len;) {
+        size_t len = header->src_len - offset;
+        len = len < FILE_CACHE_CHUNK_SIZE ? len : FILE_CACHE_CHUNK_SIZE;
+        if (!read_exact(fd, buf, len) ||
+            memcmp(buf, key->src + offset, len) != 0)
+            return 0;
+        offset += len;
+    }
+    return 1;
+}
+
+char file_cache_load(const char *dir, const FileCacheKey *key,
+                     const char *out_path) {
+    char path[FILE_CACHE_PATH_SIZE];
+    file_cache_path(dir, key, path);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+
+    char *buf = (char *)malloc(FILE_CACHE_CHUNK_SIZE);
+    CHECK_NULL(buf, "Unable to allocate memory for %s", "the compile cache");
+    FileCacheHeader header;
+    if (!file_cache_match(fd, key, buf, &header)) {
+        free(buf);
+        close(fd);
+        return 0;
+    }
+
+    // Entries are evicted by the time they were last used at.
+    futimens(fd, NULL);
+
+    int code_fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (code_fd < 0)
+        print_error(ERR_FILE_OPEN,
+                    "Unable to open file for code generation : `%s`",
+                    out_path);
+    for (size_t offset = 0; offset < header.code_len;) {
+        size_t len = header.code_len - offset;
+        len = len < FILE_CACHE_CHUNK_SIZE ? len : FILE_CACHE_CHUNK_SIZE;
+        if (!read_exact(fd, buf, len))
+            print_error(ERR_FILE_READ, "Unable to read cached code : `%s`",
+                        path);
+        if (!write_exact(code_fd, buf, len))
+            print_error(ERR_FILE_WRITE, "Unable to write : `%s`", out_path);
+        offset += len;
+    }
+
+    close(code_fd);
+    free(buf);
+    close(fd);
+    return 1;
+}
+
+static int compare_entries(const void *a, const void *b) {
+    const FileCacheEntry *entry_a = (const FileCacheEntry *)a;
+    const FileCacheEntry *entry_b = (const FileCacheEntry *)b;
+    if (entry_a->used_at.tv_sec != entry_b->used_at.tv_sec)
+        return entry_a->used_at.tv_sec < entry_b->used_at.tv_sec ? -1 : 1;
+    if (entry_a->used_at.tv_nsec != entry_b->used_at.tv_nsec)
+        return entry_a->used_at.tv_nsec < entry_b->used_at.tv_nsec ? -1 : 1;
+    return strcmp(entry_a->name, entry_b->name);
+}
+
+// Lists the entries in the cache, returns NULL if it can't be read.
+static FileCacheEntry *file_cache_scan(const char *dir, size_t *entry_count,
+                                       size_t *total_size) {
+    *entry_count = 0;
+    *total_size = 0;
+    DIR *dir_ptr = opendir(dir);
+    if (dir_ptr == NULL)
+        return NULL;
+
+    size_t entry_cap = 64;
+    FileCacheEntry *entries =
+        (FileCacheEntry *)malloc(entry_cap * sizeof(FileCacheEntry));
+    CHECK_NULL(entries, "Unable to allocate memory for %s",
+               "the compile cache");
+
+    struct dirent *dir_entry;
+    while ((dir_entry = readdir(dir_ptr)) != NULL) {
+        size_t name_len = strlen(dir_entry->d_name);
+        size_t suffix_len = strlen(FILE_CACHE_SUFFIX);
+        if (name_len <= suffix_len || name_len >= sizeof(entries->name) ||
+            strcmp(dir_entry->d_name + name_len - suffix_len,
+                   FILE_CACHE_SUFFIX) != 0)
+            continue;
+
+        struct stat entry_stat;
+        if (fstatat(dirfd(dir_ptr), dir_entry->d_name, &entry_stat, 0) != 0)
+            continue;
+
+        if (*entry_count == entry_cap) {
+            entry_cap *= 2;
+            entries = (FileCacheEntry *)realloc(
+                entries, entry_cap * sizeof(FileCacheEntry));
+            CHECK_NULL(entries, "Unable to allocate memory for %s",
+                       "the compile cache");
+        }
+        FileCacheEntry *entry = &entries[(*entry_count)++];
+        memcpy(entry->name, dir_entry->d_name, name_len + 1);
+        entry->used_at = entry_stat.st_mtim;
+        entry->size = entry_stat.st_size;
+        *total_size += entry->size;
+    }
+
+    closedir(dir_ptr);
+    return entries;
+}
+
+// Removes the least recently used entries, until the cache fits in
+// `max_size`.
+static void file_cache_evict(const char *dir, size_t max_size,
+                             FileCacheStats *stats) {
+    size_t entry_count = 0;
+    size_t total_size = 0;
+    FileCacheEntry *entries = file_cache_scan(dir, &entry_count, &total_size);
+    if (entries == NULL)
+        return;
+
+    if (total_size > max_size) {
+        qsort(entries, entry_count, sizeof(FileCacheEntry), compare_entries);
+        char path[FILE_CACHE_PATH_SIZE];
+        for (size_t i = 0; i < entry_count && total_size > max_size; i++) {
+            snprintf(path, sizeof(path), "%s/%s", dir, entries[i].name);
+            // Another compilation may have evicted it already.
+            if (unlink(path) == 0)
+                stats->evictions += 1;
+            total_size -= entries[i].size;
+        }
+    }
+    free(entries);
+}
+
+void file_cache_store(const char *dir, size_t max_size,
+                      const FileCacheKey *key, const char *out_path,
+                      FileCacheStats *stats) {
+    int code_fd = open(out_path, O_RDONLY);
+    if (code_fd < 0)
+        return;
+
+    struct stat code_stat;
+    char tmp_path[FILE_CACHE_PATH_SIZE];
+    snprintf(tmp_path, sizeof(tmp_path), "%s/.tmp" FILE_CACHE_SUFFIX ".XXXXXX",
+             dir);
+    int fd = -1;
+    if (fstat(code_fd, &code_stat) != 0 ||
+        sizeof(FileCacheHeader) + key->header.src_len + code_stat.st_size >
+            max_size ||
+        (fd = mkstemp(tmp_path)) < 0) {
+        close(code_fd);
+        return;
+    }
+
+    FileCacheHeader header = key->header;
+    header.code_len = code_stat.st_size;
+    char *buf = (char *)malloc(FILE_CACHE_CHUNK_SIZE);
+    CHECK_NULL(buf, "Unable to allocate memory for %s", "the compile cache");
+    char is_written = write_exact(fd, (const char *)&header, sizeof(header)) &&
+                      write_exact(fd, key->src, header.src_len);
+    for (size_t offset = 0; is_written && offset < header.code_len;) {
+        size_t len = header.code_len - offset;
+        len = len < FILE_CACHE_CHUNK_SIZE ? len : FILE_CACHE_CHUNK_SIZE;
+        is_written = read_exact(code_fd, buf, len) && write_exact(fd, buf, len);
+        offset += len;
+    }
+    free(buf);
+    close(code_fd);
+    is_written = close(fd) == 0 && is_written;
+
+    char path[FILE_CACHE_PATH_SIZE];
+    file_cache_path(dir, key, path);
+    if (!is_written || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        return;
+    }
+    file_cache_evict(dir, max_size, stats);
+}
+
+void file_cache_usage(const char *dir, size_t *entries, size_t *size) {
+    free(file_cache_scan(dir, entries, size));
+}
@@ -0,0 +1,202 @@
+#include "../inc/func_cache.h"
+#include "../inc/arch/platforms.h"
+#include "../inc/arena.h"
+#include "../inc/env_funcs.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define FUNC_CACHE_PATH_SIZE 4096
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+// Marks the end of the children of a node in a serialized tree.
+#define KEY_END_CHILDREN (-1)
+
+typedef struct FuncCacheHeader {
+    char magic[FUNC_CACHE_MAGIC_LEN];
+    uint64_t key_len;
+    int64_t label_first;
+    int64_t label_count;
+    uint64_t code_len;
+} FuncCacheHeader;
+
+static void key_int(OutBuf *key, int64_t val) {
+    out_buf_write(key, (const char *)&val, sizeof(val));
+}
+
+static void key_str(OutBuf *key, const char *str) {
+    if (str == NULL) {
+        key_int(key, -1);
+        return;
+    }
+    size_t len = strlen(str);
+    key_int(key, len);
+    out_buf_write(key, str, len);
+}
+
+// Serializes a node, and the nodes below it, but not the nodes after it.
+static void key_node(OutBuf *key, const AstNode *node) {
+    if (node == NULL) {
+        key_int(key, KEY_END_CHILDREN);
+        return;
+    }
+    key_int(key, node->type);
+    key_int(key, node->ast_val.val);
+    key_int(key, node->pointer_level);
+    key_str(key, node->ast_val.node_symbol);
+    for (AstNode *child = node->child; child != NULL;
+         child = child->next_child)
+        key_node(key, child);
+    key_int(key, KEY_END_CHILDREN);
+}
+
+// Serializes the variable bound to every symbol used in the function, and
+// the type bound to every other symbol, as seen from the context enclosing
+// it. Variables declared in the function are keyed as well, which only ever
+// makes the key stricter.
+static void key_symbol_types(OutBuf *key, ParsingContext *context,
+                             const AstNode *node) {
+    for (AstNode *child = node->child; child != NULL;
+         child = child->next_child) {
+        if (child->sym != NULL) {
+            key_node(key, child->sym->type);
+            key_int(key, child->sym->is_local);
+            key_int(key, child->sym->frame_offset);
+        } else if (child->ast_val.node_symbol != NULL) {
+            int stat = -1;
+            key_node(key, parser_get_type_ref(context, child, &stat));
+        }
+        key_symbol_types(key, context, child);
+    }
+}
+
+FuncCacheKey *func_cache_key(CGContext *cg_ctx, ParsingContext *context,
+                             AstNode *func, const char *func_name,
+                             long label_first, long label_count) {
+    OutBuf *key_out = out_buf_create_mem();
+    out_buf_write(key_out, FUNC_CACHE_MAGIC, FUNC_CACHE_MAGIC_LEN);
+    key_str(key_out, build_id());
+    key_int(key_out, cg_ctx->target_fmt);
+    key_int(key_out, cg_ctx->target_call_conv);
+    key_int(key_out, cg_ctx->target_asm_dialect);
+    key_int(key_out, cg_ctx->codegen_verbose);
+    key_int(key_out, label_count);
+    key_str(key_out, func_name);
+    cgcontext_write_cache_key(cg_ctx, key_out);
+    key_node(key_out, func);
+    key_symbol_types(key_out, context, func);
+
+    FuncCacheKey *key = (FuncCacheKey *)arena_calloc(sizeof(FuncCacheKey));
+    key->len = key_out->used;
+    key->data = (char *)arena_alloc(arena_get_current(), key->len);
+    memcpy(key->data, key_out->data, key->len);
+    out_buf_destroy(key_out);
+
+    key->hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < key->len; i++)
+        key->hash = (key->hash ^ (unsigned char)key->data[i]) * FNV_PRIME;
+    key->label_first = label_first;
+    key->label_count = label_count;
+    key->dir = cg_ctx->func_cache_dir;
+    return key;
+}
+
+static void func_cache_path(const FuncCacheKey *key, char *path) {
+    snprintf(path, FUNC_CACHE_PATH_SIZE, "%s/%016llx.fn", key->dir,
+             (unsigned long long)key->hash);
+}
+
+// Copies `code` into `code_out`, moving every label from the numbering the
+// entry was stored with, to the one for `key`. Returns 0 without writing
+// anything, if the code refers to a label outside the function.
+static char func_cache_renumber(const FuncCacheKey *key, long stored_first,
+                                const char *code, size_t code_len,
+                                OutBuf *code_out) {
+    size_t start = code_out->used;
+    size_t copied = 0;
+    for (size_t i = 0; i + 2 < code_len; i++) {
+        if (code[i] != '.' || code[i + 1] != 'L' || code[i + 2] < '0' ||
+            code[i + 2] > '9')
+            continue;
+
+        size_t end = i + 2;
+        long label = 0;
+        while (end < code_len && code[end] >= '0' && code[end] <= '9')
+            label = label * 10 + (code[end++] - '0');
+        if (label < stored_first || label >= stored_first + key->label_count) {
+            code_out->used = start;
+            return 0;
+        }
+
+        out_buf_write(code_out, code + copied, i + 2 - copied);
+        out_buf_int(code_out, label - stored_first + key->label_first);
+        copied = end;
+        i = end - 1;
+    }
+    out_buf_write(code_out, code + copied, code_len - copied);
+    return 1;
+}
+
+char func_cache_load(const FuncCacheKey *key, OutBuf *code_out) {
+    char path[FUNC_CACHE_PATH_SIZE];
+    func_cache_path(key, path);
+    FILE *fptr = fopen(path, "rb");
+    if (fptr == NULL)
+        return 0;
+
+    char is_hit = 0;
+    char *entry = NULL;
+    FuncCacheHeader header;
+    if (fread(&header, sizeof(header), 1, fptr) != 1 ||
+        memcmp(header.magic, FUNC_CACHE_MAGIC, FUNC_CACHE_MAGIC_LEN) != 0 ||
+        header.key_len != key->len || header.label_count != key->label_count)
+        goto done;
+
+    entry = (char *)malloc(header.key_len + header.code_len);
+    if (entry == NULL ||
+        fread(entry, 1, header.key_len + header.code_len, fptr) !=
+            header.key_len + header.code_len ||
+        memcmp(entry, key->data, key->len) != 0)
+        goto done;
+
+    is_hit = func_cache_renumber(key, header.label_first,
+                                 entry + header.key_len, header.code_len,
+                                 code_out);
+
+done:
+    free(entry);
+    fclose(fptr);
+    return is_hit;
+}
+
+void func_cache_store(const FuncCacheKey *key, const char *code,
+                      size_t code_len) {
+    char path[FUNC_CACHE_PATH_SIZE];
+    char tmp_path[FUNC_CACHE_PATH_SIZE];
+    func_cache_path(key, path);
+    snprintf(tmp_path, sizeof(tmp_path), "%s/.tmp.fn.XXXXXX", key->dir);
+    int fd = mkstemp(tmp_path);
+    if (fd < 0)
+        return;
+
+    FuncCacheHeader header;
+    memcpy(header.magic, FUNC_CACHE_MAGIC, FUNC_CACHE_MAGIC_LEN);
+    header.key_len = key->len;
+    header.label_first = key->label_first;
+    header.label_count = key->label_count;
+    header.code_len = code_len;
+
+    FILE *fptr = fdopen(fd, "wb");
+    char is_written =
+        fptr != NULL && fwrite(&header, sizeof(header), 1, fptr) == 1 &&
+        fwrite(key->data, 1, key->len, fptr) == key->len &&
+        fwrite(code, 1, code_len, fptr) == code_len;
+    if (fptr != NULL)
+        is_written = fclose(fptr) == 0 && is_written;
+    else
+        close(fd);
+
+    if (!is_written || rename(tmp_path, path) != 0)
+        unlink(tmp_path);
+}
@@ -0,0 +1,175 @@
+#include "../inc/intern.h"
+#include "../inc/arena.h"
+#include "../inc/utils.h"
+
+// Every thread has an intern table of its own, so that compilations running
+// side by side never share one.
+_Thread_local BuiltinSyms builtin_syms = {0};
+
+static _Thread_local InternStr **intern_slots = NULL;
+static _Thread_local size_t intern_slots_size = 0;
+static _Thread_local size_t intern_slots_used = 0;
+
+// Interned strings indexed by their id.
+static _Thread_local InternStr **intern_strs = NULL;
+static _Thread_local size_t intern_strs_size = 0;
+
+// Interned strings outlive a single compilation, so they get an arena of
+// their own, rather than the arena for a compilation.
+static _Thread_local Arena *intern_arena = NULL;
+
+unsigned long intern_hash(const char *str, size_t len) {
+    unsigned long hash = INTERN_HASH_INIT;
+    for (size_t i = 0; i < len; i++)
+        hash = INTERN_HASH_STEP(hash, str[i]);
+    return hash;
+}
+
+static void intern_grow() {
+    size_t new_size = intern_slots_size * 2;
+    InternStr **new_slots = (InternStr **)calloc(new_size, sizeof(InternStr *));
+    CHECK_NULL(new_slots, "Unable to allocate memory for the intern table",
+               NULL);
+
+    for (size_t i = 0; i < intern_slots_size; i++) {
+        InternStr *entry = intern_slots[i];
+        if (entry == NULL)
+            continue;
+        size_t idx = entry->hash & (new_size - 1);
+        while (new_slots[idx] != NULL)
+            idx = (idx + 1) & (new_size - 1);
+        new_slots[idx] = entry;
+    }
+
+    free(intern_slots);
+    intern_slots = new_slots;
+    intern_slots_size = new_size;
+}
+
+void intern_init() {
+    if (intern_slots != NULL)
+        return;
+
+    intern_arena = arena_create(0);
+    intern_slots =
+        (InternStr **)calloc(INTERN_TABLE_INIT_SIZE, sizeof(InternStr *));
+    CHECK_NULL(intern_slots, "Unable to allocate memory for the intern table",
+               NULL);
+    intern_slots_size = INTERN_TABLE_INIT_SIZE;
+    intern_slots_used = 0;
+
+    builtin_syms.function = intern_str("function");
+    builtin_syms.ext_function = intern_str("ext function");
+    builtin_syms.array = intern_str("array");
+    builtin_syms.int_type = intern_str("int");
+    builtin_syms.kw_if = intern_str("if");
+    builtin_syms.kw_else = intern_str("else");
+    builtin_syms.kw_ext = intern_str("ext");
+    builtin_syms.if_cond = intern_str("if-cond");
+    builtin_syms.if_then_body = intern_str("if-then-body");
+    builtin_syms.if_else_body = intern_str("if-else-body");
+    builtin_syms.lambda_body = intern_str("lambda_body");
+    builtin_syms.lambda_params = intern_str("lambda_params");
+    builtin_syms.func_call = intern_str("func_call");
+    builtin_syms.op_eq = intern_str("==");
+    builtin_syms.op_lt = intern_str("<");
+    builtin_syms.op_gt = intern_str(">");
+    builtin_syms.op_shl = intern_str("<<");
+    builtin_syms.op_shr = intern_str(">>");
+    builtin_syms.op_add = intern_str("+");
+    builtin_syms.op_sub = intern_str("-");
+    builtin_syms.op_mul = intern_str("*");
+    builtin_syms.op_div = intern_str("/");
+    builtin_syms.op_mod = intern_str("%");
+    builtin_syms.op_deref = intern_str("@");
+    builtin_syms.op_addr = intern_str("&");
+    builtin_syms.assign = intern_str(":=");
+    builtin_syms.equals = intern_str("=");
+    builtin_syms.colon = intern_str(":");
+    builtin_syms.comma = intern_str(",");
+    builtin_syms.paren_open = intern_str("(");
+    builtin_syms.paren_close = intern_str(")");
+    builtin_syms.brace_open = intern_str("{");
+    builtin_syms.brace_close = intern_str("}");
+    builtin_syms.bracket_open = intern_str("[");
+    builtin_syms.bracket_close = intern_str("]");
+}
+
+static InternStr *intern_entry(const char *str, size_t len,
+                               unsigned long hash) {
+    if (intern_slots == NULL)
+        print_error(ERR_DEV, "Intern table used before `intern_init()`");
+
+    size_t idx = hash & (intern_slots_size - 1);
+    while (intern_slots[idx] != NULL) {
+        InternStr *entry = intern_slots[idx];
+        if (entry->hash == hash && entry->length == len &&
+            memcmp(entry->str, str, len) == 0)
+            return entry;
+        idx = (idx + 1) & (intern_slots_size - 1);
+    }
+
+    InternStr *entry =
+        (InternStr *)arena_alloc(intern_arena, sizeof(InternStr) + len + 1);
+    entry->hash = hash;
+    entry->length = len;
+    entry->id = intern_slots_used;
+    memcpy(entry->str, str, len);
+    entry->str[len] = '\0';
+    intern_slots[idx] = entry;
+    intern_slots_used += 1;
+
+    if (entry->id == intern_strs_size) {
+        intern_strs_size = intern_strs_size == 0 ? INTERN_TABLE_INIT_SIZE
+                                                 : intern_strs_size * 2;
+        intern_strs = (InternStr **)realloc(
+            intern_strs, intern_strs_size * sizeof(InternStr *));
+        CHECK_NULL(intern_strs,
+                   "Unable to allocate memory for the intern table", NULL);
+    }
+    intern_strs[entry->id] = entry;
+
+    // Keep the load factor under a half, so that probe sequences stay short.
+    if (intern_slots_used * 2 > intern_slots_size)
+        intern_grow();
+
+    return entry;
+}
+
+char *intern_str_hashed(const char *str, size_t len, unsigned long hash) {
+    return intern_entry(str, len, hash)->str;
+}
+
+unsigned int intern_id_hashed(const char *str, size_t len, unsigned long hash) {
+    return intern_entry(str, len, hash)->id;
+}
+
+char *intern_get(unsigned int id) {
+    if (id >= intern_slots_used)
+        print_error(ERR_DEV, "Invalid intern id : %u", id);
+    return intern_strs[id]->str;
+}
+
+unsigned int intern_sym_id(const char *str) {
+    return ((const InternStr *)(str - offsetof(InternStr, str)))->id;
+}
+
+char *intern_str(const char *str) {
+    size_t len = strlen(str);
+    return intern_str_hashed(str, len, intern_hash(str, len));
+}
+
+size_t intern_count() { return intern_slots_used; }
+
+void intern_destroy() {
+    free(intern_slots);
+    intern_slots = NULL;
+    free(intern_strs);
+    intern_strs = NULL;
+    intern_strs_size = 0;
+    intern_slots_size = 0;
+    intern_slots_used = 0;
+    arena_destroy(intern_arena);
+    intern_arena = NULL;
+    builtin_syms = (BuiltinSyms){0};
+}
@@ -1,89 +1,249 @@
 #include "../inc/lexer.h"
+#include "../inc/arena.h"
 #include "../inc/code_gen.h"
+#include "../inc/intern.h"
 #include "../inc/parser.h"
+#include "../inc/pass_stats.h"
+
+char *lexed_token_str(LexedToken *token) {
+    return intern_get(token->token_id);
+}
 
 void print_lexed_token(LexedToken *curr_token) {
     if (curr_token == NULL)
         return;
-    printf("%.*s", curr_token->token_length, curr_token->token_start);
+    printf("%s", lexed_token_str(curr_token));
 }
 
-int strncmp_lexed_token(LexedToken *curr_token, char *str_to_cmp) {
-    if (curr_token == NULL || str_to_cmp == NULL) {
-        return 0;
-    }
-    int len = curr_token->token_length;
-    if (len != (int)strlen(str_to_cmp))
+int lexed_token_is(LexedToken *curr_token, const char *sym) {
+    if (curr_token == NULL || sym == NULL) {
         return 0;
-    char *temp = curr_token->token_start;
-    while (len != 0) {
-        if (*temp != *str_to_cmp)
-            return 0;
-        temp++;
-        str_to_cmp++;
-        len--;
     }
-    return 1;
+    return lexed_token_str(curr_token) == sym;
 }
 
-LexedToken *create_token(int token_length, char *data) {
-    LexedToken *curr_token = (LexedToken *)calloc(1, sizeof(LexedToken));
-    CHECK_NULL(curr_token, "Could not allocate memory for token", NULL);
-    curr_token->token_length = token_length;
-    curr_token->token_start = data;
+// Class of every byte in the source, anything that isn't listed here is part
+// of an identifier or an integer.
+static const unsigned char char_class[256] = {
+    ['\0'] = CHAR_NUL,       [' '] = CHAR_SPACE,      ['\r'] = CHAR_SPACE,
+    ['\n'] = CHAR_SPACE,     [';'] = CHAR_SPACE,      ['`'] = CHAR_COMMENT,
+    ['#'] = CHAR_COMMENT,    ['+'] = CHAR_OPERATOR,   ['-'] = CHAR_OPERATOR,
+    ['*'] = CHAR_OPERATOR,   ['/'] = CHAR_OPERATOR,   ['%'] = CHAR_OPERATOR,
+    ['<'] = CHAR_OPERATOR,   ['>'] = CHAR_OPERATOR,   ['='] = CHAR_OPERATOR,
+    ['&'] = CHAR_OPERATOR,   ['@'] = CHAR_OPERATOR,   [':'] = CHAR_PUNCTUATOR,
+    [','] = CHAR_PUNCTUATOR, ['~'] = CHAR_PUNCTUATOR, ['('] = CHAR_PUNCTUATOR,
+    [')'] = CHAR_PUNCTUATOR, ['{'] = CHAR_PUNCTUATOR, ['}'] = CHAR_PUNCTUATOR,
+    ['['] = CHAR_PUNCTUATOR, [']'] = CHAR_PUNCTUATOR,
+};
 
-    return curr_token;
+// Second character of the two character operators, indexed by the first
+// character, i.e. `:=`, `<<`, `>>` and `==`.
+static const char op_second_char[256] = {
+    [':'] = '=',
+    ['<'] = '<',
+    ['>'] = '>',
+    ['='] = '=',
+};
+
+// Keywords are looked up with a perfect hash of the length and the first
+// character of the identifier.
+#define KEYWORD_HASH(str, len) (((len) + (unsigned char)(str)[0]) & 3)
+
+static const char *keyword_table[4] = {"ext", "else", NULL, "if"};
+
+static int check_keyword(char *token_start, int token_length) {
+    const char *keyword =
+        keyword_table[KEYWORD_HASH(token_start, token_length)];
+    return keyword != NULL && (int)strlen(keyword) == token_length &&
+           memcmp(keyword, token_start, token_length) == 0;
 }
 
-int check_comment(char *file_data) {
-    char *temp = COMMENTS_DELIMS;
-    while (*temp != '\0') {
-        if (*file_data == *temp)
-            return 1;
-        temp++;
+static char *lex_next_token(char *data, char *file_data, LexedToken *token) {
+    // Skip all whitespace, and comments.
+    for (;;) {
+        unsigned char curr_class = char_class[(unsigned char)*data];
+        if (curr_class == CHAR_SPACE) {
+            data++;
+        } else if (curr_class == CHAR_COMMENT) {
+            while (*data != '\n' && *data != '\0')
+                data++;
+        } else
+            break;
     }
-    return 0;
+
+    char *token_start = data;
+    unsigned long hash = INTERN_HASH_INIT;
+    TokenKind token_kind = TOKEN_EOF;
+
+    switch (char_class[(unsigned char)*data]) {
+    case CHAR_NUL:
+        break;
+    case CHAR_OPERATOR:
+    case CHAR_PUNCTUATOR:
+        token_kind = char_class[(unsigned char)*data] == CHAR_OPERATOR
+                         ? TOKEN_OPERATOR
+                         : TOKEN_PUNCTUATOR;
+        hash = INTERN_HASH_STEP(hash, *data);
+        if (op_second_char[(unsigned char)*data] != '\0' &&
+            op_second_char[(unsigned char)*data] == data[1]) {
+            token_kind = TOKEN_OPERATOR;
+            hash = INTERN_HASH_STEP(hash, data[1]);
+            data++;
+        }
+        data++;
+        break;
+    default:
+        // Everything up to the next whitespace, operator or punctuation
+        // character is a single word, comment characters are allowed
+        // within a word.
+        token_kind = (*data >= '0' && *data <= '9') ? TOKEN_INTEGER
+                                                    : TOKEN_IDENTIFIER;
+        while (char_class[(unsigned char)*data] == CHAR_WORD ||
+               char_class[(unsigned char)*data] == CHAR_COMMENT) {
+            hash = INTERN_HASH_STEP(hash, *data);
+            data++;
+        }
+        if (token_kind == TOKEN_IDENTIFIER &&
+            check_keyword(token_start, data - token_start))
+            token_kind = TOKEN_KEYWORD;
+        break;
+    }
+
+    size_t token_length = data - token_start;
+    if (token_length > TOKEN_MAX_LENGTH)
+        print_error(ERR_SYNTAX, "Token longer than %d characters : `%.32s...`",
+                    TOKEN_MAX_LENGTH, token_start);
+    if ((size_t)(token_start - file_data) > UINT32_MAX)
+        print_error(ERR_FILE_SIZE, "Source file is larger than 4GB");
+
+    token->token_offset = token_start - file_data;
+    token->token_length = token_length;
+    token->token_kind = token_kind;
+    token->token_id = intern_id_hashed(token_start, token_length, hash);
+    return data;
 }
 
-void lex_token(LexingState **state) {
-    /// Tokenizing;
-    int begin = 0;
-    // Skip all whitespace.
-    (*state)->file_data += (strspn((*state)->file_data, WHITESPACE));
-    // Skip all the comments.
-    while (check_comment((*state)->file_data)) {
-        (*state)->file_data = strpbrk((*state)->file_data, "\n");
-        (*state)->file_data += (strspn((*state)->file_data, WHITESPACE));
+LexedToken *lex_file(char *file_data, size_t *token_count) {
+    size_t tokens_size = TOKEN_ARR_INIT_SIZE;
+    size_t tokens_used = 0;
+    LexedToken *tokens = (LexedToken *)malloc(tokens_size * sizeof(LexedToken));
+    CHECK_NULL(tokens, "Unable to allocate memory for the tokens", NULL);
+    err_trap_own(tokens);
+
+    char *data = file_data;
+    do {
+        if (tokens_used == tokens_size) {
+            tokens_size *= 2;
+            tokens = (LexedToken *)realloc(tokens,
+                                           tokens_size * sizeof(LexedToken));
+            CHECK_NULL(tokens, "Unable to allocate memory for the tokens",
+                       NULL);
+            err_trap_own(tokens);
+        }
+        data = lex_next_token(data, file_data, &tokens[tokens_used]);
+        tokens_used++;
+    } while (tokens[tokens_used - 1].token_kind != TOKEN_EOF);
+
+    *token_count = tokens_used;
+    pass_stats.tokens_lexed += tokens_used;
+    return tokens;
+}
+
+LexingState *lex_stream_create(char *file_data) {
+    LexingState *state = (LexingState *)arena_calloc(sizeof(LexingState));
+    state->file_data = file_data;
+    state->tokens = NULL;
+    state->token_idx = 0;
+    state->curr_token = NULL;
+    state->window = (TokenWindow *)arena_calloc(sizeof(TokenWindow));
+    state->window->lex_data = file_data;
+    return state;
+}
+
+// Lexes the source up to token `idx` of the window, which is never past the
+// `TOKEN_EOF` token, since it isn't moved past.
+static LexedToken *lex_window_token(LexingState *state, uint32_t idx) {
+    TokenWindow *window = state->window;
+    while (idx >= window->token_count) {
+        size_t block_idx = window->token_count / TOKEN_BLOCK_SIZE;
+        if (block_idx == window->blocks_size) {
+            size_t new_size =
+                window->blocks_size == 0 ? 4 : window->blocks_size * 2;
+            window->blocks = (LexedToken **)realloc(
+                window->blocks, new_size * sizeof(LexedToken *));
+            CHECK_NULL(window->blocks,
+                       "Unable to allocate memory for the tokens", NULL);
+            memset(window->blocks + window->blocks_size, 0,
+                   (new_size - window->blocks_size) * sizeof(LexedToken *));
+            window->blocks_size = new_size;
+        }
+        if (window->blocks[block_idx] == NULL) {
+            window->blocks[block_idx] =
+                (LexedToken *)malloc(TOKEN_BLOCK_SIZE * sizeof(LexedToken));
+            CHECK_NULL(window->blocks[block_idx],
+                       "Unable to allocate memory for the tokens", NULL);
+        }
+
+        LexedToken *token = &window->blocks[block_idx][window->token_count %
+                                                       TOKEN_BLOCK_SIZE];
+        window->lex_data =
+            lex_next_token(window->lex_data, state->file_data, token);
+        window->token_count += 1;
+        pass_stats.tokens_lexed += 1;
     }
-    if (*(*state)->file_data != '\0') {
-        // Move forward until a delimiter is encountered.
-        begin = strcspn((*state)->file_data, DELIMS);
-        begin = (begin == 0 ? 1 : begin);
-        (*state)->curr_token = create_token(begin, (*state)->file_data);
-        (*state)->file_data += begin;
-    } else {
-        *(*state)->curr_token->token_start = '\0';
+    return &window->blocks[idx / TOKEN_BLOCK_SIZE][idx % TOKEN_BLOCK_SIZE];
+}
+
+size_t lex_stream_release(LexingState *state) {
+    TokenWindow *window = state->window;
+
+    // Blocks before the one holding the next token are done with, the rest
+    // move to the front.
+    size_t done_count = state->token_idx / TOKEN_BLOCK_SIZE;
+    if (done_count > 0) {
+        for (size_t i = 0; i < done_count; i++)
+            free(window->blocks[i]);
+        memmove(window->blocks, window->blocks + done_count,
+                (window->blocks_size - done_count) * sizeof(LexedToken *));
+        memset(window->blocks + window->blocks_size - done_count, 0,
+               done_count * sizeof(LexedToken *));
+        state->token_idx -= done_count * TOKEN_BLOCK_SIZE;
+        window->token_count -= done_count * TOKEN_BLOCK_SIZE;
     }
+    state->curr_token = NULL;
+    return window->lex_data - state->file_data;
+}
+
+void lex_stream_destroy(LexingState *state) {
+    TokenWindow *window = state->window;
+    for (size_t i = 0; i < window->blocks_size; i++)
+        free(window->blocks[i]);
+    free(window->blocks);
+    window->blocks = NULL;
+    window->blocks_size = 0;
+    window->token_count = 0;
+}
+
+void lex_token(LexingState **state) {
+    (*state)->curr_token = peek_token(*state);
+    if ((*state)->curr_token->token_kind != TOKEN_EOF)
+        (*state)->token_idx += 1;
 }
 
-void extend_curr_token(LexingState **state) {
-    LexingState temp_state = **state;
-    LexingState *temp_state_ptr = &temp_state;
-    lex_token(&temp_state_ptr);
-    (*state)->curr_token->token_length += (*state)->curr_token->token_length;
+LexedToken *peek_token(LexingState *state) {
+    if (state->window != NULL)
+        return lex_window_token(state, state->token_idx);
+    return &state->tokens[state->token_idx];
 }
 
-int check_next_token(char *string_to_cmp, LexingState **state) {
-    if (string_to_cmp == NULL || (*state)->file_data == NULL ||
-        (*state)->curr_token == NULL) {
+int check_next_token(const char *sym, LexingState **state) {
+    if (sym == NULL ||
+        ((*state)->tokens == NULL && (*state)->window == NULL)) {
         print_error(ERR_COMMON, "NULL pointer passed to `check_next_token()`");
         return 0;
     }
-    LexingState temp_state = **state;
-    LexingState *temp_state_ptr = &temp_state;
-    lex_token(&temp_state_ptr);
-    if (strncmp_lexed_token(temp_state.curr_token, string_to_cmp)) {
-        **state = temp_state;
+    if (lexed_token_is(peek_token(*state), sym)) {
+        lex_token(state);
         return 1;
     }
     return 0;
@@ -1,10 +1,426 @@
+#include "../inc/arena.h"
 #include "../inc/ast_funcs.h"
 #include "../inc/code_gen.h"
+#include "../inc/file_cache.h"
+#include "../inc/intern.h"
 #include "../inc/lexer.h"
 #include "../inc/parser.h"
+#include "../inc/pass_stats.h"
+#include "../inc/server.h"
+#include "../inc/task_pool.h"
 #include "../inc/type_check.h"
 #include "../inc/utils.h"
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAX_COMPILE_JOBS 256
+#define MAX_CACHE_MIB (1024 * 1024)
+
+// Options applied to every input file.
+typedef struct CompileOptions {
+    TargetFormat out_fmt;
+    TargetCallingConvention call_conv;
+    TargetAssemblyDialect dialect;
+    int codegen_jobs;
+    int is_verbose;
+    int is_mem_stats;
+    int is_time_passes;
+    PassReportFormat pass_report_fmt;
+    char *func_cache_dir;
+    int is_func_cache_stats;
+    char *cache_dir;
+    size_t cache_max_size;
+    int is_cache_stats;
+    int is_stream;
+} CompileOptions;
+
+// A single input file, compiled on a worker in batch mode.
+typedef struct CompileJob {
+    const CompileOptions *opts;
+    char *in_path;
+    char *out_path;
+    SourceFile source;
+    FileCacheStats cache_stats;
+    char has_error;
+    ErrType err;
+    char err_msg[ERR_MSG_SIZE];
+} CompileJob;
+
+// If the output file name is not passed, the input file name is used as the
+// base name for the assembly file, in the current directory.
+static char *default_out_path(const char *in_path) {
+    const char *file_name = STDIN_OUT_FILE;
+    size_t file_name_len = strlen(file_name);
+    if (strcmp(in_path, "-") != 0) {
+        file_name = strrchr(in_path, '/');
+        file_name = file_name == NULL ? in_path : file_name + 1; // Skip `/`.
+        file_name_len = strlen(file_name);
+
+        // TODO: Input file extensions will also need to
+        // checked some time in the future to enforce proper usage.
+
+        // Remove the last character of the extension, which
+        // should be `.sy` for sypher files.
+        if (file_name_len > 0)
+            file_name_len -= 1;
+    }
+
+    char *out_path = (char *)malloc(file_name_len + 1);
+    CHECK_NULL(out_path, "Unable to allocate memory for the output path : `%s`",
+               in_path);
+    memcpy(out_path, file_name, file_name_len);
+    out_path[file_name_len] = '\0';
+    return out_path;
+}
+
+// Compiles the file at `in_path` into `out_path`, with every object coming
+// from `arena`. The contents of the file are kept in `source`, so that they
+// can be released even if the compilation fails. Lookups in the compile
+// cache are counted in `cache_stats`.
+static void compile_file(const CompileOptions *opts, char *in_path,
+                         char *out_path, Arena *arena, SourceFile *source,
+                         FileCacheStats *cache_stats) {
+    size_t phase_start_bytes = arena->bytes_used;
+    size_t parse_bytes = 0;
+    size_t type_check_bytes = 0;
+    size_t phase_start_allocs = arena->alloc_count;
+    size_t parse_allocs = 0;
+    size_t type_check_allocs = 0;
+
+    // Allocate the AST Node for the whole program.
+    AstNode *program = node_alloc();
+    program->type = TYPE_PROGRAM;
+
+    ParsingContext *curr_context = create_default_parsing_context();
+
+    // Open the file, lex and parse the file.
+    PassTimer pass_timer;
+    pass_stats_reset();
+
+    pass_timer_start(&pass_timer);
+    read_file_data(in_path, source);
+    pass_timer_stop(&pass_timer, PASS_READ);
+    if (opts->is_verbose == 1)
+        fprintf(stderr, "[+]READ `%s` : %zu bytes in %.3f ms (%s)\n", in_path,
+                source->file_size, source->read_ms,
+                source->map_size != 0 ? "mapped" : "read");
+
+    // On a hit, the cached code is copied out, and the source is never
+    // lexed. On a miss, the source is kept until the code is stored.
+    FileCacheKey cache_key;
+    if (opts->cache_dir != NULL) {
+        file_cache_key(&cache_key, source->file_data, source->file_size,
+                       opts->out_fmt, opts->dialect, opts->call_conv);
+        if (file_cache_load(opts->cache_dir, &cache_key, out_path)) {
+            cache_stats->hits += 1;
+            release_file_data(source);
+            return;
+        }
+        cache_stats->misses += 1;
+    }
+
+    pass_timer_start(&pass_timer);
+    lex_and_parse(source->file_data, &curr_context, &program);
+    pass_timer_stop(&pass_timer, PASS_LEX_PARSE);
+    if (opts->cache_dir == NULL)
+        release_file_data(source);
+    parse_bytes = arena->bytes_used - phase_start_bytes;
+    phase_start_bytes = arena->bytes_used;
+    parse_allocs = arena->alloc_count - phase_start_allocs;
+    phase_start_allocs = arena->alloc_count;
+
+    if (opts->is_verbose == 1) {
+        print_ast_node(program, 0);
+        putchar('\n');
+        print_parsing_context(curr_context, 0);
+    }
+
+    // Type check the program.
+    pass_timer_start(&pass_timer);
+    type_check_prog(curr_context, program);
+    pass_timer_stop(&pass_timer, PASS_TYPE_CHECK);
+    type_check_bytes = arena->bytes_used - phase_start_bytes;
+    phase_start_bytes = arena->bytes_used;
+    type_check_allocs = arena->alloc_count - phase_start_allocs;
+    phase_start_allocs = arena->alloc_count;
+
+    // Start Code generation.
+    if (opts->is_verbose == 1)
+        printf("\n[+]CODE GENERATION BEGIN...\n");
+
+    pass_timer_start(&pass_timer);
+    target_codegen(curr_context, program, out_path, opts->out_fmt,
+                   opts->dialect, opts->call_conv, opts->codegen_jobs,
+                   opts->func_cache_dir);
+    pass_timer_stop(&pass_timer, PASS_CODEGEN);
+
+    if (opts->is_verbose == 1)
+        printf("[+]CODE GENERATION COMPLETE\n");
+
+    if (opts->cache_dir != NULL) {
+        file_cache_store(opts->cache_dir, opts->cache_max_size, &cache_key,
+                         out_path, cache_stats);
+        release_file_data(source);
+    }
+
+    if (opts->is_mem_stats == 1) {
+        fprintf(stderr,
+                "[+]ARENA BYTES USED (ALLOCATIONS)\n"
+                "    lex & parse : %zu (%zu)\n"
+                "    type check  : %zu (%zu)\n"
+                "    code gen    : %zu (%zu)\n"
+                "    total       : %zu (%zu), %zu reserved\n"
+                "    interned    : %zu strings\n"
+                "    ast nodes   : %zu allocated, %zu bytes\n",
+                parse_bytes, parse_allocs, type_check_bytes,
+                type_check_allocs, arena->bytes_used - phase_start_bytes,
+                arena->alloc_count - phase_start_allocs, arena->bytes_used,
+                arena->alloc_count, arena->bytes_reserved, intern_count(),
+                pass_stats.ast_nodes, pass_stats.ast_nodes * sizeof(AstNode));
+    }
+
+    if (opts->is_time_passes == 1)
+        pass_stats_print(stderr, opts->pass_report_fmt);
+
+    if (opts->is_func_cache_stats == 1)
+        fprintf(stderr, "[+]FUNCTION CACHE : %zu hits, %zu misses\n",
+                pass_stats.func_cache_hits, pass_stats.func_cache_misses);
+}
+
+// Passes are timed for every expression, which takes longer than compiling
+// the smaller ones, so the clocks are only read when the times are reported.
+static void stream_timer_start(const CompileOptions *opts, PassTimer *timer) {
+    if (opts->is_time_passes == 1)
+        pass_timer_start(timer);
+}
+
+static void stream_timer_stop(const CompileOptions *opts, PassTimer *timer,
+                              Pass pass) {
+    if (opts->is_time_passes == 1)
+        pass_timer_stop(timer, pass);
+}
+
+// Compiles the file at `in_path` into `out_path` one top-level expression at
+// a time. Every expression is parsed, type checked, and generated from an
+// arena of its own, which is released before the next one is parsed. Only
+// what outlives an expression, i.e. the root context, the globals bound in
+// it, and canonical types, comes from `arena`, so memory use stays flat as
+// the source grows.
+static void compile_file_stream(const CompileOptions *opts, char *in_path,
+                                char *out_path, Arena *arena,
+                                SourceFile *source) {
+    ParsingContext *curr_context = create_default_parsing_context();
+
+    PassTimer pass_timer;
+    pass_stats_reset();
+
+    stream_timer_start(opts, &pass_timer);
+    read_file_data(in_path, source);
+    stream_timer_stop(opts, &pass_timer, PASS_READ);
+
+    LexingState *state = lex_stream_create(source->file_data);
+    CGStream *cg_stream =
+        target_codegen_stream_create(out_path, opts->out_fmt, opts->dialect,
+                                     opts->call_conv, opts->func_cache_dir);
+    Arena *expr_arena = arena_create(0);
+
+    // Everything is released before an error is passed on, and the output,
+    // that would only be partly written, is left empty.
+    char has_error = 0;
+    ErrTrap trap;
+    err_trap_push(&trap);
+    if (setjmp(trap.env) == 0) {
+        for (;;) {
+            arena_set_current(expr_arena);
+
+            stream_timer_start(opts, &pass_timer);
+            AstNode *curr_expr = parse_next_expr(state, &curr_context);
+            stream_timer_stop(opts, &pass_timer, PASS_LEX_PARSE);
+            if (curr_expr == NULL)
+                break;
+
+            // A declaration with an initializer is parsed into two
+            // expressions, the second following the first.
+            for (AstNode *expr = curr_expr; expr != NULL;
+                 expr = expr->next_child) {
+                if (expr->type == TYPE_NULL)
+                    continue;
+                stream_timer_start(opts, &pass_timer);
+                type_check_expr(curr_context, expr);
+                stream_timer_stop(opts, &pass_timer, PASS_TYPE_CHECK);
+
+                stream_timer_start(opts, &pass_timer);
+                target_codegen_stream_expr(cg_stream, curr_context, expr);
+                stream_timer_stop(opts, &pass_timer, PASS_CODEGEN);
+            }
+
+            parser_drop_child_contexts(curr_context);
+            arena_reset(expr_arena);
+            drop_file_data(source, lex_stream_release(state));
+        }
+
+        arena_set_current(arena);
+        stream_timer_start(opts, &pass_timer);
+        target_codegen_stream_finish(cg_stream, curr_context);
+        stream_timer_stop(opts, &pass_timer, PASS_CODEGEN);
+    } else
+        has_error = 1;
+    err_trap_pop(&trap);
+
+    arena_set_current(arena);
+    arena_destroy(expr_arena);
+    target_codegen_stream_destroy(cg_stream, has_error);
+    lex_stream_destroy(state);
+    release_file_data(source);
+    if (has_error)
+        print_error(trap.err, "%s", trap.msg);
+
+    if (opts->is_time_passes == 1)
+        pass_stats_print(stderr, opts->pass_report_fmt);
+
+    if (opts->is_func_cache_stats == 1)
+        fprintf(stderr, "[+]FUNCTION CACHE : %zu hits, %zu misses\n",
+                pass_stats.func_cache_hits, pass_stats.func_cache_misses);
+}
+
+// Reports a failure for a single file, out of many.
+static void print_file_error(ErrType err, const char *in_path,
+                             const char *msg) {
+    fprintf(stderr, "\033[1;31m[ERROR]\033[1;37m %s:: `%s` : %s!\n",
+            err_strings[err], in_path, msg);
+}
+
+static void compile_job(void *job_data) {
+    CompileJob *job = (CompileJob *)job_data;
+
+    // Every file gets an arena, and intern tables of its own, released as
+    // soon as it is compiled, rather than when the batch is done.
+    Arena *worker_arena = arena_get_current();
+    Arena *arena = arena_create(0);
+    arena_set_current(arena);
+
+    ErrTrap trap;
+    err_trap_push(&trap);
+    if (setjmp(trap.env) == 0) {
+        if (job->opts->is_stream == 1)
+            compile_file_stream(job->opts, job->in_path, job->out_path, arena,
+                                &job->source);
+        else
+            compile_file(job->opts, job->in_path, job->out_path, arena,
+                         &job->source, &job->cache_stats);
+    } else {
+        job->has_error = 1;
+        job->err = trap.err;
+        memcpy(job->err_msg, trap.msg, ERR_MSG_SIZE);
+    }
+    err_trap_pop(&trap);
+
+    if (job->source.file_data != NULL)
+        release_file_data(&job->source);
+    arena_set_current(worker_arena);
+    arena_destroy(arena);
+    intern_destroy();
+}
+
+// Compiles every file in `in_paths` on `jobs` workers, each into its default
+// output file. Failures are reported together, in the order of the inputs,
+// once every file has been compiled. Lookups in the compile cache are added
+// to `cache_stats`.
+static int compile_batch(const CompileOptions *opts, char **in_paths,
+                         int in_count, int jobs, FileCacheStats *cache_stats) {
+    CompileJob *compile_jobs =
+        (CompileJob *)calloc(in_count, sizeof(CompileJob));
+    CHECK_NULL(compile_jobs, "Unable to allocate memory for %s",
+               "compile jobs");
+
+    TaskPool *pool = task_pool_create(jobs < in_count ? jobs : in_count);
+    for (int i = 0; i < in_count; i++) {
+        compile_jobs[i].opts = opts;
+        compile_jobs[i].in_path = in_paths[i];
+        compile_jobs[i].out_path = default_out_path(in_paths[i]);
+        task_pool_submit(pool, compile_job, &compile_jobs[i]);
+    }
+    task_pool_destroy(pool);
+
+    int failed_count = 0;
+    for (int i = 0; i < in_count; i++) {
+        if (compile_jobs[i].has_error) {
+            print_file_error(compile_jobs[i].err, compile_jobs[i].in_path,
+                             compile_jobs[i].err_msg);
+            failed_count += 1;
+        }
+        cache_stats->hits += compile_jobs[i].cache_stats.hits;
+        cache_stats->misses += compile_jobs[i].cache_stats.misses;
+        cache_stats->evictions += compile_jobs[i].cache_stats.evictions;
+        free(compile_jobs[i].out_path);
+    }
+    free(compile_jobs);
+    return failed_count;
+}
+
+// Reports the lookups in the compile cache, and how full it is.
+static void print_cache_stats(const CompileOptions *opts,
+                              const FileCacheStats *cache_stats) {
+    size_t entries = 0;
+    size_t size = 0;
+    file_cache_usage(opts->cache_dir, &entries, &size);
+    fprintf(stderr,
+            "[+]COMPILE CACHE\n"
+            "    lookups : %zu hits, %zu misses\n"
+            "    evicted : %zu entries\n"
+            "    size    : %zu entries, %zu of %zu bytes\n",
+            cache_stats->hits, cache_stats->misses, cache_stats->evictions,
+            entries, size, opts->cache_max_size);
+}
+
+// Compiles every file in `in_paths` on the server listening on `sock_path`,
+// writing the assembly where `sypherc` would have. A single file fails the
+// way it would without a server, with many, failures are reported together.
+static int compile_client(const CompileOptions *opts, const char *sock_path,
+                          char **in_paths, int in_count, char *out_path) {
+    SypherOptions sypher_opts = {
+        .out_fmt = opts->out_fmt,
+        .call_conv = opts->call_conv,
+        .dialect = opts->dialect,
+        .codegen_jobs = opts->codegen_jobs,
+    };
+    int sock_fd = server_connect(sock_path);
+
+    int failed_count = 0;
+    for (int i = 0; i < in_count; i++) {
+        SourceFile source;
+        SypherOutput out;
+        read_file_data(in_paths[i], &source);
+        int ret = server_compile(sock_fd, source.file_data, source.file_size,
+                                 &sypher_opts, &out);
+        release_file_data(&source);
+        if (ret != 0 && in_count == 1)
+            print_error(out.err, "%s", out.err_msg);
+        if (ret != 0) {
+            print_file_error(out.err, in_paths[i], out.err_msg);
+            failed_count += 1;
+            continue;
+        }
+
+        char *file_path =
+            out_path != NULL ? out_path : default_out_path(in_paths[i]);
+        FILE *fptr = fopen(file_path, "w");
+        if (fptr == NULL)
+            print_error(ERR_FILE_OPEN,
+                        "Unable to open file for code generation : `%s`",
+                        file_path);
+        if (fwrite(out.code, 1, out.code_len, fptr) != out.code_len)
+            print_error(ERR_FILE_WRITE, "Unable to write : `%s`", file_path);
+        fclose(fptr);
+        if (file_path != out_path)
+            free(file_path);
+        sypher_output_free(&out);
+    }
+
+    close(sock_fd);
+    return failed_count;
+}
 
 int main(int argc, char **argv) {
     if (argc < 2) {
@@ -13,11 +429,28 @@ int main(int argc, char **argv) {
     }
 
     int out_file_idx = -1;
-    int in_file_idx = -1;
-    TargetFormat out_fmt = TARGET_FMT_DEFAULT;
-    TargetCallingConvention call_conv = TARGET_CALL_CONV_WIN;
-    TargetAssemblyDialect dialect = TARGET_ASM_DIALECT_DEFAULT;
-    int is_verbose = -1;
+    char **in_paths = (char **)malloc(argc * sizeof(char *));
+    CHECK_NULL(in_paths, "Unable to allocate memory for %s", "input paths");
+    int in_count = 0;
+    int compile_jobs = 0;
+    char *server_sock = NULL;
+    char *client_sock = NULL;
+    CompileOptions opts = {
+        .out_fmt = TARGET_FMT_DEFAULT,
+        .call_conv = TARGET_CALL_CONV_WIN,
+        .dialect = TARGET_ASM_DIALECT_DEFAULT,
+        .codegen_jobs = 1,
+        .is_verbose = -1,
+        .is_mem_stats = -1,
+        .is_time_passes = -1,
+        .pass_report_fmt = PASS_REPORT_HUMAN,
+        .func_cache_dir = NULL,
+        .is_func_cache_stats = -1,
+        .cache_dir = NULL,
+        .cache_max_size = (size_t)FILE_CACHE_DEFAULT_MAX_MIB * 1024 * 1024,
+        .is_cache_stats = -1,
+        .is_stream = -1,
+    };
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             printf("%s", USAGE_STRING);
@@ -30,14 +463,14 @@ int main(int argc, char **argv) {
                 print_error(ERR_ARGS, "Expected Input file path after %s",
                             argv[i - 1]);
             }
-            if (*argv[i] == '-') {
+            if (*argv[i] == '-' && strcmp(argv[i], "-") != 0) {
                 printf("\nSee `%s --help`\n\n", argv[0]);
                 print_error(ERR_ARGS,
                             "Expected valid input file path got another "
                             "possible command line option : `%s`",
                             argv[i]);
             }
-            in_file_idx = i;
+            in_paths[in_count++] = argv[i];
         } else if (strcmp(argv[i], "-o") == 0 ||
                    strcmp(argv[i], "--output") == 0) {
             i = i + 1;
@@ -70,9 +503,9 @@ int main(int argc, char **argv) {
                             argv[i]);
             }
             if (strcmp(argv[i], "default") == 0)
-                out_fmt = TARGET_FMT_DEFAULT;
+                opts.out_fmt = TARGET_FMT_DEFAULT;
             else if (strcmp(argv[i], "x86_64-gnu-as") == 0)
-                out_fmt = TARGET_FMT_X86_64_GNU_AS;
+                opts.out_fmt = TARGET_FMT_X86_64_GNU_AS;
             else {
                 printf("\nSee `%s --help`\n\n", argv[0]);
                 print_error(ERR_ARGS,
@@ -96,20 +529,142 @@ int main(int argc, char **argv) {
                     argv[i]);
             }
             if (strcmp(argv[i], "default") == 0)
-                call_conv = TARGET_CALL_CONV_WIN;
+                opts.call_conv = TARGET_CALL_CONV_WIN;
             else if (strcmp(argv[i], "linux") == 0)
-                call_conv = TARGET_CALL_CONV_LINUX;
+                opts.call_conv = TARGET_CALL_CONV_LINUX;
             else if (strcmp(argv[i], "windows") == 0)
-                call_conv = TARGET_CALL_CONV_WIN;
+                opts.call_conv = TARGET_CALL_CONV_WIN;
             else {
                 printf("\nSee `%s --help`\n\n", argv[0]);
                 print_error(ERR_ARGS,
                             "Expected valid calling convention, got : `%s`",
                             argv[i]);
             }
+        } else if (strcmp(argv[i], "-cj") == 0 ||
+                   strcmp(argv[i], "--codegen-jobs") == 0) {
+            i = i + 1;
+            if (i >= argc) {
+                printf("\nSee `%s --help`\n\n", argv[0]);
+                print_error(ERR_ARGS, "Expected number of jobs after : `%s`",
+                            argv[i - 1]);
+            }
+            char *jobs_end = NULL;
+            long jobs = strtol(argv[i], &jobs_end, 10);
+            if (*jobs_end != '\0' || jobs < 1 || jobs > MAX_CODEGEN_JOBS) {
+                printf("\nSee `%s --help`\n\n", argv[0]);
+                print_error(ERR_ARGS,
+                            "Expected number of jobs in [1, %d], got : `%s`",
+                            MAX_CODEGEN_JOBS, argv[i]);
+            }
+            opts.codegen_jobs = jobs;
+        } else if (strcmp(argv[i], "-j") == 0 ||
+                   strcmp(argv[i], "--jobs") == 0) {
+            i = i + 1;
+            if (i >= argc) {
+                printf("\nSee `%s --help`\n\n", argv[0]);
+                print_error(ERR_ARGS, "Expected number of jobs after : `%s`",
+                            argv[i - 1]);
+            }
+            char *jobs_end = NULL;
+            long jobs = strtol(argv[i], &jobs_end, 10);
+            if (*jobs_end != '\0' || jobs < 1 || jobs > MAX_COMPILE_JOBS) {
+                printf("\nSee `%s --help`\n\n", argv[0]);
+                print_error(ERR_ARGS,
+                            "Expected number of jobs in [1, %d], got : `%s`",
+                            MAX_COMPILE_JOBS, argv[i]);
+            }
+            compile_jobs = jobs;
+        } else if (strcmp(argv[i], "-sv") == 0 ||
+                   strcmp(argv[i], "--server") == 0) {
+            i = i + 1;
+            if (i >= argc || *argv[i] == '-') {
+                printf("\nSee `%s --help`\n\n", argv[0]);
+                print_error(ERR_ARGS, "Expected socket path after : `%s`",
+                            argv[i - 1]);
+            }
+            server_sock = argv[i];
+        } else if (strcmp(argv[i], "-cl") == 0 ||
+                   strcmp(argv[i], "--client") == 0) {
+            i = i + 1;
+            if (i >= argc || *argv[i] == '-') {
+                printf("\nSee `%s --help`\n\n", argv[0]);
+                print_error(ERR_ARGS, "Expected socket path after : `%s`",
+                            argv[i - 1]);
+            }
+            client_sock = argv[i];
+        } else if (strcmp(argv[i], "-cd") == 0 ||
+                   strcmp(argv[i], "--cache-dir") == 0) {
+            i = i + 1;
+            if (i >= argc || *argv[i] == '-') {
+                printf("\nSee `%s --help`\n\n", argv[0]);
+                print_error(ERR_ARGS, "Expected cache directory after : `%s`",
+                            argv[i - 1]);
+            }
+            opts.cache_dir = argv[i];
+        } else if (strcmp(argv[i], "-cms") == 0 ||
+                   strcmp(argv[i], "--cache-max-size") == 0) {
+            i = i + 1;
+            if (i >= argc) {
+                printf("\nSee `%s --help`\n\n", argv[0]);
+                print_error(ERR_ARGS, "Expected size in MiB after : `%s`",
+                            argv[i - 1]);
+            }
+            char *size_end = NULL;
+            long size = strtol(argv[i], &size_end, 10);
+            if (*size_end != '\0' || size < 1 || size > MAX_CACHE_MIB) {
+                printf("\nSee `%s --help`\n\n", argv[0]);
+                print_error(ERR_ARGS,
+                            "Expected size in MiB in [1, %d], got : `%s`",
+                            MAX_CACHE_MIB, argv[i]);
+            }
+            opts.cache_max_size = (size_t)size * 1024 * 1024;
+        } else if (strcmp(argv[i], "-cs") == 0 ||
+                   strcmp(argv[i], "--cache-stats") == 0) {
+            opts.is_cache_stats = 1;
+        } else if (strcmp(argv[i], "-fc") == 0 ||
+                   strcmp(argv[i], "--func-cache") == 0) {
+            i = i + 1;
+            if (i >= argc || *argv[i] == '-') {
+                printf("\nSee `%s --help`\n\n", argv[0]);
+                print_error(ERR_ARGS, "Expected cache directory after : `%s`",
+                            argv[i - 1]);
+            }
+            opts.func_cache_dir = argv[i];
+        } else if (strcmp(argv[i], "-fcs") == 0 ||
+                   strcmp(argv[i], "--func-cache-stats") == 0) {
+            opts.is_func_cache_stats = 1;
+        } else if (strcmp(argv[i], "-tp") == 0 ||
+                   strcmp(argv[i], "--time-passes") == 0) {
+            opts.is_time_passes = 1;
+        } else if (strcmp(argv[i], "-tpf") == 0 ||
+                   strcmp(argv[i], "--time-passes-format") == 0) {
+            i = i + 1;
+            if (i >= argc || *argv[i] == '-') {
+                printf("\nSee `%s --help`\n\n", argv[0]);
+                print_error(ERR_ARGS, "Expected report format after : `%s`",
+                            argv[i - 1]);
+            }
+            if (strcmp(argv[i], "default") == 0 ||
+                strcmp(argv[i], "human") == 0)
+                opts.pass_report_fmt = PASS_REPORT_HUMAN;
+            else if (strcmp(argv[i], "json") == 0)
+                opts.pass_report_fmt = PASS_REPORT_JSON;
+            else {
+                printf("\nSee `%s --help`\n\n", argv[0]);
+                print_error(ERR_ARGS,
+                            "Expected valid report format, got : `%s`",
+                            argv[i]);
+            }
+            opts.is_time_passes = 1;
         } else if (strcmp(argv[i], "-V") == 0 ||
                    strcmp(argv[i], "--verbose") == 0) {
-            is_verbose = 1;
+            opts.is_verbose = 1;
+        } else if (strcmp(argv[i], "-st") == 0 ||
+                   strcmp(argv[i], "--stream") == 0) {
+            opts.is_stream = 1;
+        } else if (strcmp(argv[i], "-ms") == 0 ||
+                   strcmp(argv[i], "--mem-stats") == 0) {
+            opts.is_mem_stats = 1;
         } else if (strcmp(argv[i], "-v") == 0 ||
                    strcmp(argv[i], "--version") == 0) {
             printf("%s", VERSION_STRING);
@@ -130,11 +685,11 @@ int main(int argc, char **argv) {
                             argv[i]);
             }
             if (strcmp(argv[i], "default") == 0)
-                dialect = TARGET_ASM_DIALECT_DEFAULT;
+                opts.dialect = TARGET_ASM_DIALECT_DEFAULT;
             else if (strcmp(argv[i], "att") == 0)
-                dialect = TARGET_ASM_DIALECT_ATT;
+                opts.dialect = TARGET_ASM_DIALECT_ATT;
             else if (strcmp(argv[i], "intel") == 0)
-                dialect = TARGET_ASM_DIALECT_INTEL;
+                opts.dialect = TARGET_ASM_DIALECT_INTEL;
             else {
                 printf("\nSee `%s --help`\n\n", argv[0]);
                 print_error(ERR_ARGS,
@@ -142,71 +697,119 @@ int main(int argc, char **argv) {
                             argv[i]);
             }
         } else {
-            if (*argv[i] == '-') {
+            if (*argv[i] == '-' && strcmp(argv[i], "-") != 0) {
                 printf("\nSee `%s --help`\n\n", argv[0]);
                 print_error(ERR_ARGS,
                             "Expected valid argument got another possible "
                             "command line option : `%s`",
                             argv[i]);
             }
-            if (in_file_idx != -1)
-                print_warning(ERR_ARGS,
-                              "Got multiple source files,using latest : `%s`",
-                              argv[i]);
-            in_file_idx = i;
+            in_paths[in_count++] = argv[i];
         }
     }
 
-    // Allocate the AST Node for the whole program.
-    AstNode *program = node_alloc();
-    program->type = TYPE_PROGRAM;
-
-    ParsingContext *curr_context = create_default_parsing_context();
+    if (server_sock != NULL) {
+        if (in_count != 0 || client_sock != NULL)
+            print_error(ERR_ARGS, "Option `--server` takes no input files");
+        if (compile_jobs == 0)
+            compile_jobs = sysconf(_SC_NPROCESSORS_ONLN);
+        server_run(server_sock, compile_jobs > 0 ? compile_jobs : 1);
+        free(in_paths);
+        return 0;
+    }
 
-    // Open the file, lex and parse the file.
-    if (in_file_idx == -1)
+    if (in_count == 0)
         print_error(ERR_ARGS, "Expected valid input file path");
+    if (compile_jobs == 0)
+        compile_jobs = 1;
 
-    lex_and_parse(argv[in_file_idx], &curr_context, &program);
-
-    if (is_verbose == 1) {
-        print_ast_node(program, 0);
-        putchar('\n');
-        print_parsing_context(curr_context, 0);
-    }
-
-    // Type check the program.
-    type_check_prog(curr_context, program);
+    // A hit in the compile cache skips every phase, so there is nothing to
+    // report on them.
+    if (opts.cache_dir != NULL) {
+        if (opts.is_verbose == 1 || opts.is_mem_stats == 1 ||
+            opts.is_time_passes == 1 || opts.is_func_cache_stats == 1)
+            print_error(ERR_ARGS, "Options `-V`, `-ms`, `-tp`, and `-fcs` "
+                                  "can't be used with `--cache-dir`");
+        mkdir(opts.cache_dir, 0777);
+    } else if (opts.is_cache_stats == 1)
+        print_error(ERR_ARGS, "Option `-cs` takes a cache directory, passed "
+                              "with `--cache-dir`");
 
-    // Start Code generation.
-    if (is_verbose == 1)
-        printf("\n[+]CODE GENERATION BEGIN...\n");
+    // Streaming never holds the whole program, which the AST dump, the
+    // memory report, function bodies generated on workers, and the compile
+    // cache, that hashes the whole source up-front, all need.
+    if (opts.is_stream == 1 &&
+        (opts.is_verbose == 1 || opts.is_mem_stats == 1 ||
+         opts.codegen_jobs > 1 || opts.cache_dir != NULL))
+        print_error(ERR_ARGS, "Options `-V`, `-ms`, `-cj`, and `-cd` can't "
+                              "be used with `--stream`");
 
-    // If the output file name is not passed, use the input
-    // file name as the base name for the assembly file.
-    char *file_name = NULL;
-    if (out_file_idx == -1) {
-        file_name = strrchr(argv[in_file_idx], '/');
-        file_name += 1; // Skip the `/`.
-        int file_name_len = strlen(file_name);
+    // The client is a drop-in for compiling locally, except for the reports
+    // on how the compilation went, which are made by the server.
+    if (client_sock != NULL) {
+        if (opts.is_verbose == 1 || opts.is_mem_stats == 1 ||
+            opts.is_time_passes == 1 || opts.func_cache_dir != NULL ||
+            opts.is_func_cache_stats == 1 || opts.cache_dir != NULL ||
+            opts.is_stream == 1)
+            print_error(ERR_ARGS, "Options `-V`, `-ms`, `-tp`, `-fc`, `-fcs`, "
+                                  "`-cd`, and `-st` can't be used with "
+                                  "`--client`");
+        if (out_file_idx != -1 && in_count > 1)
+            print_error(ERR_ARGS, "Option `-o` takes a single input file");
 
-        // TODO: Input file extensions will also need to
-        // checked some time in the future to enforce proper usage.
+        int failed_count = compile_client(
+            &opts, client_sock, in_paths, in_count,
+            out_file_idx == -1 ? NULL : argv[out_file_idx]);
+        if (failed_count != 0)
+            print_error(ERR_COMMON, "%d of %d files failed to compile",
+                        failed_count, in_count);
+        free(in_paths);
+        return 0;
+    }
 
-        // Remove the last character of the extension, which
-        // should be `.sy` for sypher files.
-        file_name[file_name_len - 1] = '\0';
+    // Every input is compiled into its own default output file, and the
+    // reports, that are meant for a single compilation are left out.
+    if (in_count > 1) {
+        if (out_file_idx != -1 || opts.is_verbose == 1 ||
+            opts.is_mem_stats == 1 || opts.is_time_passes == 1 ||
+            opts.is_func_cache_stats == 1)
+            print_error(ERR_ARGS, "Options `-o`, `-V`, `-ms`, `-tp`, and "
+                                  "`-fcs` take a single input file");
 
-    } else
-        file_name = argv[out_file_idx];
+        FileCacheStats cache_stats = {0};
+        int failed_count = compile_batch(&opts, in_paths, in_count,
+                                         compile_jobs, &cache_stats);
+        if (opts.is_cache_stats == 1)
+            print_cache_stats(&opts, &cache_stats);
+        if (failed_count != 0)
+            print_error(ERR_COMMON, "%d of %d files failed to compile",
+                        failed_count, in_count);
+        free(in_paths);
+        return 0;
+    }
 
-    target_codegen(curr_context, program, file_name, out_fmt, dialect,
-                   call_conv);
+    // Every object created during the compilation comes from this arena,
+    // and is released in one go once the compilation is done.
+    Arena *arena = arena_create(0);
+    arena_set_current(arena);
 
-    if (is_verbose == 1)
-        printf("[+]CODE GENERATION COMPLETE\n");
+    char *out_path = out_file_idx == -1 ? default_out_path(in_paths[0])
+                                        : argv[out_file_idx];
+    SourceFile source;
+    FileCacheStats cache_stats = {0};
+    if (opts.is_stream == 1)
+        compile_file_stream(&opts, in_paths[0], out_path, arena, &source);
+    else
+        compile_file(&opts, in_paths[0], out_path, arena, &source,
+                     &cache_stats);
+    if (opts.is_cache_stats == 1)
+        print_cache_stats(&opts, &cache_stats);
+    if (out_file_idx == -1)
+        free(out_path);
+    free(in_paths);
 
-    free_node(program);
+    arena_destroy(arena);
+    intern_destroy();
 
     return 0;
 }
@@ -0,0 +1,150 @@
+#include "../inc/out_buf.h"
+#include "../inc/pass_stats.h"
+#include "../inc/utils.h"
+#include <errno.h>
+#include <unistd.h>
+
+// Pairs of decimal digits for every value in `[0, 100)`, so that integers
+// are formatted two digits at a time.
+static const char digit_pairs[201] = "00010203040506070809"
+                                     "10111213141516171819"
+                                     "20212223242526272829"
+                                     "30313233343536373839"
+                                     "40414243444546474849"
+                                     "50515253545556575859"
+                                     "60616263646566676869"
+                                     "70717273747576777879"
+                                     "80818283848586878889"
+                                     "90919293949596979899";
+
+static void out_sink_fd_write(void *sink_data, const char *data, size_t len) {
+    int fd = (int)(intptr_t)sink_data;
+    PassTimer timer;
+    pass_timer_start(&timer);
+    while (len > 0) {
+        ssize_t bytes_written = write(fd, data, len);
+        if (bytes_written < 0) {
+            if (errno == EINTR)
+                continue;
+            print_error(ERR_FILE_WRITE, "Unable to write generated code");
+        }
+        data += bytes_written;
+        len -= bytes_written;
+    }
+    pass_timer_stop(&timer, PASS_WRITE);
+}
+
+OutBuf *out_buf_create(OutSinkWrite sink_write, void *sink_data) {
+    OutBuf *out = (OutBuf *)calloc(1, sizeof(OutBuf));
+    CHECK_NULL(out, "Unable to allocate memory for an output buffer", NULL);
+    out->data = (char *)malloc(OUT_BUF_SIZE);
+    CHECK_NULL(out->data, "Unable to allocate memory for an output buffer",
+               NULL);
+    out->size = OUT_BUF_SIZE;
+    out->sink_write = sink_write;
+    out->sink_data = sink_data;
+    return out;
+}
+
+OutBuf *out_buf_create_fd(int fd) {
+    return out_buf_create(out_sink_fd_write, (void *)(intptr_t)fd);
+}
+
+OutBuf *out_buf_create_mem() { return out_buf_create(NULL, NULL); }
+
+void out_buf_make_room(OutBuf *out, size_t len) {
+    if (out->sink_write != NULL) {
+        out_buf_flush(out);
+        return;
+    }
+
+    size_t new_size = out->size;
+    while (new_size - out->used < len)
+        new_size *= 2;
+    out->data = (char *)realloc(out->data, new_size);
+    CHECK_NULL(out->data, "Unable to allocate memory for an output buffer",
+               NULL);
+    out->size = new_size;
+}
+
+void out_buf_int(OutBuf *out, int64_t val) {
+    char digits[OUT_INT_MAX_CHARS];
+    char *end = digits + sizeof(digits);
+    char *curr = end;
+
+    // Negate as unsigned, so that `INT64_MIN` doesn't overflow.
+    uint64_t abs_val = val < 0 ? -(uint64_t)val : (uint64_t)val;
+    while (abs_val >= 100) {
+        unsigned pair = (unsigned)(abs_val % 100) * 2;
+        abs_val /= 100;
+        *--curr = digit_pairs[pair + 1];
+        *--curr = digit_pairs[pair];
+    }
+    if (abs_val >= 10) {
+        *--curr = digit_pairs[abs_val * 2 + 1];
+        *--curr = digit_pairs[abs_val * 2];
+    } else
+        *--curr = '0' + abs_val;
+    if (val < 0)
+        *--curr = '-';
+
+    out_buf_write(out, curr, end - curr);
+}
+
+void out_buf_printf(OutBuf *out, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(out->data + out->used, out->size - out->used, fmt,
+                        args);
+    va_end(args);
+    if (len < 0)
+        print_error(ERR_DEV, "Invalid format passed to `out_buf_printf()`");
+
+    if ((size_t)len >= out->size - out->used) {
+        out_buf_make_room(out, len + 1);
+        if ((size_t)len >= out->size - out->used) {
+            // Too large for the buffer, format it on the side.
+            char *tmp = (char *)malloc(len + 1);
+            CHECK_NULL(tmp, "Unable to allocate memory for formatted output",
+                       NULL);
+            va_start(args, fmt);
+            vsnprintf(tmp, len + 1, fmt, args);
+            va_end(args);
+            out_buf_write(out, tmp, len);
+            free(tmp);
+            return;
+        }
+        va_start(args, fmt);
+        vsnprintf(out->data + out->used, out->size - out->used, fmt, args);
+        va_end(args);
+    }
+    out->used += len;
+}
+
+void out_buf_flush(OutBuf *out) {
+    if (out->sink_write == NULL || out->used == 0)
+        return;
+    out->sink_write(out->sink_data, out->data, out->used);
+    out->bytes_flushed += out->used;
+    out->flush_count += 1;
+    out->used = 0;
+}
+
+char *out_buf_release(OutBuf *out, size_t *len) {
+    if (out->sink_write != NULL)
+        print_error(ERR_DEV, "`out_buf_release()` called on a stream with a "
+                             "sink");
+    out_buf_char(out, '\0');
+    char *data = out->data;
+    *len = out->used - 1;
+    free(out);
+    return data;
+}
+
+void out_buf_destroy(OutBuf *out) {
+    if (out == NULL)
+        return;
+    out_buf_flush(out);
+    free(out->data);
+    free(out);
+}
@@ -1,18 +1,24 @@
 #include "../inc/parser.h"
+#include "../inc/arena.h"
 #include "../inc/ast_funcs.h"
 #include "../inc/env_funcs.h"
+#include "../inc/intern.h"
 #include "../inc/lexer.h"
+#include "../inc/type_table.h"
 #include "../inc/utils.h"
 
 int parse_int(LexedToken *token, AstNode *node) {
     if (token == NULL || node == NULL) {
         return 2;
     }
-    if (token->token_length == 1 && *(token->token_start) == '0') {
+    if (token->token_kind != TOKEN_INTEGER)
+        return 0;
+    char *token_str = lexed_token_str(token);
+    if (token->token_length == 1 && *token_str == '0') {
         node->type = TYPE_INT;
         node->ast_val.val = 0;
     } else {
-        long temp = strtol(token->token_start, NULL, 10);
+        long temp = strtol(token_str, NULL, 10);
         if (temp != 0) {
             node->type = TYPE_INT;
             node->ast_val.val = temp;
@@ -25,21 +31,18 @@ int parse_int(LexedToken *token, AstNode *node) {
 
 ParsingStack *create_parsing_stack(ParsingStack *parent_stack) {
     ParsingStack *new_stack = NULL;
-    new_stack = (ParsingStack *)calloc(1, sizeof(ParsingStack));
-    CHECK_NULL(new_stack, "Unable to allocate memory for new parsing stack",
-               NULL);
+    new_stack = (ParsingStack *)arena_calloc(sizeof(ParsingStack));
     new_stack->parent_stack = parent_stack;
     new_stack->op = NULL;
     new_stack->res = NULL;
     new_stack->body = NULL;
+    new_stack->outer_root = NULL;
     return new_stack;
 }
 
 ParsingContext *create_parsing_context(ParsingContext *parent_ctx) {
     ParsingContext *new_context = NULL;
-    new_context = (ParsingContext *)calloc(1, sizeof(ParsingContext));
-    CHECK_NULL(new_context, "Unable to allocate memory for new parsing context",
-               NULL);
+    new_context = (ParsingContext *)arena_calloc(sizeof(ParsingContext));
     new_context->child = NULL;
     new_context->next_child = NULL;
     new_context->parent_ctx = parent_ctx;
@@ -47,14 +50,35 @@ ParsingContext *create_parsing_context(ParsingContext *parent_ctx) {
     new_context->env_type = create_env(NULL);
     new_context->funcs = create_env(NULL);
     new_context->binary_ops = create_env(NULL);
+    new_context->global_ctx =
+        parent_ctx == NULL ? new_context : parent_ctx->global_ctx;
+    if (parent_ctx == NULL)
+        new_context->outer_vars_ctx = NULL;
+    else if (parent_ctx->vars->bind_count != 0)
+        new_context->outer_vars_ctx = parent_ctx;
+    else
+        new_context->outer_vars_ctx = parent_ctx->outer_vars_ctx;
+    new_context->depth = parent_ctx == NULL ? 0 : parent_ctx->depth + 1;
+    new_context->is_func_scope =
+        parent_ctx == NULL ? 0 : parent_ctx->is_func_scope;
+    new_context->op_ids = NULL;
+    new_context->op_ids_size = 0;
+    new_context->types = parent_ctx == NULL ? create_type_table() : NULL;
+    new_context->arena = arena_get_current();
     add_parsing_context_child(&parent_ctx, new_context);
     return new_context;
 }
 
 ParsingContext *create_default_parsing_context() {
+    // Make sure all the built-in names, and operators are interned before
+    // anything is parsed.
+    intern_init();
+
     ParsingContext *new_context = create_parsing_context(NULL);
-    AstNode *sym_node = create_node_symbol("int");
+    AstNode *sym_node = create_node_symbol(builtin_syms.int_type);
     ast_add_type_node(&new_context->env_type, TYPE_INT, sym_node, sizeof(long));
+    new_context->types->int_type = type_canon(new_context, sym_node);
+    new_context->types->none_type = type_canon(new_context, create_node_none());
 
     ast_add_binary_ops(&new_context, "==", 3, "int", "int", "int");
     ast_add_binary_ops(&new_context, "<", 3, "int", "int", "int");
@@ -93,6 +117,32 @@ void ast_add_type_node(Env **env_type, int node_type, AstNode *sym,
     }
 }
 
+// Maps the symbol of a built-in operator to its opcode, this only runs when
+// the operators are registered.
+static BinaryOp binary_op_from_sym(char *sym) {
+    if (sym == builtin_syms.op_eq)
+        return BIN_OP_EQ;
+    if (sym == builtin_syms.op_lt)
+        return BIN_OP_LT;
+    if (sym == builtin_syms.op_gt)
+        return BIN_OP_GT;
+    if (sym == builtin_syms.op_shl)
+        return BIN_OP_SHL;
+    if (sym == builtin_syms.op_shr)
+        return BIN_OP_SHR;
+    if (sym == builtin_syms.op_add)
+        return BIN_OP_ADD;
+    if (sym == builtin_syms.op_sub)
+        return BIN_OP_SUB;
+    if (sym == builtin_syms.op_mul)
+        return BIN_OP_MUL;
+    if (sym == builtin_syms.op_div)
+        return BIN_OP_DIV;
+    if (sym == builtin_syms.op_mod)
+        return BIN_OP_MOD;
+    return BIN_OP_NONE;
+}
+
 void ast_add_binary_ops(ParsingContext **context, char *bin_op, int precedence,
                         char *ret_type, char *lhs_type, char *rhs_type) {
     AstNode *node_sym_op = create_node_symbol(bin_op);
@@ -107,10 +157,7 @@ void ast_add_binary_ops(ParsingContext **context, char *bin_op, int precedence,
     add_ast_node_child(node_bin_op_body, node_lhs);
     add_ast_node_child(node_bin_op_body, node_rhs);
 
-    ParsingContext *temp = *context;
-
-    while (temp->parent_ctx != NULL)
-        temp = temp->parent_ctx;
+    ParsingContext *temp = (*context)->global_ctx;
 
     if (!set_env(&((temp)->binary_ops), node_sym_op, node_bin_op_body)) {
         print_error(ERR_COMMON,
@@ -118,6 +165,54 @@ void ast_add_binary_ops(ParsingContext **context, char *bin_op, int precedence,
                     "binary operator : `%s`",
                     node_sym_op->ast_val.node_symbol);
     }
+
+    BinaryOp op = binary_op_from_sym(node_sym_op->ast_val.node_symbol);
+    if (op == BIN_OP_NONE)
+        print_error(ERR_DEV, "No opcode for binary operator : `%s`",
+                    node_sym_op->ast_val.node_symbol);
+    temp->op_prec[op] = precedence;
+    temp->op_data[op] = node_bin_op_body;
+    temp->op_types[op][BIN_OP_TYPE_RET] = type_canon(temp, node_ret);
+    temp->op_types[op][BIN_OP_TYPE_LHS] = type_canon(temp, node_lhs);
+    temp->op_types[op][BIN_OP_TYPE_RHS] = type_canon(temp, node_rhs);
+
+    // Grow the opcode table, till the operator's id fits.
+    unsigned int op_id = intern_sym_id(node_sym_op->ast_val.node_symbol);
+    if (op_id >= temp->op_ids_size) {
+        unsigned int new_size = temp->op_ids_size * 2;
+        if (new_size <= op_id)
+            new_size = op_id + 1;
+        unsigned char *new_ids = (unsigned char *)arena_calloc(new_size);
+        if (temp->op_ids != NULL)
+            memcpy(new_ids, temp->op_ids, temp->op_ids_size);
+        temp->op_ids = new_ids;
+        temp->op_ids_size = new_size;
+    }
+    temp->op_ids[op_id] = op;
+}
+
+BinaryOp parser_get_binary_op(ParsingContext *context, unsigned int op_id) {
+    ParsingContext *global_ctx = context->global_ctx;
+    if (op_id >= global_ctx->op_ids_size)
+        return BIN_OP_NONE;
+    return global_ctx->op_ids[op_id];
+}
+
+const AstNode *parser_get_binary_op_data(ParsingContext *context, BinaryOp op) {
+    const AstNode *op_data = context->global_ctx->op_data[op];
+    if (op_data == NULL)
+        print_error(ERR_COMMON, "Couldn't find information for operator : %d",
+                    op);
+    return op_data;
+}
+
+AstNode *parser_get_binary_op_type(ParsingContext *context, BinaryOp op,
+                                   BinaryOpType which) {
+    AstNode *op_type = context->global_ctx->op_types[op][which];
+    if (op_type == NULL)
+        print_error(ERR_COMMON, "Couldn't find information for operator : %d",
+                    op);
+    return op_type;
 }
 
 void add_parsing_context_child(ParsingContext **root,
@@ -125,115 +220,76 @@ void add_parsing_context_child(ParsingContext **root,
     if (*root == NULL)
         return;
 
-    if ((*root)->child == NULL) {
-        if (*root == child_to_add) {
-            print_warning(ERR_DEV,
-                          "Could not add new child to the parsing context due"
-                          "to creation of possible circular linked list");
-            return;
-        }
+    if ((*root)->child == NULL)
         (*root)->child = child_to_add;
-        return;
-    }
+    else
+        (*root)->last_child->next_child = child_to_add;
+    (*root)->last_child = child_to_add;
+}
 
-    ParsingContext *temp_ctx = (*root)->child;
-    if (temp_ctx == child_to_add) {
-        print_warning(ERR_DEV,
-                      "Could not add new child to the parsing context due"
-                      "to creation of possible circular linked list");
-        return;
+void parser_verify_context(ParsingContext *context) {
+    // Two cursors, one moving twice as fast, meet only if the list loops.
+    ParsingContext *slow = context->child;
+    ParsingContext *fast = context->child;
+    while (fast != NULL && fast->next_child != NULL) {
+        slow = slow->next_child;
+        fast = fast->next_child->next_child;
+        if (slow == fast)
+            print_error(ERR_DEV, "Found a circular list of child contexts");
     }
-    while (temp_ctx->next_child != NULL) {
-        temp_ctx = temp_ctx->next_child;
-        if (temp_ctx == child_to_add) {
-            print_warning(ERR_DEV,
-                          "Could not add new child to the parsing context due"
-                          "to creation of possible circular linked list");
-            return;
-        }
+
+    for (ParsingContext *child = context->child; child != NULL;
+         child = child->next_child) {
+        if (child->parent_ctx != context)
+            print_error(ERR_DEV, "Found a child context with another parent");
+        if (child->next_child == NULL && child != context->last_child)
+            print_error(ERR_DEV, "Found a stale last child context");
+        parser_verify_context(child);
     }
-    temp_ctx->next_child = child_to_add;
 }
 
 int parse_binary_infix_op(LexingState **state, ParsingContext **context,
-                          long *running_precedence, AstNode **curr_expr,
-                          AstNode **running_expr, ParsingStack *curr_stack) {
-    LexingState temp_state = **state;
-    LexingState *temp_state_ptr = &temp_state;
-    lex_token(&temp_state_ptr);
-    AstNode *node_binary_op = NULL;
-
-    // While the end of a token isn't a white space character is a delimeter,
-    // and isn't a NULL terminator keep extending the token. This is done to
-    // catch multi-character operators.
-    char *token_end = (temp_state.curr_token->token_start +
-                       temp_state.curr_token->token_length);
-    while (*token_end != '\0' && strchr(WHITESPACE, *token_end) == NULL &&
-           strchr(DELIMS, *token_end) != NULL) {
-        token_end += 1;
-        temp_state.curr_token->token_length += 1;
-        temp_state.file_data += 1;
-    }
-    node_binary_op = node_symbol_from_token_create(temp_state.curr_token);
-    int stat = -1;
-    ParsingContext *global_ctx = *context;
-    while (global_ctx->parent_ctx != NULL)
-        global_ctx = global_ctx->parent_ctx;
-    AstNode *bin_op_val =
-        get_env(global_ctx->binary_ops, node_binary_op, &stat);
-    if (stat) {
-        **state = temp_state;
-        long temp_prec = bin_op_val->child->ast_val.val;
-        AstNode *node_bin_op_body = node_alloc();
-        node_bin_op_body->type = TYPE_BINARY_OPERATOR;
-        if (temp_prec <= *running_precedence) {
-            // `curr_expr` needs to change completely,
-            // and it needs to become a child of this new node, because
-            // we encountered something of lower precedence, and hence
-            // this node will have a binary operator node as a child.
-            AstNode *temp_curr_expr = *curr_expr;
-            if (curr_stack != NULL) {
-                *curr_expr = curr_stack->res;
-            }
+                          AstNode **expr_root, AstNode **running_expr) {
+    LexedToken *op_token = peek_token(*state);
+    if (op_token->token_kind != TOKEN_OPERATOR)
+        return 0;
+
+    BinaryOp op = parser_get_binary_op(*context, op_token->token_id);
+    if (op == BIN_OP_NONE)
+        return 0;
+    lex_token(state);
 
-            AstNode *temp_expr_copy = node_alloc();
-            copy_node(temp_expr_copy, *curr_expr);
-            add_ast_node_child(node_bin_op_body, temp_expr_copy);
-            node_bin_op_body->ast_val.node_symbol =
-                strdup(node_binary_op->ast_val.node_symbol);
-            node_bin_op_body->next_child = NULL;
-
-            AstNode *rhs_node = node_alloc();
-            add_ast_node_child(node_bin_op_body, rhs_node);
-
-            **curr_expr = *node_bin_op_body;
-            **running_expr = **curr_expr;
-            *running_expr = rhs_node;
-            if (curr_stack != NULL)
-                *curr_expr = temp_curr_expr;
-        } else {
-            // Here `running_expr` needs to change, and will store the
-            // value of the next integer that needs to be used for the
-            // operation based on the operator.
-            AstNode *temp_expr_copy = node_alloc();
-            copy_node(temp_expr_copy, *running_expr);
-            add_ast_node_child(node_bin_op_body, temp_expr_copy);
-            node_bin_op_body->ast_val.node_symbol =
-                strdup(node_binary_op->ast_val.node_symbol);
-            node_bin_op_body->next_child = NULL;
-
-            AstNode *rhs_node = node_alloc();
-            add_ast_node_child(node_bin_op_body, rhs_node);
-
-            **running_expr = *node_bin_op_body;
-            *running_expr = rhs_node;
-        }
-        *running_precedence = temp_prec;
-        return 1;
-    }
-    free(bin_op_val);
-    free(node_binary_op);
-    return 0;
+    long *op_prec = (*context)->global_ctx->op_prec;
+
+    // Operators along the right spine of the expression always have a
+    // strictly increasing precedence, so this walk is bounded by the number
+    // of precedence levels. The new operator takes over the first operand,
+    // whose operator doesn't bind tighter than itself.
+    AstNode *lhs_slot = *expr_root;
+    while (lhs_slot->type == TYPE_BINARY_OPERATOR &&
+           op_prec[lhs_slot->ast_val.val] < op_prec[op])
+        lhs_slot = lhs_slot->child->next_child;
+
+    // The slot is referred to by its parent, so the operand moves into a
+    // new node, and the slot becomes the operator, this way nothing below
+    // the operand is copied.
+    AstNode *lhs_node = node_alloc();
+    *lhs_node = *lhs_slot;
+    lhs_node->next_child = NULL;
+
+    AstNode *rhs_node = node_alloc();
+    lhs_node->next_child = rhs_node;
+
+    lhs_slot->type = TYPE_BINARY_OPERATOR;
+    lhs_slot->ast_val.val = op;
+    lhs_slot->ast_val.node_symbol = lexed_token_str(op_token);
+    lhs_slot->child = lhs_node;
+    lhs_slot->last_child = rhs_node;
+    lhs_slot->result_reg_desc = 0;
+    lhs_slot->pointer_level = 0;
+
+    *running_expr = rhs_node;
+    return 1;
 }
 
 void print_parsing_context(ParsingContext *context, int indent) {
@@ -279,66 +335,70 @@ void print_parsing_context(ParsingContext *context, int indent) {
     }
 }
 
-void lex_and_parse(char *file_dest, ParsingContext **curr_context,
+void lex_and_parse(char *file_data, ParsingContext **curr_context,
                    AstNode **program) {
 
-    char *file_data = read_file_data(file_dest);
-
-    char *temp_file_data = file_data;
-    temp_file_data += strspn(temp_file_data, WHITESPACE);
+    // The whole file is tokenized up-front, the parser then walks the
+    // tokens by index. The error trap frees them, if parsing fails.
+    size_t token_count = 0;
+    LexedToken *tokens = lex_file(file_data, &token_count);
 
-    LexedToken *root_token = NULL;
-    LexedToken *curr_token = root_token;
-
-    // The whole program will be tokenized and parsed into an
-    // AST which will be created from the curr_node.
+    // The whole program will be parsed into an AST which will be created
+    // from the curr_node.
     AstNode *curr_expr = NULL;
 
-    LexingState *state = calloc(1, sizeof(LexingState));
-    CHECK_NULL(state, "Could not allocate memory for LexingState", NULL);
-    state->file_data = temp_file_data;
-    state->curr_token = curr_token;
-
-    while (*temp_file_data != '\0') {
-        curr_expr = node_alloc();
+    LexingState *state = (LexingState *)arena_calloc(sizeof(LexingState));
+    state->file_data = file_data;
+    state->tokens = tokens;
+    state->token_idx = 0;
+    state->curr_token = NULL;
+    state->window = NULL;
 
-        temp_file_data = parse_tokens(state, &curr_expr, curr_context);
+    while ((curr_expr = parse_next_expr(state, curr_context)) != NULL) {
         if (curr_expr->type != TYPE_NULL)
             add_ast_node_child(*program, curr_expr);
-
-        free_node(curr_expr);
     }
 
-    free(file_data);
-    free(state->curr_token);
-    free(state);
+#ifdef SYPHERC_DEBUG
+    ast_verify(*program);
+    parser_verify_context((*curr_context)->global_ctx);
+#endif
+
+    err_trap_own(NULL);
+    free(tokens);
+}
+
+AstNode *parse_next_expr(LexingState *state, ParsingContext **curr_context) {
+    if (peek_token(state)->token_kind == TOKEN_EOF)
+        return NULL;
+
+    AstNode *curr_expr = node_alloc();
+    parse_tokens(state, &curr_expr, curr_context);
+    return curr_expr;
+}
+
+void parser_drop_child_contexts(ParsingContext *context) {
+    context->child = NULL;
+    context->last_child = NULL;
 }
 
 int check_if_delims(LexedToken *token) {
-    char *delims = DELIMS;
-    while (*delims != '\0') {
-        if (*token->token_start == *delims)
-            return 1;
-        delims++;
-    }
-    return 0;
+    return token->token_kind == TOKEN_OPERATOR ||
+           token->token_kind == TOKEN_PUNCTUATOR;
 }
 
 int check_invalid_var_access(ParsingContext *context, AstNode *sym_node) {
+    // Functions, and types are only bound in the root context.
+    ParsingContext *global_ctx = context->global_ctx;
     int status = -1;
-    ParsingContext *temp_ctx = context;
-    while (temp_ctx != NULL) {
-        status = -1;
-        get_env(temp_ctx->funcs, sym_node, &status);
-        if (status)
-            return 1;
-        get_env(temp_ctx->env_type, sym_node, &status);
-        if (status)
-            return 1;
-        temp_ctx = temp_ctx->parent_ctx;
-    }
-    if (strcmp(sym_node->ast_val.node_symbol, "else") == 0 ||
-        strcmp(sym_node->ast_val.node_symbol, "if") == 0)
+    get_env_ref(global_ctx->funcs, sym_node, &status);
+    if (status)
+        return 1;
+    get_env_ref(global_ctx->env_type, sym_node, &status);
+    if (status)
+        return 1;
+    if (sym_node->ast_val.node_symbol == builtin_syms.kw_else ||
+        sym_node->ast_val.node_symbol == builtin_syms.kw_if)
         return 1;
     return 0;
 }
@@ -351,8 +411,8 @@ void parse_func_vars(AstNode **function_type, LexingState **state,
     if (status == 0)
         print_error(ERR_SYNTAX, "Found invalid type in parameter list");
 
-    if (!check_next_token(":", state)) {
-        if (!check_next_token(")", state)) {
+    if (!check_next_token(builtin_syms.colon, state)) {
+        if (!check_next_token(builtin_syms.paren_close, state)) {
             print_error(ERR_SYNTAX,
                         "Type annotation must be followed with a `:` in"
                         "function parameter list");
@@ -364,21 +424,21 @@ void parse_func_vars(AstNode **function_type, LexingState **state,
     // Lex past the name, it should be stored in some context atleast!!
     lex_token(state);
 
-    if (check_next_token("(", state)) {
-        AstNode *func_type = create_node_symbol("function");
+    if (check_next_token(builtin_syms.paren_open, state)) {
+        AstNode *func_type = create_node_symbol(builtin_syms.function);
         // Add return type as a child.
         AstNode *func_return_type = node_alloc();
         copy_node(func_return_type, param_type);
         add_ast_node_child(func_type, func_return_type);
         for (;;) {
-            if (check_next_token(")", state))
+            if (check_next_token(builtin_syms.paren_close, state))
                 break;
 
             lex_token(state);
             parse_func_vars(function_type, state, context);
 
-            if (!check_next_token(",", state)) {
-                if (!check_next_token(")", state)) {
+            if (!check_next_token(builtin_syms.comma, state)) {
+                if (!check_next_token(builtin_syms.paren_close, state)) {
                     print_error(ERR_SYNTAX,
                                 "Parameter list for function definition"
                                 "must be delimited by a `,`");
@@ -394,7 +454,7 @@ void parse_func_vars(AstNode **function_type, LexingState **state,
 StackOpRetVal
 stack_operator_continue(ParsingStack **curr_stack, LexingState **state,
                         AstNode **running_expr, ParsingContext **context,
-                        long *running_precedence, AstNode **curr_expr) {
+                        AstNode **expr_root) {
     if (*curr_stack == NULL)
         return STACK_OP_BREAK;
 
@@ -404,14 +464,15 @@ stack_operator_continue(ParsingStack **curr_stack, LexingState **state,
     if (op == NULL || op->type != TYPE_SYM)
         print_error(ERR_COMMON, "Compiler - Context operator not a symbol");
 
-    if (strcmp(op->ast_val.node_symbol, "if-cond") == 0) {
+    if (op->ast_val.node_symbol == builtin_syms.if_cond) {
         valid_op = 1;
-        if (check_next_token("{", state)) {
+        if (check_next_token(builtin_syms.brace_open, state)) {
             AstNode *if_then_body = node_alloc();
+            if_then_body->scope = *context;
             (*curr_stack)->res->next_child = if_then_body;
             AstNode *if_expr_list = node_alloc();
             add_ast_node_child(if_then_body, if_expr_list);
-            if (check_next_token("}", state)) {
+            if (check_next_token(builtin_syms.brace_close, state)) {
                 *context = (*context)->parent_ctx;
                 *curr_stack = (*curr_stack)->parent_stack;
                 if (*curr_stack == NULL)
@@ -420,7 +481,8 @@ stack_operator_continue(ParsingStack **curr_stack, LexingState **state,
                     return STACK_OP_CONT_CHECK;
             }
             *running_expr = if_expr_list;
-            (*curr_stack)->op = create_node_symbol("if-then-body");
+            *expr_root = if_expr_list;
+            (*curr_stack)->op = create_node_symbol(builtin_syms.if_then_body);
             (*curr_stack)->res = *running_expr;
             (*curr_stack)->body = if_then_body;
             return STACK_OP_CONT_PARSE;
@@ -428,26 +490,29 @@ stack_operator_continue(ParsingStack **curr_stack, LexingState **state,
             print_error(ERR_SYNTAX, "Expected body after the `if` statement");
     }
 
-    if (strcmp(op->ast_val.node_symbol, "if-then-body") == 0) {
+    if (op->ast_val.node_symbol == builtin_syms.if_then_body) {
         valid_op = 1;
-        if (check_next_token("}", state)) {
+        if (check_next_token(builtin_syms.brace_close, state)) {
             // Move up a context, because 'if' is done.
             *context = (*context)->parent_ctx;
 
-            if (check_next_token("else", state)) {
-                if (check_next_token("{", state)) {
+            if (check_next_token(builtin_syms.kw_else, state)) {
+                if (check_next_token(builtin_syms.brace_open, state)) {
                     AstNode *if_else_body = node_alloc();
                     AstNode *if_expr_list = node_alloc();
                     add_ast_node_child(if_else_body, if_expr_list);
 
                     // Create a new context for 'else'.
                     *context = create_parsing_context(*context);
+                    if_else_body->scope = *context;
 
                     (*curr_stack)->body->next_child = if_else_body;
                     (*curr_stack)->body = if_else_body;
 
                     *running_expr = if_expr_list;
-                    (*curr_stack)->op = create_node_symbol("if-else-body");
+                    *expr_root = if_expr_list;
+                    (*curr_stack)->op =
+                        create_node_symbol(builtin_syms.if_else_body);
                     (*curr_stack)->res = *running_expr;
                     return STACK_OP_CONT_PARSE;
 
@@ -463,9 +528,9 @@ stack_operator_continue(ParsingStack **curr_stack, LexingState **state,
         }
     }
 
-    if (strcmp(op->ast_val.node_symbol, "if-else-body") == 0) {
+    if (op->ast_val.node_symbol == builtin_syms.if_else_body) {
         valid_op = 1;
-        if (check_next_token("}", state)) {
+        if (check_next_token(builtin_syms.brace_close, state)) {
             *context = (*context)->parent_ctx;
             *curr_stack = (*curr_stack)->parent_stack;
             if (*curr_stack == NULL)
@@ -475,9 +540,9 @@ stack_operator_continue(ParsingStack **curr_stack, LexingState **state,
         }
     }
 
-    if (strcmp(op->ast_val.node_symbol, "lambda_body") == 0) {
+    if (op->ast_val.node_symbol == builtin_syms.lambda_body) {
         valid_op = 1;
-        if (check_next_token("}", state)) {
+        if (check_next_token(builtin_syms.brace_close, state)) {
             *curr_stack = (*curr_stack)->parent_stack;
             *context = (*context)->parent_ctx;
             if (*curr_stack == NULL)
@@ -487,7 +552,7 @@ stack_operator_continue(ParsingStack **curr_stack, LexingState **state,
         }
     }
 
-    if (strcmp(op->ast_val.node_symbol, "lambda_params") == 0) {
+    if (op->ast_val.node_symbol == builtin_syms.lambda_params) {
         valid_op = 1;
         if ((*running_expr)->type != TYPE_VAR_DECLARATION)
             print_error(ERR_SYNTAX,
@@ -501,14 +566,14 @@ stack_operator_continue(ParsingStack **curr_stack, LexingState **state,
                 "Could not find type information for function parameter");
 
         add_ast_node_child(*running_expr, var_type);
-        if (check_next_token(")", state)) {
+        if (check_next_token(builtin_syms.paren_close, state)) {
 
             // Parse function body.
-            if (!check_next_token("{", state))
+            if (!check_next_token(builtin_syms.brace_open, state))
                 print_error(ERR_SYNTAX,
                             "Couldn't find body for function definition");
 
-            if (check_next_token("}", state)) {
+            if (check_next_token(builtin_syms.brace_close, state)) {
                 *context = (*context)->parent_ctx;
                 *curr_stack = (*curr_stack)->parent_stack;
                 if (*curr_stack == NULL)
@@ -517,37 +582,41 @@ stack_operator_continue(ParsingStack **curr_stack, LexingState **state,
                     return STACK_OP_CONT_CHECK;
             }
 
-            (*curr_stack)->op = create_node_symbol("lambda_body");
+            (*curr_stack)->op = create_node_symbol(builtin_syms.lambda_body);
             AstNode *func_body = node_alloc();
+            func_body->scope = *context;
             AstNode *func_expr = node_alloc();
             add_ast_node_child(func_body, func_expr);
             (*curr_stack)->body->next_child = func_body;
             (*curr_stack)->body = (*curr_stack)->body->next_child;
             (*curr_stack)->res = func_expr;
             *running_expr = func_expr;
+            *expr_root = func_expr;
             return STACK_OP_CONT_PARSE;
         } else {
             // Parse function params
-            if (!check_next_token(",", state))
+            if (!check_next_token(builtin_syms.comma, state))
                 print_error(ERR_SYNTAX, "Could not find end of parameter list "
                                         "in function definition");
         }
     }
 
-    if (strcmp(op->ast_val.node_symbol, "func_call") == 0) {
+    if (op->ast_val.node_symbol == builtin_syms.func_call) {
         valid_op = 1;
-        if (check_next_token(")", state)) {
+        if (check_next_token(builtin_syms.paren_close, state)) {
+            // The call is an operand of the expression it was found in.
             *running_expr = (*curr_stack)->res;
+            *expr_root = (*curr_stack)->outer_root;
             *curr_stack = (*curr_stack)->parent_stack;
-            if (parse_binary_infix_op(state, context, running_precedence,
-                                      curr_expr, running_expr, *curr_stack))
+            if (parse_binary_infix_op(state, context, expr_root, running_expr))
                 return STACK_OP_CONT_PARSE;
             return STACK_OP_CONT_CHECK;
-        } else if (strncmp_lexed_token((*state)->curr_token, ",") ||
-                   check_next_token(",", state)) {
+        } else if (lexed_token_is((*state)->curr_token, builtin_syms.comma) ||
+                   check_next_token(builtin_syms.comma, state)) {
             (*curr_stack)->res->next_child = node_alloc();
             (*curr_stack)->res = (*curr_stack)->res->next_child;
             *running_expr = (*curr_stack)->res;
+            *expr_root = *running_expr;
             return STACK_OP_CONT_PARSE;
         }
     }
@@ -558,24 +627,25 @@ stack_operator_continue(ParsingStack **curr_stack, LexingState **state,
     (*curr_stack)->res->next_child = node_alloc();
     (*curr_stack)->res = (*curr_stack)->res->next_child;
     *running_expr = (*curr_stack)->res;
+    *expr_root = *running_expr;
     return STACK_OP_CONT_PARSE;
 }
 
-AstNode *parse_type(AstNode **type_node, LexingState **state,
-                    ParsingContext *context, int *status) {
+const AstNode *parse_type(AstNode **type_node, LexingState **state,
+                          ParsingContext *context, int *status) {
     unsigned int pointer_indirect = 0;
-    while (*(((*state)->curr_token)->token_start) == '@') {
+    while (lexed_token_is((*state)->curr_token, builtin_syms.op_deref)) {
         pointer_indirect += 1;
         lex_token(state);
     }
 
     AstNode *sym_node = node_symbol_from_token_create((*state)->curr_token);
 
-    AstNode *res = parser_get_type(context, sym_node, status);
+    const AstNode *res = parser_get_type_ref(context, sym_node, status);
     if (*status == 0)
         return NULL;
 
-    if (check_next_token("[", state)) {
+    if (check_next_token(builtin_syms.bracket_open, state)) {
         lex_token(state);
 
         AstNode *arr_size = node_alloc();
@@ -583,17 +653,16 @@ AstNode *parse_type(AstNode **type_node, LexingState **state,
             print_error(ERR_SYNTAX,
                         "Unable to parse array size, expected valid integer");
 
-        if (!check_next_token("]", state))
+        if (!check_next_token(builtin_syms.bracket_close, state))
             print_error(ERR_SYNTAX,
                         "Expected `]` after declaration of array size");
 
-        AstNode *arr_type = create_node_symbol("array");
+        AstNode *arr_type = create_node_symbol(builtin_syms.array);
         AstNode *prev_type = node_alloc();
         copy_node(prev_type, sym_node);
         add_ast_node_child(arr_type, arr_size);
         add_ast_node_child(arr_type, prev_type);
         copy_node(sym_node, arr_type);
-        free(prev_type);
     }
 
     copy_node(*type_node, sym_node);
@@ -636,41 +705,40 @@ AstNode *parse_type(AstNode **type_node, LexingState **state,
     return res;
 }
 
-int check_if_type(char *temp_file_data, ParsingContext *context) {
-    LexingState temp_state;
-    temp_state.file_data = temp_file_data;
-    temp_state.curr_token = NULL;
+int check_if_type(LexingState *state, ParsingContext *context) {
+    // Peeking ahead only moves the index of a copy of the state.
+    LexingState temp_state = *state;
     LexingState *temp_state_ptr = &temp_state;
     lex_token(&temp_state_ptr);
-    while (strncmp_lexed_token(temp_state.curr_token, "@"))
+    while (lexed_token_is(temp_state.curr_token, builtin_syms.op_deref))
         lex_token(&temp_state_ptr);
     int stat = -1;
     AstNode *sym = node_symbol_from_token_create(temp_state.curr_token);
-    parser_get_type(context, sym, &stat);
+    parser_get_type_ref(context, sym, &stat);
     if (stat)
         return 1;
     return 0;
 }
 
-char *parse_tokens(LexingState *state, AstNode **curr_expr,
+void parse_tokens(LexingState *state, AstNode **curr_expr,
                    ParsingContext **context) {
 
     ParsingStack *curr_stack = NULL;
     AstNode *running_expr = *curr_expr;
-    long running_precedence = 0;
+    AstNode *expr_root = *curr_expr;
     for (;;) {
         lex_token(&state);
 
-        if (*state->curr_token->token_start == '\0')
-            return state->file_data;
+        if (state->curr_token->token_kind == TOKEN_EOF)
+            return;
 
         // Check if the current token is an integer.
         if (!parse_int(state->curr_token, running_expr)) {
             // If the token was not an integer, check if it is
             // variable declaration, assignment, etc.
 
-            if (strncmp_lexed_token(state->curr_token, "@") &&
-                !check_if_type(state->file_data, *context)) {
+            if (lexed_token_is(state->curr_token, builtin_syms.op_deref) &&
+                !check_if_type(state, *context)) {
                 AstNode *ptr_deref = node_alloc();
                 ptr_deref->type = TYPE_DEREFERENCE;
                 AstNode *ptr_child = node_alloc();
@@ -680,7 +748,7 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                 continue;
             }
 
-            if (strncmp_lexed_token(state->curr_token, "&")) {
+            if (lexed_token_is(state->curr_token, builtin_syms.op_addr)) {
                 AstNode *ptr_addr = node_alloc();
                 ptr_addr->type = TYPE_ADDROF;
                 AstNode *ptr_child = node_alloc();
@@ -690,7 +758,7 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                 continue;
             }
 
-            if (strncmp_lexed_token(state->curr_token, "if")) {
+            if (lexed_token_is(state->curr_token, builtin_syms.kw_if)) {
                 AstNode *if_node = node_alloc();
                 if_node->type = TYPE_IF_CONDITION;
 
@@ -699,11 +767,12 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
 
                 *running_expr = *if_node;
                 running_expr = if_expr;
+                expr_root = if_expr;
 
                 *context = create_parsing_context(*context);
 
                 curr_stack = create_parsing_stack(curr_stack);
-                curr_stack->op = create_node_symbol("if-cond");
+                curr_stack->op = create_node_symbol(builtin_syms.if_cond);
                 curr_stack->res = if_expr;
                 continue;
             }
@@ -720,12 +789,13 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
             int status = -1;
             char is_external = 0;
 
-            if (strncmp_lexed_token(state->curr_token, "ext")) {
+            if (lexed_token_is(state->curr_token, builtin_syms.kw_ext)) {
                 is_external = 1;
                 lex_token(&state);
             }
 
-            AstNode *res = parse_type(&type_node, &state, *context, &status);
+            const AstNode *res =
+                parse_type(&type_node, &state, *context, &status);
             if (status) {
                 AstNode *curr_var_decl = node_alloc();
                 curr_var_decl->type = TYPE_VAR_DECLARATION;
@@ -735,12 +805,12 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                 curr_type->type = res->type;
 
                 // Lex again to look forward.
-                if (check_next_token(":", &state)) {
-                    CHECK_END(*state->file_data,
+                if (check_next_token(builtin_syms.colon, &state)) {
+                    CHECK_END(peek_token(state)->token_kind,
                               "End of file during variable declaration", NULL);
 
                     // Handle lambda functions.
-                    if (check_next_token("(", &state)) {
+                    if (check_next_token(builtin_syms.paren_open, &state)) {
                         if (is_external)
                             print_error(ERR_SYNTAX,
                                         "`ext` keyword cannot be used with "
@@ -751,27 +821,33 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                         add_ast_node_child(lambda_func_node, type_node);
                         add_ast_node_child(lambda_func_node, arg_list);
 
-                        if (check_next_token(")", &state)) {
+                        if (check_next_token(builtin_syms.paren_close,
+                                             &state)) {
 
                             // Parse function body.
-                            if (!check_next_token("{", &state))
+                            if (!check_next_token(builtin_syms.brace_open,
+                                                  &state))
                                 print_error(ERR_SYNTAX,
                                             "Couldn't find body for function "
                                             "definition");
 
-                            if (check_next_token("}", &state)) {
+                            if (check_next_token(builtin_syms.brace_close,
+                                                 &state)) {
                                 *running_expr = *lambda_func_node;
                                 break;
                             }
 
                             *context = create_parsing_context(*context);
+                            (*context)->is_func_scope = 1;
                             curr_stack = create_parsing_stack(curr_stack);
-                            curr_stack->op = create_node_symbol("lambda_body");
+                            curr_stack->op =
+                                create_node_symbol(builtin_syms.lambda_body);
                             curr_stack->body = type_node;
                             curr_stack->body->next_child = arg_list;
                             curr_stack->body = curr_stack->body->next_child;
 
                             AstNode *func_body = node_alloc();
+                            func_body->scope = *context;
                             AstNode *func_expr = node_alloc();
                             add_ast_node_child(func_body, func_expr);
                             add_ast_node_child(lambda_func_node, func_body);
@@ -781,6 +857,7 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                             curr_stack->res = func_expr;
                             *running_expr = *lambda_func_node;
                             running_expr = func_expr;
+                            expr_root = func_expr;
                             continue;
                         }
 
@@ -788,9 +865,12 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                         add_ast_node_child(arg_list, curr_arg);
                         *running_expr = *lambda_func_node;
                         running_expr = curr_arg;
+                        expr_root = curr_arg;
                         *context = create_parsing_context(*context);
+                        (*context)->is_func_scope = 1;
                         curr_stack = create_parsing_stack(curr_stack);
-                        curr_stack->op = create_node_symbol("lambda_params");
+                        curr_stack->op =
+                            create_node_symbol(builtin_syms.lambda_params);
                         curr_stack->body = type_node;
                         curr_stack->body->next_child = arg_list;
                         curr_stack->body = curr_stack->body->next_child;
@@ -802,7 +882,7 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                         node_symbol_from_token_create(state->curr_token);
                     curr_sym->type = TYPE_SYM;
 
-                    get_env((*context)->vars, curr_sym, &status);
+                    get_env_ref((*context)->vars, curr_sym, &status);
                     if (status)
                         print_error(ERR_REDEFINITION,
                                     "Redefinition of variable : `%s`",
@@ -813,24 +893,28 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                     add_ast_node_child(curr_var_decl, curr_sym);
 
                     // Handling functions as variables.
-                    if (check_next_token("(", &state)) {
+                    if (check_next_token(builtin_syms.paren_open, &state)) {
                         AstNode *function_type = NULL;
                         if (is_external)
-                            function_type = create_node_symbol("ext function");
+                            function_type =
+                                create_node_symbol(builtin_syms.ext_function);
                         else
-                            function_type = create_node_symbol("function");
+                            function_type =
+                                create_node_symbol(builtin_syms.function);
                         // Add return type as a child.
                         add_ast_node_child(function_type, type_node);
 
                         for (;;) {
-                            if (check_next_token(")", &state))
+                            if (check_next_token(builtin_syms.paren_close,
+                                                 &state))
                                 break;
 
                             lex_token(&state);
                             parse_func_vars(&function_type, &state, *context);
 
-                            if (!check_next_token(",", &state)) {
-                                if (!check_next_token(")", &state)) {
+                            if (!check_next_token(builtin_syms.comma, &state)) {
+                                if (!check_next_token(builtin_syms.paren_close,
+                                                      &state)) {
                                     print_error(
                                         ERR_SYNTAX,
                                         "Parameter list for function definition"
@@ -840,60 +924,44 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                             }
                         }
 
-                        if (!set_env(&((*context)->vars), sym_name,
-                                     function_type)) {
-                            print_error(ERR_COMMON,
-                                        "Unable to set environment binding for "
-                                        "variable : `%s`",
-                                        sym_name->ast_val.node_symbol);
-                        }
-                    } else {
-                        if (!set_env(&((*context)->vars), sym_name,
-                                     type_node)) {
-                            print_error(ERR_COMMON,
-                                        "Unable to set environment binding for "
-                                        "variable : `%s`",
-                                        sym_name->ast_val.node_symbol);
-                        }
-                    }
+                        parser_declare_var(*context, sym_name, function_type);
+                    } else
+                        parser_declare_var(*context, sym_name, type_node);
+                    curr_sym->sym = sym_name->sym;
 
                     // Lex again to look forward.
-                    if (check_next_token(":", &state)) {
-                        CHECK_END(*state->file_data,
-                                  "End of file during variable declaration "
-                                  ": `%s`",
+                    if (check_next_token(builtin_syms.assign, &state)) {
+                        CHECK_END(peek_token(state)->token_kind,
+                                  "End of file during variable "
+                                  "declaration : `%s`",
                                   curr_sym->ast_val.node_symbol);
-                        if (check_next_token("=", &state)) {
-                            CHECK_END(*state->file_data,
-                                      "End of file during variable "
-                                      "declaration : `%s`",
-                                      curr_sym->ast_val.node_symbol);
-
-                            AstNode *var_reassign = node_alloc();
-                            var_reassign->type = TYPE_VAR_REASSIGNMENT;
-                            AstNode *new_val = node_alloc();
-                            AstNode *sym_name_copy = node_alloc();
-                            copy_node(sym_name_copy, sym_name);
-                            sym_name_copy->type = TYPE_VAR_ACCESS;
-                            add_ast_node_child(var_reassign, sym_name_copy);
-                            add_ast_node_child(var_reassign, new_val);
-
-                            curr_var_decl->next_child = var_reassign;
-
-                            *running_expr = *curr_var_decl;
-                            running_expr = new_val;
-                            if (curr_stack != NULL) {
-                                *curr_stack->res = *curr_var_decl;
-                                curr_stack->res = var_reassign;
-                            }
-                            continue;
+
+                        AstNode *var_reassign = node_alloc();
+                        var_reassign->type = TYPE_VAR_REASSIGNMENT;
+                        AstNode *new_val = node_alloc();
+                        AstNode *sym_name_copy = node_alloc();
+                        copy_node(sym_name_copy, sym_name);
+                        sym_name_copy->type = TYPE_VAR_ACCESS;
+                        add_ast_node_child(var_reassign, sym_name_copy);
+                        add_ast_node_child(var_reassign, new_val);
+
+                        curr_var_decl->next_child = var_reassign;
+
+                        *running_expr = *curr_var_decl;
+                        running_expr = new_val;
+                        expr_root = new_val;
+                        if (curr_stack != NULL) {
+                            *curr_stack->res = *curr_var_decl;
+                            curr_stack->res = var_reassign;
                         }
+                        continue;
+                    }
+                    if (check_next_token(builtin_syms.colon, &state))
                         print_error(ERR_SYNTAX,
                                     "Expected `=` after `:` in variable "
                                     "declaration for : `%s`",
                                     sym_name->ast_val.node_symbol);
-                    }
-                    if (check_next_token("=", &state))
+                    if (check_next_token(builtin_syms.equals, &state))
                         print_error(ERR_SYNTAX,
                                     "Expected `:` before `=` in variable "
                                     "declaration for : `%s`",
@@ -907,7 +975,7 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                         do {
                             stack_op_ret = stack_operator_continue(
                                 &curr_stack, &state, &running_expr, context,
-                                &running_precedence, curr_expr);
+                                &expr_root);
                         } while (stack_op_ret == STACK_OP_CONT_CHECK);
                         if (stack_op_ret == STACK_OP_CONT_PARSE)
                             continue;
@@ -924,7 +992,6 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                     print_error(ERR_SYNTAX,
                                 "Expected `:` after type declaration");
             }
-            free_node(res);
 
             if (is_external)
                 print_error(ERR_SYNTAX,
@@ -935,17 +1002,13 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
             // If the parsing flow reaches here, it means that we
             // can check a variable access.
             AstNode *node_var_access = NULL;
+            // The chain of contexts is searched once, the access, the
+            // re-assignment, and the call below all use the record found.
+            Symbol *var_sym = NULL;
             if (!check_if_delims(state->curr_token) &&
                 !check_invalid_var_access(*context, sym_node)) {
-                ParsingContext *temp_ctx = *context;
-                while (temp_ctx != NULL) {
-                    status = -1;
-                    get_env(temp_ctx->vars, sym_node, &status);
-                    if (status)
-                        break;
-                    temp_ctx = temp_ctx->parent_ctx;
-                }
-                if (status == 0)
+                var_sym = parser_resolve_var(*context, sym_node);
+                if (var_sym == NULL)
                     print_error(ERR_COMMON,
                                 "Undefined symbol :"
                                 "`%s`",
@@ -954,10 +1017,11 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                 node_var_access = node_alloc();
                 node_var_access->type = TYPE_VAR_ACCESS;
                 node_var_access->ast_val.node_symbol =
-                    strdup(sym_node->ast_val.node_symbol);
+                    sym_node->ast_val.node_symbol;
+                node_var_access->sym = var_sym;
                 *running_expr = *node_var_access;
 
-                if (check_next_token("[", &state)) {
+                if (check_next_token(builtin_syms.bracket_open, &state)) {
                     lex_token(&state);
                     AstNode *array_index = node_alloc();
 
@@ -967,7 +1031,7 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                                     "accessing array type : `%s`",
                                     node_var_access->ast_val.node_symbol);
 
-                    if (!check_next_token("]", &state))
+                    if (!check_next_token(builtin_syms.bracket_close, &state))
                         print_error(
                             ERR_SYNTAX,
                             "Expected `]` after indexing array type : `%s`",
@@ -982,85 +1046,75 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
             }
 
             // Lex again to look forward.
-            if (check_next_token(":", &state)) {
-                CHECK_END(*state->file_data,
+            if (check_next_token(builtin_syms.assign, &state)) {
+                CHECK_END(peek_token(state)->token_kind,
                           "End of file during variable re-assignment : `%s`",
                           sym_node->ast_val.node_symbol);
 
-                AstNode *var_bind = parser_get_var(*context, sym_node, &status);
-                if (status) {
+                if (var_sym != NULL) {
                     // re-assignment or redefinition (which is an error),
                     // otherwise invalid syntax error.
-
-                    // Lex again to look forward.
-                    if (check_next_token("=", &state)) {
-                        CHECK_END(*state->file_data,
-                                  "End of file during variable "
-                                  "re-assignment : `%s`",
-                                  sym_node->ast_val.node_symbol);
-
-                        AstNode *new_expr = node_alloc();
-                        AstNode *node_reassign = node_alloc();
-                        node_reassign->type = TYPE_VAR_REASSIGNMENT;
-
-                        AstNode *temp_expr = node_alloc();
-                        if (curr_stack == NULL)
-                            copy_node(temp_expr, *curr_expr);
-                        else
-                            copy_node(temp_expr, curr_stack->res);
-
-                        // VAR_ACCESS needs to be a child of dereference
-                        // (which is curr_expr).
-                        // TYPE_VAR_REASSIGNMENT needs to be at the top,
-                        // which means dereference is a child of this node.
-                        add_ast_node_child(node_reassign, temp_expr);
-
-                        // add_ast_node_child(node_reassign, sym_node);
-                        add_ast_node_child(node_reassign, new_expr);
-                        *running_expr = *node_reassign;
-                        running_expr = new_expr;
-                        if (curr_stack == NULL)
-                            **curr_expr = *node_reassign;
-                        else
-                            *curr_stack->res = *node_reassign;
-                        continue;
-
-                    } else {
-                        print_error(ERR_COMMON, "Undefined symbol after : `%s`",
-                                    sym_node->ast_val.node_symbol);
-                    }
+                    AstNode *new_expr = node_alloc();
+                    AstNode *node_reassign = node_alloc();
+                    node_reassign->type = TYPE_VAR_REASSIGNMENT;
+
+                    AstNode *temp_expr = node_alloc();
+                    if (curr_stack == NULL)
+                        copy_node(temp_expr, *curr_expr);
+                    else
+                        copy_node(temp_expr, curr_stack->res);
+
+                    // VAR_ACCESS needs to be a child of dereference
+                    // (which is curr_expr).
+                    // TYPE_VAR_REASSIGNMENT needs to be at the top,
+                    // which means dereference is a child of this node.
+                    add_ast_node_child(node_reassign, temp_expr);
+
+                    // add_ast_node_child(node_reassign, sym_node);
+                    add_ast_node_child(node_reassign, new_expr);
+                    *running_expr = *node_reassign;
+                    running_expr = new_expr;
+                    expr_root = new_expr;
+                    if (curr_stack == NULL)
+                        **curr_expr = *node_reassign;
+                    else
+                        *curr_stack->res = *node_reassign;
+                    continue;
                 } else
                     print_error(ERR_COMMON, "Undefined variable : `%s`",
                                 sym_node->ast_val.node_symbol);
-                free_node(var_bind);
             } else {
-                if (curr_stack == NULL && check_next_token("=", &state))
+                if (check_next_token(builtin_syms.colon, &state))
+                    print_error(ERR_COMMON, "Undefined symbol after : `%s`",
+                                sym_node->ast_val.node_symbol);
+                if (curr_stack == NULL &&
+                    check_next_token(builtin_syms.equals, &state))
                     print_error(ERR_SYNTAX,
                                 "Expected `:` before `=` in variable "
                                 "re-assignment of : `%s`",
                                 node_var_access->ast_val.node_symbol);
-                if (check_next_token("(", &state)) {
-                    status = -1;
-                    parser_get_var(*context, sym_node, &status);
-                    if (status) {
+                if (check_next_token(builtin_syms.paren_open, &state)) {
+                    if (var_sym != NULL) {
                         running_expr->type = TYPE_FUNCTION_CALL;
                         AstNode *var_func_name = node_alloc();
                         copy_node(var_func_name, sym_node);
                         var_func_name->type = TYPE_VAR_ACCESS;
+                        var_func_name->sym = var_sym;
                         add_ast_node_child(running_expr, var_func_name);
                         AstNode *arg_list = node_alloc();
 
-                        if (check_next_token(")", &state)) {
+                        if (check_next_token(builtin_syms.paren_close,
+                                             &state)) {
                             add_ast_node_child(running_expr, arg_list);
-                            if (parse_binary_infix_op(
-                                    &state, context, &running_precedence,
-                                    curr_expr, &running_expr, curr_stack))
+                            if (parse_binary_infix_op(&state, context,
+                                                      &expr_root,
+                                                      &running_expr))
                                 continue;
                             StackOpRetVal stack_op_ret = STACK_OP_INVALID;
                             do {
                                 stack_op_ret = stack_operator_continue(
                                     &curr_stack, &state, &running_expr, context,
-                                    &running_precedence, curr_expr);
+                                    &expr_root);
                             } while (stack_op_ret == STACK_OP_CONT_CHECK);
                             if (stack_op_ret == STACK_OP_CONT_PARSE)
                                 continue;
@@ -1078,8 +1132,11 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                         add_ast_node_child(running_expr, arg_list);
                         running_expr = curr_arg;
                         curr_stack = create_parsing_stack(curr_stack);
-                        curr_stack->op = create_node_symbol("func_call");
+                        curr_stack->op =
+                            create_node_symbol(builtin_syms.func_call);
                         curr_stack->res = running_expr;
+                        curr_stack->outer_root = expr_root;
+                        expr_root = curr_arg;
                         continue;
                     } else {
                         print_error(ERR_COMMON,
@@ -1091,8 +1148,7 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
             }
         }
 
-        if (parse_binary_infix_op(&state, context, &running_precedence,
-                                  curr_expr, &running_expr, curr_stack))
+        if (parse_binary_infix_op(&state, context, &expr_root, &running_expr))
             continue;
 
         if (curr_stack == NULL)
@@ -1101,8 +1157,7 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
         StackOpRetVal stack_op_ret = STACK_OP_INVALID;
         do {
             stack_op_ret = stack_operator_continue(
-                &curr_stack, &state, &running_expr, context,
-                &running_precedence, curr_expr);
+                &curr_stack, &state, &running_expr, context, &expr_root);
         } while (stack_op_ret == STACK_OP_CONT_CHECK);
         if (stack_op_ret == STACK_OP_CONT_PARSE)
             continue;
@@ -1114,5 +1169,4 @@ char *parse_tokens(LexingState *state, AstNode **curr_expr,
                 "Compiler Error - Stack operator not being handled correctly",
                 NULL, 0);
     }
-    return state->file_data;
 }
@@ -0,0 +1,110 @@
+#include "../inc/pass_stats.h"
+#include <string.h>
+
+_Thread_local PassStats pass_stats;
+
+static const char *pass_names[PASS_COUNT] = {
+    [PASS_READ] = "read",
+    [PASS_LEX_PARSE] = "lex & parse",
+    [PASS_TYPE_CHECK] = "type check",
+    [PASS_CODEGEN] = "code gen",
+    [PASS_WRITE] = "write",
+};
+
+static const char *pass_keys[PASS_COUNT] = {
+    [PASS_READ] = "read",
+    [PASS_LEX_PARSE] = "lex_parse",
+    [PASS_TYPE_CHECK] = "type_check",
+    [PASS_CODEGEN] = "codegen",
+    [PASS_WRITE] = "write",
+};
+
+static double elapsed_ms(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 +
+           (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+void pass_stats_reset() { memset(&pass_stats, 0, sizeof(pass_stats)); }
+
+void pass_stats_merge(const PassStats *src) {
+    pass_stats.tokens_lexed += src->tokens_lexed;
+    pass_stats.ast_nodes += src->ast_nodes;
+    pass_stats.env_lookups += src->env_lookups;
+    pass_stats.env_probes += src->env_probes;
+    pass_stats.copy_node_calls += src->copy_node_calls;
+    pass_stats.regs_allocated += src->regs_allocated;
+    pass_stats.insts_emitted += src->insts_emitted;
+    pass_stats.func_cache_hits += src->func_cache_hits;
+    pass_stats.func_cache_misses += src->func_cache_misses;
+}
+
+void pass_timer_start(PassTimer *timer) {
+    clock_gettime(CLOCK_MONOTONIC, &timer->wall_start);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &timer->cpu_start);
+}
+
+void pass_timer_stop(PassTimer *timer, Pass pass) {
+    struct timespec wall_end, cpu_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+    pass_stats.times[pass].wall_ms += elapsed_ms(&timer->wall_start, &wall_end);
+    pass_stats.times[pass].cpu_ms += elapsed_ms(&timer->cpu_start, &cpu_end);
+}
+
+void pass_stats_print(FILE *fptr, PassReportFormat format) {
+    PassTime times[PASS_COUNT];
+    memcpy(times, pass_stats.times, sizeof(times));
+    times[PASS_CODEGEN].wall_ms -= times[PASS_WRITE].wall_ms;
+    times[PASS_CODEGEN].cpu_ms -= times[PASS_WRITE].cpu_ms;
+
+    PassTime total = {0, 0};
+    for (int i = 0; i < PASS_COUNT; i++) {
+        total.wall_ms += times[i].wall_ms;
+        total.cpu_ms += times[i].cpu_ms;
+    }
+    double avg_probes = pass_stats.env_lookups == 0
+                            ? 0
+                            : (double)pass_stats.env_probes /
+                                  pass_stats.env_lookups;
+
+    if (format == PASS_REPORT_JSON) {
+        fprintf(fptr, "{\"passes\": {");
+        for (int i = 0; i < PASS_COUNT; i++)
+            fprintf(fptr, "\"%s\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f}, ",
+                    pass_keys[i], times[i].wall_ms, times[i].cpu_ms);
+        fprintf(fptr,
+                "\"total\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f}}, "
+                "\"counters\": {\"tokens_lexed\": %zu, \"ast_nodes\": %zu, "
+                "\"env_lookups\": %zu, \"env_avg_chain\": %.3f, "
+                "\"copy_node_calls\": %zu, \"regs_allocated\": %zu, "
+                "\"insts_emitted\": %zu, \"func_cache_hits\": %zu, "
+                "\"func_cache_misses\": %zu}}\n",
+                total.wall_ms, total.cpu_ms, pass_stats.tokens_lexed,
+                pass_stats.ast_nodes, pass_stats.env_lookups, avg_probes,
+                pass_stats.copy_node_calls, pass_stats.regs_allocated,
+                pass_stats.insts_emitted, pass_stats.func_cache_hits,
+                pass_stats.func_cache_misses);
+        return;
+    }
+
+    fprintf(fptr, "[+]PASS TIMES\n"
+                  "    pass          wall (ms)    cpu (ms)\n");
+    for (int i = 0; i < PASS_COUNT; i++)
+        fprintf(fptr, "    %-12s %10.3f  %10.3f\n", pass_names[i],
+                times[i].wall_ms, times[i].cpu_ms);
+    fprintf(fptr,
+            "    %-12s %10.3f  %10.3f\n"
+            "[+]COUNTERS\n"
+            "    tokens lexed    : %zu\n"
+            "    ast nodes       : %zu\n"
+            "    env lookups     : %zu, %.2f slots walked on average\n"
+            "    copy_node calls : %zu\n"
+            "    regs allocated  : %zu\n"
+            "    insts emitted   : %zu\n"
+            "    func cache      : %zu hits, %zu misses\n",
+            "total", total.wall_ms, total.cpu_ms, pass_stats.tokens_lexed,
+            pass_stats.ast_nodes, pass_stats.env_lookups, avg_probes,
+            pass_stats.copy_node_calls, pass_stats.regs_allocated,
+            pass_stats.insts_emitted, pass_stats.func_cache_hits,
+            pass_stats.func_cache_misses);
+}
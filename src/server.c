@@ -0,0 +1,238 @@
+#include "../inc/server.h"
+#include "../inc/task_pool.h"
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Set once the server has to stop, along with shutting down the listening
+// socket, so that a blocked `accept()` returns.
+static volatile sig_atomic_t server_stopping = 0;
+static volatile int server_listen_fd = -1;
+
+typedef struct ServerConn {
+    int fd;
+} ServerConn;
+
+static void server_stop(int sig) {
+    (void)sig;
+    server_stopping = 1;
+    if (server_listen_fd >= 0)
+        shutdown(server_listen_fd, SHUT_RDWR);
+}
+
+// Reads exactly `len` bytes, returns 1 once they are read, 0 if the peer
+// closed the connection before sending anything, and -1 otherwise.
+static int read_full(int fd, void *buf, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t ret = read(fd, (char *)buf + done, len - done);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return ret == 0 && done == 0 ? 0 : -1;
+        done += ret;
+    }
+    return 1;
+}
+
+// Writes exactly `len` bytes, returns 0 once they are written, and -1 on an
+// error. A peer that went away is an error, rather than a `SIGPIPE`.
+static int write_full(int fd, const void *buf, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t ret = send(fd, (const char *)buf + done, len - done,
+                           MSG_NOSIGNAL);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret < 0)
+            return -1;
+        done += ret;
+    }
+    return 0;
+}
+
+static void server_addr(const char *sock_path, struct sockaddr_un *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(sock_path) >= sizeof(addr->sun_path))
+        print_error(ERR_ARGS, "Socket path is too long : `%s`", sock_path);
+    strcpy(addr->sun_path, sock_path);
+}
+
+// Serves the requests on a connection, until the client closes it. Nothing
+// here may exit the process, a bad request only closes its connection.
+static void server_conn_task(void *conn_data) {
+    ServerConn *conn = (ServerConn *)conn_data;
+    char *src = NULL;
+    size_t src_size = 0;
+
+    ServerRequest req;
+    while (read_full(conn->fd, &req, sizeof(req)) == 1) {
+        if (req.magic != SERVER_MAGIC || req.src_len > SERVER_MAX_SRC_LEN)
+            break;
+        if (req.src_len + 1 > src_size) {
+            char *new_src = (char *)realloc(src, req.src_len + 1);
+            if (new_src == NULL)
+                break;
+            src = new_src;
+            src_size = req.src_len + 1;
+        }
+        if (read_full(conn->fd, src, req.src_len) != 1)
+            break;
+
+        SypherOptions opts = {
+            .out_fmt = (TargetFormat)req.out_fmt,
+            .call_conv = (TargetCallingConvention)req.call_conv,
+            .dialect = (TargetAssemblyDialect)req.dialect,
+            .codegen_jobs = (int)req.codegen_jobs,
+        };
+        SypherOutput out;
+        ServerResponse resp = {0};
+        resp.magic = SERVER_MAGIC;
+        resp.status = sypher_compile(src, req.src_len, &opts, &out);
+        resp.err = out.err;
+
+        const char *data = out.code;
+        resp.data_len = out.code_len;
+        if (resp.status != 0) {
+            data = out.err_msg;
+            resp.data_len = strlen(out.err_msg);
+        }
+        int is_sent = write_full(conn->fd, &resp, sizeof(resp)) == 0 &&
+                      write_full(conn->fd, data, resp.data_len) == 0;
+        sypher_output_free(&out);
+        if (!is_sent)
+            break;
+    }
+
+    free(src);
+    close(conn->fd);
+    free(conn);
+}
+
+void server_run(const char *sock_path, int jobs) {
+    struct sockaddr_un addr;
+    server_addr(sock_path, &addr);
+
+    // A socket left behind by a server that didn't stop cleanly is replaced,
+    // anything else at the path is left alone.
+    struct stat sock_stat;
+    if (stat(sock_path, &sock_stat) == 0 && S_ISSOCK(sock_stat.st_mode))
+        unlink(sock_path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+        print_error(ERR_COMMON, "Unable to create a socket");
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listen_fd, SERVER_BACKLOG) < 0)
+        print_error(ERR_FILE_OPEN, "Unable to listen on socket : `%s`",
+                    sock_path);
+
+    server_listen_fd = listen_fd;
+    struct sigaction stop_action;
+    memset(&stop_action, 0, sizeof(stop_action));
+    stop_action.sa_handler = server_stop;
+    sigemptyset(&stop_action.sa_mask);
+    sigaction(SIGINT, &stop_action, NULL);
+    sigaction(SIGTERM, &stop_action, NULL);
+
+    TaskPool *pool = task_pool_create(jobs);
+    fprintf(stderr, "[+]SERVING on `%s` with %d workers\n", sock_path, jobs);
+
+    struct timeval idle_timeout = {SERVER_IDLE_TIMEOUT, 0};
+    while (!server_stopping) {
+        int conn_fd = accept(listen_fd, NULL, NULL);
+        if (conn_fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if (!server_stopping)
+                print_warning(ERR_COMMON, "Unable to accept a connection");
+            break;
+        }
+        setsockopt(conn_fd, SOL_SOCKET, SO_RCVTIMEO, &idle_timeout,
+                   sizeof(idle_timeout));
+
+        ServerConn *conn = (ServerConn *)malloc(sizeof(ServerConn));
+        CHECK_NULL(conn, "Unable to allocate memory for %s", "a connection");
+        conn->fd = conn_fd;
+        task_pool_submit(pool, server_conn_task, conn);
+    }
+
+    server_listen_fd = -1;
+    close(listen_fd);
+    unlink(sock_path);
+
+    // Connections that are still open are served until their clients close
+    // them, or go idle.
+    task_pool_destroy(pool);
+    fprintf(stderr, "[+]STOPPED serving on `%s`\n", sock_path);
+}
+
+int server_connect(const char *sock_path) {
+    struct sockaddr_un addr;
+    server_addr(sock_path, &addr);
+
+    int sock_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock_fd < 0)
+        print_error(ERR_COMMON, "Unable to create a socket");
+    if (connect(sock_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        print_error(ERR_FILE_OPEN, "Unable to connect to the server : `%s`",
+                    sock_path);
+    return sock_fd;
+}
+
+int server_compile(int sock_fd, const char *src, size_t len,
+                   const SypherOptions *opts, SypherOutput *out) {
+    SypherOptions default_opts;
+    if (opts == NULL) {
+        sypher_options_default(&default_opts);
+        opts = &default_opts;
+    }
+    out->code = NULL;
+    out->code_len = 0;
+    out->err = ERR_COMMON;
+    out->err_msg[0] = '\0';
+
+    ServerRequest req = {
+        .magic = SERVER_MAGIC,
+        .out_fmt = opts->out_fmt,
+        .call_conv = opts->call_conv,
+        .dialect = opts->dialect,
+        .codegen_jobs = opts->codegen_jobs,
+        .reserved = 0,
+        .src_len = len,
+    };
+    if (write_full(sock_fd, &req, sizeof(req)) < 0 ||
+        write_full(sock_fd, src, len) < 0)
+        print_error(ERR_FILE_WRITE, "Unable to send a request to the server");
+
+    ServerResponse resp;
+    if (read_full(sock_fd, &resp, sizeof(resp)) != 1 ||
+        resp.magic != SERVER_MAGIC)
+        print_error(ERR_FILE_READ, "Unable to read a response from the server");
+
+    if (resp.status == 0) {
+        out->code = (char *)malloc(resp.data_len + 1);
+        CHECK_NULL(out->code, "Unable to allocate memory for %s",
+                   "the assembly");
+        if (resp.data_len != 0 &&
+            read_full(sock_fd, out->code, resp.data_len) != 1)
+            print_error(ERR_FILE_READ,
+                        "Unable to read the assembly from the server");
+        out->code[resp.data_len] = '\0';
+        out->code_len = resp.data_len;
+        return 0;
+    }
+
+    if (resp.data_len >= ERR_MSG_SIZE ||
+        (resp.data_len != 0 &&
+         read_full(sock_fd, out->err_msg, resp.data_len) != 1))
+        print_error(ERR_FILE_READ, "Unable to read the error from the server");
+    out->err_msg[resp.data_len] = '\0';
+    out->err = resp.err < ERR_COUNT ? (ErrType)resp.err : ERR_COMMON;
+    return -1;
+}
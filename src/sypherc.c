@@ -0,0 +1,90 @@
+#include "../inc/sypherc.h"
+#include "../inc/arena.h"
+#include "../inc/ast_funcs.h"
+#include "../inc/intern.h"
+#include "../inc/parser.h"
+#include "../inc/type_check.h"
+
+void sypher_options_default(SypherOptions *opts) {
+    opts->out_fmt = TARGET_FMT_DEFAULT;
+    opts->call_conv = TARGET_CALL_CONV_WIN;
+    opts->dialect = TARGET_ASM_DIALECT_DEFAULT;
+    opts->codegen_jobs = 1;
+    opts->func_cache_dir = NULL;
+}
+
+int sypher_compile(const char *src, size_t len, const SypherOptions *opts,
+                   SypherOutput *out) {
+    // The options are copied, so that nothing is assigned to `opts` before
+    // the setjmp() below.
+    SypherOptions run_opts;
+    if (opts != NULL)
+        run_opts = *opts;
+    else
+        sypher_options_default(&run_opts);
+    out->code = NULL;
+    out->code_len = 0;
+    out->err = ERR_COMMON;
+    out->err_msg[0] = '\0';
+
+    // Every object created during the compilation comes from this arena, the
+    // arena that was current on the calling thread is put back afterwards.
+    Arena *caller_arena = arena_get_current();
+    Arena *arena = arena_create(0);
+    arena_set_current(arena);
+
+    int ret = 0;
+    ErrTrap trap;
+    err_trap_push(&trap);
+    if (setjmp(trap.env) == 0) {
+        if (src == NULL)
+            print_error(ERR_ARGS, "NULL source passed to `sypher_compile()`");
+        if ((unsigned)run_opts.out_fmt >= TARGET_FMT_COUNT ||
+            (unsigned)run_opts.call_conv >= TARGET_CALL_CONV_COUNT ||
+            (unsigned)run_opts.dialect >= TARGET_ASM_DIALECT_COUNT)
+            print_error(ERR_ARGS,
+                        "Invalid target passed to `sypher_compile()`");
+        if (run_opts.codegen_jobs < 1 ||
+            run_opts.codegen_jobs > MAX_CODEGEN_JOBS)
+            print_error(ERR_ARGS,
+                        "Expected number of jobs in [1, %d], got : %d",
+                        MAX_CODEGEN_JOBS, run_opts.codegen_jobs);
+
+        // The lexer runs over a NULL terminated copy of the source.
+        char *file_data = (char *)arena_alloc(arena, len + 1);
+        memcpy(file_data, src, len);
+        file_data[len] = '\0';
+
+        AstNode *program = node_alloc();
+        program->type = TYPE_PROGRAM;
+        ParsingContext *context = create_default_parsing_context();
+        lex_and_parse(file_data, &context, &program);
+        type_check_prog(context, program);
+        out->code = target_codegen_mem(
+            context, program, &out->code_len, run_opts.out_fmt,
+            run_opts.dialect, run_opts.call_conv, run_opts.codegen_jobs,
+            run_opts.func_cache_dir);
+    } else {
+        ret = -1;
+        out->err = trap.err;
+        memcpy(out->err_msg, trap.msg, ERR_MSG_SIZE);
+    }
+    err_trap_pop(&trap);
+
+    arena_set_current(caller_arena);
+    arena_destroy(arena);
+
+    // Interned strings are kept for the next compilation on this thread,
+    // unless too many identifiers have piled up.
+    if (intern_count() > SYPHER_INTERN_KEEP_MAX)
+        intern_destroy();
+    return ret;
+}
+
+void sypher_release_thread() { intern_destroy(); }
+
+void sypher_output_free(SypherOutput *out) {
+    free(out->code);
+    out->code = NULL;
+    out->code_len = 0;
+}
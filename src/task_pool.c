@@ -0,0 +1,104 @@
+#include "../inc/task_pool.h"
+#include "../inc/arena.h"
+#include "../inc/utils.h"
+
+static void *task_pool_worker(void *pool_data) {
+    TaskPool *pool = (TaskPool *)pool_data;
+
+    // Everything a task allocates comes from the arena of its worker, so
+    // that workers never share an arena.
+    Arena *arena = arena_create(0);
+    arena_set_current(arena);
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->queue_head == NULL && !pool->is_stopping)
+            pthread_cond_wait(&pool->task_ready, &pool->lock);
+        if (pool->queue_head == NULL)
+            break;
+
+        Task *task = pool->queue_head;
+        pool->queue_head = task->next;
+        if (pool->queue_head == NULL)
+            pool->queue_tail = NULL;
+        pthread_mutex_unlock(&pool->lock);
+
+        task->func(task->task_data);
+        free(task);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->pending_count -= 1;
+        if (pool->pending_count == 0)
+            pthread_cond_broadcast(&pool->tasks_done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    arena_destroy(arena);
+    return NULL;
+}
+
+TaskPool *task_pool_create(int worker_count) {
+    if (worker_count < 1)
+        print_error(ERR_DEV, "Task pool needs at least one worker");
+
+    TaskPool *pool = (TaskPool *)calloc(1, sizeof(TaskPool));
+    CHECK_NULL(pool, "Unable to allocate memory for a task pool", NULL);
+    pool->workers = (pthread_t *)calloc(worker_count, sizeof(pthread_t));
+    CHECK_NULL(pool->workers, "Unable to allocate memory for a task pool",
+               NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->task_ready, NULL);
+    pthread_cond_init(&pool->tasks_done, NULL);
+
+    for (int i = 0; i < worker_count; i++) {
+        if (pthread_create(&pool->workers[i], NULL, task_pool_worker, pool))
+            print_error(ERR_COMMON, "Unable to start worker thread : %d", i);
+        pool->worker_count += 1;
+    }
+    return pool;
+}
+
+void task_pool_submit(TaskPool *pool, TaskFunc func, void *task_data) {
+    Task *task = (Task *)malloc(sizeof(Task));
+    CHECK_NULL(task, "Unable to allocate memory for a task", NULL);
+    task->func = func;
+    task->task_data = task_data;
+    task->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->queue_tail == NULL)
+        pool->queue_head = task;
+    else
+        pool->queue_tail->next = task;
+    pool->queue_tail = task;
+    pool->pending_count += 1;
+    pthread_cond_signal(&pool->task_ready);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void task_pool_wait(TaskPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending_count != 0)
+        pthread_cond_wait(&pool->tasks_done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void task_pool_destroy(TaskPool *pool) {
+    if (pool == NULL)
+        return;
+
+    task_pool_wait(pool);
+    pthread_mutex_lock(&pool->lock);
+    pool->is_stopping = 1;
+    pthread_cond_broadcast(&pool->task_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->worker_count; i++)
+        pthread_join(pool->workers[i], NULL);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->task_ready);
+    pthread_cond_destroy(&pool->tasks_done);
+    free(pool->workers);
+    free(pool);
+}
@@ -1,52 +1,18 @@
 #include "../inc/type_check.h"
 #include "../inc/ast_funcs.h"
 #include "../inc/env_funcs.h"
+#include "../inc/intern.h"
 #include "../inc/parser.h"
+#include "../inc/type_table.h"
 #include "../inc/utils.h"
 
-int cmp_type(AstNode *node1, AstNode *node2) {
-    if ((node1->type != node2->type) ||
-        (node1->pointer_level != node2->pointer_level))
-        return 0;
-    AstNode *temp_node1 = node1->child;
-    AstNode *temp_node2 = node2->child;
-    while (temp_node1 != NULL && temp_node2 != NULL) {
-        if (cmp_type(temp_node1, temp_node2) == 0)
-            return 0;
-        temp_node1 = temp_node1->next_child;
-        temp_node2 = temp_node2->next_child;
-    }
-    if (temp_node1 != NULL || temp_node2 != NULL)
-        return 0;
-    return 1;
-}
-
-int cmp_type_sym(AstNode *node1, AstNode *node2) {
-    if (node1->type != TYPE_SYM || node2->type != TYPE_SYM)
-        print_warning(ERR_COMMON,
-                      "Compairing symbols of nodes that aren't type TYPE_SYM");
-
-    if ((node1->type != node2->type) ||
-        (node1->pointer_level != node2->pointer_level) ||
-        ((node1->ast_val.node_symbol != NULL &&
-          node2->ast_val.node_symbol != NULL) &&
-         (strcmp(node1->ast_val.node_symbol, node2->ast_val.node_symbol) != 0)))
-        return 0;
-
-    AstNode *temp_node1 = node1->child;
-    AstNode *temp_node2 = node2->child;
-    while (temp_node1 != NULL && temp_node2 != NULL) {
-        if (cmp_type_sym(temp_node1, temp_node2) == 0)
-            return 0;
-        temp_node1 = temp_node1->next_child;
-        temp_node2 = temp_node2->next_child;
-    }
-    if (temp_node1 != NULL || temp_node2 != NULL)
-        return 0;
-    return 1;
-}
+// Types are canonical, so they are the same iff they are the same node.
+int cmp_type(AstNode *node1, AstNode *node2) { return node1 == node2; }
 
 void print_type(AstNode *expr, AstNode *expected_type, AstNode *got_type) {
+    // With a trap set, the caller gets the diagnostic, and owns stdout.
+    if (err_trap_is_set())
+        return;
     printf("\n\nEXPRESSION:\n");
     print_ast_node(expr, 0);
     if (expected_type != NULL) {
@@ -73,17 +39,24 @@ void print_type(AstNode *expr, AstNode *expected_type, AstNode *got_type) {
     print_ast_node(got_type, 0);
 }
 
-AstNode *type_check_expr(ParsingContext *context,
-                         ParsingContext **context_to_enter, AstNode *expr) {
+// Gets the size of a canonical type, for nodes that code generation
+// allocates, or indexes by.
+static long type_check_size(const AstNode *type) {
+    long size = type_size(type);
+    if (size < 0)
+        print_error(ERR_COMMON, "Couldn't find information for type : `%s`",
+                    type->ast_val.node_symbol);
+    return size;
+}
+
+AstNode *type_check_expr(ParsingContext *context, AstNode *expr) {
     AstNode *temp_expr = expr;
-    AstNode *ret_type = node_alloc();
-    int stat = -1;
+    AstNode *ret_type = NULL;
 
     switch (temp_expr->type) {
 
-    case TYPE_INT:;
-        AstNode *ret_int_type = create_node_symbol("int");
-        *ret_type = *ret_int_type;
+    case TYPE_INT:
+        ret_type = context->global_ctx->types->int_type;
         break;
 
     case TYPE_ARR_INDEX:
@@ -94,14 +67,9 @@ AstNode *type_check_expr(ParsingContext *context,
                 ERR_SYNTAX,
                 "Expected valid variable access while indexing an array");
         }
-        AstNode *arr_type =
-            type_check_expr(context, context_to_enter, temp_expr->child);
-        if (stat == 0)
-            print_error(ERR_COMMON,
-                        "Couldn't find information for variable : `%s`",
-                        temp_expr->ast_val.node_symbol);
+        AstNode *arr_type = type_check_expr(context, temp_expr->child);
 
-        if (strcmp("array", arr_type->ast_val.node_symbol))
+        if (arr_type->ast_val.node_symbol != builtin_syms.array)
             print_error(ERR_TYPE, "Expected array type for indexed access");
 
         if (temp_expr->ast_val.val < 0 ||
@@ -109,8 +77,8 @@ AstNode *type_check_expr(ParsingContext *context,
             print_error(ERR_TYPE,
                         "Encountered out of bound access for array : `%s`",
                         temp_expr->child->ast_val.node_symbol);
-        *ret_type = *arr_type->child->next_child;
-        // ret_type->pointer_level += 1;
+        ret_type = type_child(arr_type, 1);
+        temp_expr->val_size = type_check_size(ret_type);
         break;
 
     case TYPE_ADDROF:;
@@ -122,40 +90,24 @@ AstNode *type_check_expr(ParsingContext *context,
                 ERR_SYNTAX,
                 "Expected valid variable access for AddressOf operator");
         }
-        AstNode *var_access_type =
-            type_check_expr(context, context_to_enter, temp_expr->child);
-        *ret_type = *var_access_type;
-        ret_type->pointer_level += 1;
+        AstNode *var_access_type = type_check_expr(context, temp_expr->child);
+        ret_type = type_pointer(context, var_access_type, 1);
         break;
 
-    case TYPE_VAR_ACCESS:;
-        ParsingContext *temp_ctx = context;
-        AstNode *sym_type = NULL;
-        while (temp_ctx != NULL) {
-            sym_type = get_env_from_sym(temp_ctx->vars,
-                                        expr->ast_val.node_symbol, &stat);
-            if (stat)
-                break;
-            temp_ctx = temp_ctx->parent_ctx;
-            if (temp_ctx != NULL)
-                free_node(sym_type);
-        }
-        if (stat == 0)
+    case TYPE_VAR_ACCESS:
+        if (expr->sym == NULL)
             print_error(ERR_COMMON,
                         "Couldn't find information for variable : `%s`",
                         expr->ast_val.node_symbol);
-
-        *ret_type = *sym_type;
+        ret_type = expr->sym->type;
         break;
     case TYPE_DEREFERENCE:;
-        AstNode *deref_type =
-            type_check_expr(context, context_to_enter, temp_expr->child);
+        AstNode *deref_type = type_check_expr(context, temp_expr->child);
         if (deref_type->pointer_level == 0) {
             print_type(temp_expr, NULL, temp_expr->child);
             print_error(ERR_TYPE, "Only pointer types can be dereferenced");
         }
-        deref_type->pointer_level -= 1;
-        *ret_type = *deref_type;
+        ret_type = type_pointer(context, deref_type, -1);
         break;
     case TYPE_IF_CONDITION:;
         // The last expression of both the if-then body and the else body needs
@@ -163,20 +115,14 @@ AstNode *type_check_expr(ParsingContext *context,
         // the same type.
 
         // Type check the condition of the if statement.
-        AstNode *if_cond =
-            type_check_expr(context, context_to_enter, temp_expr->child);
-        free_node(if_cond);
-
-        ParsingContext *to_enter = (*context_to_enter)->child;
+        type_check_expr(context, temp_expr->child);
 
         // Type check the IF body.
-        AstNode *if_body_expr = temp_expr->child->next_child->child;
+        AstNode *if_body = temp_expr->child->next_child;
+        AstNode *if_body_expr = if_body->child;
         AstNode *if_expr_ret_type = NULL;
         while (if_body_expr != NULL) {
-            if_expr_ret_type =
-                type_check_expr(*context_to_enter, &to_enter, if_body_expr);
-            if (if_body_expr->next_child != NULL)
-                free_node(if_expr_ret_type);
+            if_expr_ret_type = type_check_expr(if_body->scope, if_body_expr);
             if_body_expr = if_body_expr->next_child;
         }
 
@@ -186,71 +132,52 @@ AstNode *type_check_expr(ParsingContext *context,
             print_error(ERR_TYPE, "No return type found for the last "
                                   "expression in the IF-THEN body");
 
-        (*context_to_enter) = (*context_to_enter)->next_child;
-
         // Check if there is a ELSE body, if so type check it, and compare the
         // last expressions of both the IF body and the ELSE body.
-        if (temp_expr->child->next_child->next_child != NULL) {
-            to_enter = (*context_to_enter)->child;
-            AstNode *else_body_expr =
-                temp_expr->child->next_child->next_child->child;
+        AstNode *else_body = if_body->next_child;
+        if (else_body != NULL) {
+            AstNode *else_body_expr = else_body->child;
             AstNode *else_expr_ret_type = NULL;
             while (else_body_expr != NULL) {
-                else_expr_ret_type = type_check_expr(*context_to_enter,
-                                                     &to_enter, else_body_expr);
-                if (else_body_expr->next_child != NULL)
-                    free_node(else_expr_ret_type);
+                else_expr_ret_type =
+                    type_check_expr(else_body->scope, else_body_expr);
                 else_body_expr = else_body_expr->next_child;
             }
-            (*context_to_enter) = (*context_to_enter)->next_child;
 
-            if (cmp_type_sym(if_expr_ret_type, else_expr_ret_type) == 0) {
+            if (cmp_type(if_expr_ret_type, else_expr_ret_type) == 0) {
                 print_type(temp_expr, if_expr_ret_type, else_expr_ret_type);
                 print_error(ERR_TYPE, "IF-THEN body and the ELSE body do not "
                                       "return the same type");
             }
         }
-        *ret_type = *if_expr_ret_type;
+        ret_type = if_expr_ret_type;
         break;
     case TYPE_FUNCTION:;
-        if (temp_expr->child->next_child->next_child->child) {
-            to_enter = (*context_to_enter)->child;
-            AstNode *function_body =
-                temp_expr->child->next_child->next_child->child;
+        AstNode *func_ret_type = type_canon(context, temp_expr->child);
+        AstNode *func_body = temp_expr->child->next_child->next_child;
+        if (func_body != NULL && func_body->child != NULL) {
+            AstNode *function_body = func_body->child;
             AstNode *expr_type = NULL;
             while (function_body != NULL) {
-                expr_type = type_check_expr(*context_to_enter, &to_enter,
-                                            function_body);
+                expr_type = type_check_expr(func_body->scope, function_body);
                 function_body = function_body->next_child;
-                if (function_body != NULL)
-                    free_node(expr_type);
             }
 
-            copy_node(ret_type, temp_expr->child);
-
-            if (stat == 0)
-                print_error(ERR_COMMON, "Couldn't find information for return "
-                                        "type of the function");
-            if (cmp_type_sym(expr_type, ret_type) == 0) {
-                print_type(temp_expr, ret_type, expr_type);
+            if (cmp_type(expr_type, func_ret_type) == 0) {
+                print_type(temp_expr, func_ret_type, expr_type);
                 print_error(ERR_TYPE, "Found Mismatched type for function "
                                       "return type and last expression");
             }
-            (*context_to_enter) = (*context_to_enter)->next_child;
         }
 
-        AstNode *func_type = create_node_symbol("function");
-
-        // Copy return type.
-        *ret_type = *func_type;
-        ret_type->child = node_alloc();
-        copy_node(ret_type->child, temp_expr->child);
+        // The type of the function is built out of the return, and parameter
+        // types, and then looked up in the canonical types.
+        AstNode *func_type = create_node_symbol(builtin_syms.function);
+        AstNode *func_type_ret = node_alloc();
+        copy_node(func_type_ret, temp_expr->child);
+        add_ast_node_child(func_type, func_type_ret);
 
-        // Copy parameter types.
         AstNode *param_types = temp_expr->child->next_child->child;
-        if (param_types == NULL)
-            break;
-
         while (param_types != NULL) {
             if (param_types->type != TYPE_VAR_DECLARATION)
                 print_error(ERR_TYPE, "Parameter list in function definition "
@@ -258,42 +185,31 @@ AstNode *type_check_expr(ParsingContext *context,
 
             AstNode *param_ret_type = node_alloc();
             copy_node(param_ret_type, param_types->child->next_child);
-            add_ast_node_child(ret_type, param_ret_type);
+            add_ast_node_child(func_type, param_ret_type);
             param_types = param_types->next_child;
         }
-
+        ret_type = type_canon(context, func_type);
         break;
     case TYPE_VAR_REASSIGNMENT:;
         // Get the return type of the left hand side of a variable declaration.
-        AstNode *lhs_ret_type =
-            type_check_expr(context, context_to_enter, temp_expr->child);
+        AstNode *lhs_ret_type = type_check_expr(context, temp_expr->child);
         // Get the return type of the left hand side of a variable declaration.
-        AstNode *rhs_ret_type = type_check_expr(context, context_to_enter,
-                                                temp_expr->child->next_child);
-        if (cmp_type_sym(lhs_ret_type, rhs_ret_type) == 0) {
+        AstNode *rhs_ret_type =
+            type_check_expr(context, temp_expr->child->next_child);
+        if (cmp_type(lhs_ret_type, rhs_ret_type) == 0) {
             print_type(temp_expr, lhs_ret_type, rhs_ret_type);
-            free_node(rhs_ret_type);
             print_error(ERR_TYPE,
                         "Mismatched types for variable re-assignment");
         }
         ret_type = lhs_ret_type;
-        free_node(rhs_ret_type);
         break;
     case TYPE_BINARY_OPERATOR:;
-        temp_ctx = context;
-        while (temp_ctx->parent_ctx != NULL)
-            temp_ctx = temp_ctx->parent_ctx;
-        AstNode *op_sym = create_node_symbol(temp_expr->ast_val.node_symbol);
-        AstNode *op_data = get_env(temp_ctx->binary_ops, op_sym, &stat);
-        if (!stat)
-            print_error(ERR_COMMON,
-                        "Couldn't find information for operator : `%s`",
-                        temp_expr->ast_val.node_symbol);
+        BinaryOp op = temp_expr->ast_val.val;
 
-        AstNode *op_used_lhs_type =
-            type_check_expr(context, context_to_enter, expr->child);
-        AstNode *op_decl_lhs_type = op_data->child->next_child->next_child;
-        if (cmp_type_sym(op_used_lhs_type, op_decl_lhs_type) == 0) {
+        AstNode *op_used_lhs_type = type_check_expr(context, expr->child);
+        AstNode *op_decl_lhs_type =
+            parser_get_binary_op_type(context, op, BIN_OP_TYPE_LHS);
+        if (cmp_type(op_used_lhs_type, op_decl_lhs_type) == 0) {
             print_type(temp_expr, op_decl_lhs_type, op_used_lhs_type);
             print_error(ERR_TYPE,
                         "Found Mismatched LHS type for operator : `%s`",
@@ -301,69 +217,52 @@ AstNode *type_check_expr(ParsingContext *context,
         }
 
         AstNode *op_used_rhs_type =
-            type_check_expr(context, context_to_enter, expr->child->next_child);
+            type_check_expr(context, expr->child->next_child);
         AstNode *op_decl_rhs_type =
-            op_data->child->next_child->next_child->next_child;
-        if (cmp_type_sym(op_used_rhs_type, op_decl_rhs_type) == 0) {
+            parser_get_binary_op_type(context, op, BIN_OP_TYPE_RHS);
+        if (cmp_type(op_used_rhs_type, op_decl_rhs_type) == 0) {
             print_type(temp_expr, op_decl_rhs_type, op_used_rhs_type);
             print_error(ERR_TYPE,
                         "Found Mismatched RHS type for operator : `%s`",
                         temp_expr->ast_val.node_symbol);
         }
 
-        free_node(op_sym);
-        free_node(op_data);
-        free_node(op_decl_lhs_type);
-        free_node(op_decl_rhs_type);
-        AstNode *op_decl_ret_type = op_data->child->next_child;
-        *ret_type = *op_decl_ret_type;
+        ret_type = parser_get_binary_op_type(context, op, BIN_OP_TYPE_RET);
         break;
     case TYPE_FUNCTION_CALL:;
-        AstNode *var_func_type =
-            parser_get_var(context, temp_expr->child, &stat);
-        if (!stat) {
+        if (temp_expr->child->sym == NULL) {
             print_error(ERR_COMMON,
                         "Function definition not found :"
                         "`%s`",
                         temp_expr->child->ast_val.node_symbol);
         }
+        AstNode *var_func_type = temp_expr->child->sym->type;
 
         // Make sure that the variable used is of FUNCTION type.
-        if (strcmp(var_func_type->ast_val.node_symbol, "function") != 0 &&
-            strcmp(var_func_type->ast_val.node_symbol, "ext function") != 0)
+        if (var_func_type->ast_val.node_symbol != builtin_syms.function &&
+            var_func_type->ast_val.node_symbol != builtin_syms.ext_function)
             print_error(ERR_TYPE,
                         "Called function must be of function type : `%s`",
                         temp_expr->child->ast_val.node_symbol);
 
-        AstNode *func_param_list = var_func_type->child->next_child;
+        // Parameter types follow the return type.
+        unsigned int param_idx = 1;
+        AstNode *func_param_list = type_child(var_func_type, param_idx);
         AstNode *func_call_params = temp_expr->child->next_child->child;
-        AstNode *param_list_type = NULL;
         AstNode *param_call_type = NULL;
         while (func_call_params != NULL && func_param_list != NULL) {
-            param_call_type =
-                type_check_expr(context, context_to_enter, func_call_params);
-
-            AstNode *complete_param_list_type = node_alloc();
-            copy_node(complete_param_list_type, func_param_list);
+            param_call_type = type_check_expr(context, func_call_params);
 
-            if (stat == 0)
-                print_error(
-                    ERR_COMMON, "Unable to find type information for : `%s`",
-                    func_param_list->child->next_child->ast_val.node_symbol);
             if (param_call_type->type == TYPE_NULL)
                 break;
-            if (cmp_type_sym(param_call_type, complete_param_list_type) == 0) {
-                print_type(temp_expr, complete_param_list_type,
-                           param_call_type);
+            if (cmp_type(param_call_type, func_param_list) == 0) {
+                print_type(temp_expr, func_param_list, param_call_type);
                 print_error(ERR_TYPE,
                             "Mismatched argument type for function call : `%s`",
                             temp_expr->child->ast_val.node_symbol);
             }
-            func_param_list = func_param_list->next_child;
+            func_param_list = type_child(var_func_type, ++param_idx);
             func_call_params = func_call_params->next_child;
-            free_node(complete_param_list_type);
-            free_node(param_call_type);
-            free_node(param_list_type);
         }
         if (func_param_list != NULL) {
             print_error(ERR_ARGS,
@@ -377,16 +276,25 @@ AstNode *type_check_expr(ParsingContext *context,
                         "`%s`",
                         temp_expr->child->ast_val.node_symbol);
         }
-        free_node(param_list_type);
-        stat = -1;
-        AstNode *final_function_return_type = node_alloc();
-        copy_node(final_function_return_type, var_func_type->child);
-        *ret_type = *final_function_return_type;
-        free_node(var_func_type);
+        // Code generation picks the calling convention by the type of the
+        // function.
+        temp_expr->child->val_type = var_func_type;
+        ret_type = type_child(var_func_type, 0);
         break;
     case TYPE_NULL:
         break;
-    case TYPE_VAR_DECLARATION:
+    case TYPE_VAR_DECLARATION:;
+        // The declaration itself has no value, the variable it declares is
+        // typed, and sized for code generation to allocate it.
+        AstNode *var_sym = temp_expr->child;
+        if (var_sym->sym == NULL)
+            print_error(ERR_COMMON,
+                        "Unable to find variable in environment : `%s`",
+                        var_sym->ast_val.node_symbol);
+        AstNode *var_type = var_sym->sym->type;
+        var_sym->val_type = var_type;
+        if (var_type->ast_val.node_symbol != builtin_syms.ext_function)
+            var_sym->val_size = type_check_size(var_type);
         break;
     default:
         print_warning(ERR_DEV,
@@ -394,16 +302,20 @@ AstNode *type_check_expr(ParsingContext *context,
         print_ast_node(temp_expr, 0);
         break;
     }
+
+    // Nodes without a value, still have a type, so that the last expression
+    // of a body can always be compared.
+    if (ret_type == NULL)
+        ret_type = context->global_ctx->types->none_type;
+    temp_expr->val_type = ret_type;
     return ret_type;
 }
 
 void type_check_prog(ParsingContext *context, AstNode *prog) {
     AstNode *temp_expr = prog->child;
 
-    ParsingContext *context_to_enter = context->child;
-
     while (temp_expr != NULL) {
-        type_check_expr(context, &context_to_enter, temp_expr);
+        type_check_expr(context, temp_expr);
         temp_expr = temp_expr->next_child;
     }
 }
@@ -0,0 +1,188 @@
+#include "../inc/type_table.h"
+#include "../inc/arena.h"
+#include "../inc/ast_funcs.h"
+#include "../inc/env_funcs.h"
+#include "../inc/intern.h"
+#include "../inc/utils.h"
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+#define POINTER_SIZE 8
+
+static uint64_t type_hash_word(uint64_t hash, uint64_t word) {
+    return (hash ^ word) * FNV_PRIME;
+}
+
+// Only the shape of a type is hashed, and compared. The value of a node is
+// part of it only for array sizes, the other nodes of a type have none.
+static uint64_t type_hash(const AstNode *type) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hash = type_hash_word(hash, type->type);
+    hash = type_hash_word(hash, (uintptr_t)type->ast_val.node_symbol);
+    hash = type_hash_word(hash, type->pointer_level);
+    if (type->type == TYPE_INT)
+        hash = type_hash_word(hash, type->ast_val.val);
+    for (const AstNode *child = type->child; child != NULL;
+         child = child->next_child)
+        hash = type_hash_word(hash, type_hash(child));
+    return hash;
+}
+
+static char type_equal(const AstNode *type1, const AstNode *type2) {
+    if (type1->type != type2->type ||
+        type1->ast_val.node_symbol != type2->ast_val.node_symbol ||
+        type1->pointer_level != type2->pointer_level ||
+        (type1->type == TYPE_INT && type1->ast_val.val != type2->ast_val.val))
+        return 0;
+
+    const AstNode *child1 = type1->child;
+    const AstNode *child2 = type2->child;
+    while (child1 != NULL && child2 != NULL) {
+        if (!type_equal(child1, child2))
+            return 0;
+        child1 = child1->next_child;
+        child2 = child2->next_child;
+    }
+    return child1 == NULL && child2 == NULL;
+}
+
+static CanonType **type_find_slot(TypeTable *table, const AstNode *type,
+                                  uint64_t hash) {
+    unsigned long idx = hash & (table->slots_size - 1);
+    while (table->slots[idx] != NULL &&
+           (table->slots[idx]->hash != hash ||
+            !type_equal(&table->slots[idx]->node, type)))
+        idx = (idx + 1) & (table->slots_size - 1);
+    return &table->slots[idx];
+}
+
+static void type_table_grow(TypeTable *table) {
+    CanonType **old_slots = table->slots;
+    unsigned long old_size = table->slots_size;
+    table->slots_size = old_size * 2;
+    table->slots =
+        (CanonType **)arena_calloc(table->slots_size * sizeof(CanonType *));
+
+    // Canonical types are all distinct, so they go into the first free slot.
+    for (unsigned long i = 0; i < old_size; i++) {
+        if (old_slots[i] == NULL)
+            continue;
+        unsigned long idx = old_slots[i]->hash & (table->slots_size - 1);
+        while (table->slots[idx] != NULL)
+            idx = (idx + 1) & (table->slots_size - 1);
+        table->slots[idx] = old_slots[i];
+    }
+}
+
+TypeTable *create_type_table() {
+    TypeTable *table = (TypeTable *)arena_calloc(sizeof(TypeTable));
+    table->slots_size = TYPE_TABLE_INIT_SLOTS;
+    table->slots =
+        (CanonType **)arena_calloc(table->slots_size * sizeof(CanonType *));
+    table->type_count = 0;
+    table->int_type = NULL;
+    table->none_type = NULL;
+    table->arena = arena_get_current();
+    return table;
+}
+
+// Works out the size of a new canonical type, whose children are canonical
+// already.
+static void type_set_size(ParsingContext *context, CanonType *canon) {
+    const AstNode *type = &canon->node;
+    canon->size = -1;
+    if (type->type != TYPE_SYM || type->ast_val.node_symbol == NULL)
+        return;
+
+    if (type->pointer_level > 0 ||
+        type->ast_val.node_symbol == builtin_syms.function ||
+        type->ast_val.node_symbol == builtin_syms.ext_function) {
+        canon->size = POINTER_SIZE;
+        return;
+    }
+
+    if (type->ast_val.node_symbol == builtin_syms.array) {
+        if (canon->child_count != 2 || canon->child_types[1]->size < 0)
+            print_error(ERR_TYPE, "Unable to find base type for array");
+        canon->size = canon->child_types[1]->size * type->child->ast_val.val;
+        return;
+    }
+
+    int stat = -1;
+    const AstNode *res = parser_get_type_ref(context, type, &stat);
+    if (!stat)
+        return;
+    canon->size = res->child->ast_val.val;
+}
+
+AstNode *type_canon(ParsingContext *context, const AstNode *type) {
+    TypeTable *table = context->global_ctx->types;
+    uint64_t hash = type_hash(type);
+    CanonType **slot = type_find_slot(table, type, hash);
+    if (*slot != NULL)
+        return &(*slot)->node;
+
+    // Canonical types outlive the expressions that first use them.
+    Arena *expr_arena = arena_get_current();
+    arena_set_current(table->arena);
+
+    CanonType *canon = (CanonType *)arena_calloc(sizeof(CanonType));
+    copy_node(&canon->node, type);
+    canon->node.next_child = NULL;
+    canon->hash = hash;
+
+    for (AstNode *child = canon->node.child; child != NULL;
+         child = child->next_child)
+        canon->child_count += 1;
+    canon->child_types =
+        (CanonType **)arena_calloc(canon->child_count * sizeof(CanonType *));
+    unsigned int idx = 0;
+    for (AstNode *child = canon->node.child; child != NULL;
+         child = child->next_child)
+        canon->child_types[idx++] = (CanonType *)type_canon(context, child);
+    type_set_size(context, canon);
+
+    // Children may have grown the table, so the slot is found again.
+    if ((table->type_count + 1) * 2 > table->slots_size)
+        type_table_grow(table);
+    *type_find_slot(table, type, hash) = canon;
+    table->type_count += 1;
+    arena_set_current(expr_arena);
+    return &canon->node;
+}
+
+AstNode *type_child(const AstNode *type, unsigned int idx) {
+    const CanonType *canon = (const CanonType *)type;
+    if (idx >= canon->child_count)
+        return NULL;
+    return &canon->child_types[idx]->node;
+}
+
+AstNode *type_pointer(ParsingContext *context, const AstNode *type,
+                      int levels) {
+    CanonType *canon = (CanonType *)type;
+    for (; levels > 0; levels--) {
+        if (canon->pointer_to == NULL) {
+            AstNode pointer_type = canon->node;
+            pointer_type.pointer_level += 1;
+            canon->pointer_to = (CanonType *)type_canon(context, &pointer_type);
+            canon->pointer_to->pointee = canon;
+        }
+        canon = canon->pointer_to;
+    }
+    for (; levels < 0; levels++) {
+        if (canon->node.pointer_level == 0)
+            print_error(ERR_DEV, "Dereferenced a type, that isn't a pointer");
+        if (canon->pointee == NULL) {
+            AstNode pointee_type = canon->node;
+            pointee_type.pointer_level -= 1;
+            canon->pointee = (CanonType *)type_canon(context, &pointee_type);
+            canon->pointee->pointer_to = canon;
+        }
+        canon = canon->pointee;
+    }
+    return &canon->node;
+}
+
+long type_size(const AstNode *type) { return ((const CanonType *)type)->size; }
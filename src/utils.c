@@ -1,38 +1,160 @@
 #include "../inc/utils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
 const char *err_strings[ERR_COUNT] = {
-    "GENERIC",   "ARGS",   "MEMORY ALLOCATION", "FILE ACCESS", "FILE SIZE",
-    "FILE READ", "SYNTAX", "REDEFINITION",      "EOF",         "TYPE",
-    "DEVELOPER"};
+    "GENERIC",      "ARGS",      "MEMORY ALLOCATION", "FILE ACCESS",
+    "FILE SIZE",    "FILE READ", "FILE WRITE",        "SYNTAX",
+    "REDEFINITION", "EOF",       "TYPE",              "DEVELOPER"};
+
+// Reads everything from `fd` into a growing buffer, this is used for
+// pipes, and `stdin` which can't be mapped.
+static void read_fd_data(int fd, char *file_dest, SourceFile *source) {
+    size_t buf_size = READ_CHUNK_SIZE;
+    size_t buf_used = 0;
+    char *buf = (char *)malloc(buf_size + 1);
+    CHECK_NULL(buf, "Unable to allocate memory for file contents", NULL);
+
+    for (;;) {
+        if (buf_used == buf_size) {
+            buf_size *= 2;
+            buf = (char *)realloc(buf, buf_size + 1);
+            CHECK_NULL(buf, "Unable to allocate memory for file contents",
+                       NULL);
+        }
+        ssize_t bytes_read = read(fd, buf + buf_used, buf_size - buf_used);
+        if (bytes_read < 0) {
+            if (errno == EINTR)
+                continue;
+            print_error(ERR_FILE_READ, "Unable to read file contents : `%s`",
+                        file_dest);
+        }
+        if (bytes_read == 0)
+            break;
+        buf_used += bytes_read;
+    }
+
+    buf[buf_used] = '\0';
+    source->file_data = buf;
+    source->file_size = buf_used;
+    source->map_size = 0;
+}
+
+// Maps `file_size` bytes of `fd`, the mapping is followed by at least one
+// zero filled byte. Bytes past the end of the file in its last page are
+// always zero, and when the file fills its last page, an anonymous page is
+// reserved behind it as the guard.
+static int map_fd_data(int fd, size_t file_size, SourceFile *source) {
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t map_size = (file_size + page_size) & ~(page_size - 1);
+
+    char *guard = (char *)mmap(NULL, map_size, PROT_READ,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (guard == MAP_FAILED)
+        return 0;
+
+    char *data = (char *)mmap(guard, file_size, PROT_READ,
+                              MAP_PRIVATE | MAP_FIXED, fd, 0);
+    if (data == MAP_FAILED) {
+        munmap(guard, map_size);
+        return 0;
+    }
+
+    source->file_data = data;
+    source->file_size = file_size;
+    source->map_size = map_size;
+    return 1;
+}
+
+void read_file_data(char *file_dest, SourceFile *source) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
-char *read_file_data(char *file_dest) {
-    FILE *file_ptr = NULL;
-    file_ptr = fopen(file_dest, "r");
-    if (file_ptr == NULL)
-        print_error(ERR_FILE_OPEN, "Unable to open file : `%s`", file_dest, 0);
+    source->drop_size = 0;
+    int is_stdin = strcmp(file_dest, "-") == 0;
+    int fd = is_stdin ? STDIN_FILENO : open(file_dest, O_RDONLY);
+    if (fd < 0)
+        print_error(ERR_FILE_OPEN, "Unable to open file : `%s`", file_dest);
 
-    size_t file_sz = calculate_file_size(file_ptr);
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) < 0)
+        print_error(ERR_FILE_SIZE, "Could not calculate file size : `%s`",
+                    file_dest);
 
-    char *file_data = NULL;
+    // Empty files can't be mapped, and are read like pipes instead.
+    if (!S_ISREG(file_stat.st_mode) || file_stat.st_size == 0 ||
+        !map_fd_data(fd, file_stat.st_size, source))
+        read_fd_data(fd, file_dest, source);
 
-    file_data = (char *)calloc((file_sz + 1), sizeof(char));
-    CHECK_NULL(file_data, "Unable to allocate memory for file contents", NULL);
+    if (!is_stdin)
+        close(fd);
 
-    size_t bytes_read = fread(file_data, 1, file_sz, file_ptr);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    source->read_ms = (end.tv_sec - start.tv_sec) * 1e3 +
+                      (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+void drop_file_data(SourceFile *source, size_t offset) {
+    if (source->map_size == 0)
+        return;
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t drop_size = offset & ~(page_size - 1);
+    if (drop_size <= source->drop_size)
+        return;
+    madvise(source->file_data + source->drop_size,
+            drop_size - source->drop_size, MADV_DONTNEED);
+    source->drop_size = drop_size;
+}
+
+void release_file_data(SourceFile *source) {
+    if (source->map_size != 0)
+        munmap(source->file_data, source->map_size);
+    else
+        free(source->file_data);
+    source->file_data = NULL;
+    source->file_size = 0;
+    source->map_size = 0;
+    source->drop_size = 0;
+}
+
+const char *build_id() { return __DATE__ " " __TIME__; }
 
-    if (bytes_read != file_sz)
-        print_error(ERR_FILE_READ, "Unable to read file contents : `%s`",
-                    file_dest, 0);
+// Innermost error trap set on the current thread.
+static _Thread_local ErrTrap *err_trap = NULL;
 
-    file_data[file_sz] = '\0';
-    fclose(file_ptr);
-    return file_data;
+void err_trap_push(ErrTrap *trap) {
+    trap->err = ERR_COMMON;
+    trap->msg[0] = '\0';
+    trap->owned_mem = NULL;
+    trap->prev = err_trap;
+    err_trap = trap;
 }
 
+void err_trap_pop(ErrTrap *trap) { err_trap = trap->prev; }
+
+void err_trap_own(void *mem) {
+    if (err_trap != NULL)
+        err_trap->owned_mem = mem;
+}
+
+char err_trap_is_set() { return err_trap != NULL; }
+
 NORETURN
 void print_error(ErrType err, const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
+    if (err_trap != NULL) {
+        err_trap->err = err;
+        vsnprintf(err_trap->msg, sizeof(err_trap->msg), fmt, args);
+        va_end(args);
+        free(err_trap->owned_mem);
+        err_trap->owned_mem = NULL;
+        longjmp(err_trap->env, 1);
+    }
     fprintf(stderr, "\033[1;31m[ERROR]\033[1;37m %s:: ", err_strings[err]);
     vfprintf(stderr, fmt, args);
     va_end(args);
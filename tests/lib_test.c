@@ -0,0 +1,110 @@
+/**
+ * @brief Test for the error paths of `sypher_compile()`, compiles sources,
+ *        that fail in the lexer, the parser, and the type checker, many
+ *        times over. Built with AddressSanitizer, so that memory left
+ *        behind by a failed compilation is reported as a leak on exit, and
+ *        the test fails. Nothing may be printed on stdout meanwhile.
+ *
+ *        Usage: lib_test [ROUNDS]
+ */
+
+#include "../inc/lexer.h"
+#include "../inc/sypherc.h"
+#include <unistd.h>
+
+#define LONG_SRC_TOKENS 20000
+
+typedef struct BadSource {
+    const char *name;
+    const char *src;
+    ErrType err;
+} BadSource;
+
+static const BadSource bad_sources[] = {
+    {"syntax", "int: f(int: a := int: (int: a) { a }\n", ERR_SYNTAX},
+    {"undefined", "int: x := 1\nx := f(x)\n", ERR_COMMON},
+    {"type", "int: x := 1\nx := &x\n", ERR_TYPE},
+    {"if type", "int: x := 1\nif x > 0 { x } else { &x }\n", ERR_TYPE},
+};
+
+#define BAD_SOURCE_COUNT (sizeof(bad_sources) / sizeof(bad_sources[0]))
+
+static const char good_src[] = "int: x := 1\nx := x + 2\nx\n";
+
+static int expect_error(const char *name, const char *src, size_t len,
+                        ErrType err) {
+    SypherOutput out;
+    if (sypher_compile(src, len, NULL, &out) == 0) {
+        fprintf(stderr, "[FAIL] %s : compiled without an error\n", name);
+        sypher_output_free(&out);
+        return 1;
+    }
+    if (out.err != err || out.code != NULL || out.err_msg[0] == '\0') {
+        fprintf(stderr, "[FAIL] %s : unexpected error %s : %s\n", name,
+                err_strings[out.err], out.err_msg);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    long rounds = 1000;
+    if (argc > 1)
+        rounds = strtol(argv[1], NULL, 10);
+
+    // Enough tokens to grow the token array, before a token, that is too
+    // long for the lexer.
+    size_t prefix_len = 2 * LONG_SRC_TOKENS;
+    size_t long_len = prefix_len + TOKEN_MAX_LENGTH + 1;
+    char *long_src = (char *)malloc(long_len + 1);
+    CHECK_NULL(long_src, "Unable to allocate memory for the source", NULL);
+    for (size_t i = 0; i < prefix_len; i++)
+        long_src[i] = i % 2 == 0 ? '1' : '\n';
+    memset(long_src + prefix_len, 'x', long_len - prefix_len);
+    long_src[long_len] = '\0';
+
+    // Diagnostics go back to the caller, nothing is printed on its stdout.
+    fflush(stdout);
+    int stdout_fd = dup(STDOUT_FILENO);
+    FILE *captured = tmpfile();
+    CHECK_NULL(captured, "Unable to create a temporary file", NULL);
+    dup2(fileno(captured), STDOUT_FILENO);
+
+    int fail_count = 0;
+    for (long i = 0; i < rounds; i++) {
+        for (size_t k = 0; k < BAD_SOURCE_COUNT; k++)
+            fail_count += expect_error(bad_sources[k].name, bad_sources[k].src,
+                                       strlen(bad_sources[k].src),
+                                       bad_sources[k].err);
+        if (i % 100 == 0)
+            fail_count +=
+                expect_error("lexer", long_src, long_len, ERR_SYNTAX);
+        if (fail_count != 0)
+            break;
+    }
+    free(long_src);
+
+    fflush(stdout);
+    dup2(stdout_fd, STDOUT_FILENO);
+    close(stdout_fd);
+    long printed = lseek(fileno(captured), 0, SEEK_END);
+    fclose(captured);
+    if (printed != 0) {
+        fprintf(stderr, "[FAIL] %ld bytes printed on stdout\n", printed);
+        fail_count += 1;
+    }
+
+    // A failed compilation leaves nothing behind, for the next one.
+    SypherOutput out;
+    if (sypher_compile(good_src, sizeof(good_src) - 1, NULL, &out) != 0) {
+        fprintf(stderr, "[FAIL] good : %s\n", out.err_msg);
+        fail_count += 1;
+    } else
+        sypher_output_free(&out);
+    sypher_release_thread();
+
+    if (fail_count != 0)
+        return 1;
+    printf("[PASS] %ld rounds of failed compilations\n", rounds);
+    return 0;
+}